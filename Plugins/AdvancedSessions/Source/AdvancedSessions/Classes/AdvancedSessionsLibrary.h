@@ -132,6 +132,53 @@ public:
 		static void GetSessionPropertyFloat(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, float &SettingValue);
 
 
+		//******* Indexed session properties *********//
+
+		// Builds a keyed view of a session's properties, use it when reading several properties from the same session
+		UFUNCTION(BlueprintPure, Category = "Online|AdvancedSessions|SessionInfo|Indexed")
+		static FBPSessionPropertyIndex MakeSessionPropertyIndex(const FBlueprintSessionResult& SessionResult);
+
+		// Builds a keyed view from an ExtraSettings array, later entries win if a key repeats
+		UFUNCTION(BlueprintPure, Category = "Online|AdvancedSessions|SessionInfo|Indexed")
+		static FBPSessionPropertyIndex MakeSessionPropertyIndexFromArray(const TArray<FSessionPropertyKeyPair>& ExtraSettings);
+
+		// Builds one keyed view per session result, in the same order
+		UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|SessionInfo|Indexed")
+		static void MakeSessionPropertyIndices(const TArray<FBlueprintSessionResult>& SessionResults, TArray<FBPSessionPropertyIndex>& Indices);
+
+		// Find session property by Name in a keyed view
+		UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|SessionInfo|Indexed", meta = (ExpandEnumAsExecs = "Result"))
+		static void FindIndexedSessionProperty(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, EBlueprintResultSwitch &Result, FSessionPropertyKeyPair& OutProperty);
+
+		// Get session custom information key/value as Byte (For Enums) from a keyed view
+		UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|SessionInfo|Indexed", meta = (ExpandEnumAsExecs = "SearchResult"))
+		static void GetIndexedSessionPropertyByte(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, uint8 &SettingValue);
+
+		// Get session custom information key/value as Bool from a keyed view
+		UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|SessionInfo|Indexed", meta = (ExpandEnumAsExecs = "SearchResult"))
+		static void GetIndexedSessionPropertyBool(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, bool &SettingValue);
+
+		// Get session custom information key/value as String from a keyed view
+		UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|SessionInfo|Indexed", meta = (ExpandEnumAsExecs = "SearchResult"))
+		static void GetIndexedSessionPropertyString(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, FString &SettingValue);
+
+		// Get session custom information key/value as Int from a keyed view
+		UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|SessionInfo|Indexed", meta = (ExpandEnumAsExecs = "SearchResult"))
+		static void GetIndexedSessionPropertyInt(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, int32 &SettingValue);
+
+		// Get session custom information key/value as Float from a keyed view
+		UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|SessionInfo|Indexed", meta = (ExpandEnumAsExecs = "SearchResult"))
+		static void GetIndexedSessionPropertyFloat(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, float &SettingValue);
+
+		// Returns the indices of every session result that passes all filters, sessions missing a filtered key pass that filter like FilterSessionResults
+		// Nothing is copied, so this is the one to use when filtering a large browser list every frame
+		UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|SessionInfo|Indexed")
+		static void FilterSessionResultIndices(const TArray<FBlueprintSessionResult>& SessionResults, const TArray<FSessionsSearchSetting>& Filters, TArray<int32>& MatchingIndices);
+
+		// Checks a single session result against the filters, shared by the bulk filters
+		static bool SessionPassesFilters(const FBlueprintSessionResult& SessionResult, const TArray<FSessionsSearchSetting>& Filters);
+
+
 		// Make a literal session custom information key/value pair from Byte (For Enums)
 		UFUNCTION(BlueprintPure, Category = "Online|AdvancedSessions|SessionInfo|Literals")
 		static FSessionPropertyKeyPair MakeLiteralSessionPropertyByte(FName Key, uint8 Value);
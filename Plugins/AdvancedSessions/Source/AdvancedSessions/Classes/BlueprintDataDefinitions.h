@@ -330,6 +330,20 @@ struct FSessionsSearchSetting
 	FSessionPropertyKeyPair PropertyKeyPair;
 };
 
+// Session properties hashed by key, build once per result and query it instead of scanning the ExtraSettings array for every property
+USTRUCT(BlueprintType)
+struct FBPSessionPropertyIndex
+{
+	GENERATED_USTRUCT_BODY()
+
+	TMap<FName, FVariantData> Properties;
+
+	const FVariantData* Find(FName Key) const
+	{
+		return Properties.Find(Key);
+	}
+};
+
 // Couldn't use the default one as it is not exposed to other modules, had to re-create it here
 // Helper class for various methods to reduce the call hierarchy
 struct FOnlineSubsystemBPCallHelperAdvanced
@@ -7,6 +7,8 @@
 #include "BlueprintDataDefinitions.h"
 #include "FindSessionsCallbackProxyAdvanced.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FBlueprintSessionResultsChangedDelegate, const TArray<FBlueprintSessionResult>&, Added, const TArray<FBlueprintSessionResult>&, Removed);
+
 UCLASS(MinimalAPI)
 class UFindSessionsCallbackProxyAdvanced : public UOnlineBlueprintCallProxyBase
 {
@@ -20,9 +22,22 @@ class UFindSessionsCallbackProxyAdvanced : public UOnlineBlueprintCallProxyBase
 	UPROPERTY(BlueprintAssignable)
 	FBlueprintFindSessionsResultDelegate OnFailure;
 
+	// Called as soon as each search phase returns with only the sessions not seen in an earlier phase, before OnSuccess has the full list
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintFindSessionsResultDelegate OnResultsBatch;
+
+	// Called after cached results were returned and the background refresh found sessions that appeared or went away
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintSessionResultsChangedDelegate OnCacheRefreshed;
+
 	// Searches for advertised sessions with the default online subsystem and includes an array of filters
+	// CacheTTLSeconds - Results of the same search found less than this long ago are returned straight away and refreshed in the background once half way to expiring, 0 always searches
 	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", AutoCreateRefTerm="Filters"), Category = "Online|AdvancedSessions")
-	static UFindSessionsCallbackProxyAdvanced* FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int32 MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly = false, bool bNonEmptyServersOnly = false, bool bSecureServersOnly = false, int MinSlotsAvailable = 0);
+	static UFindSessionsCallbackProxyAdvanced* FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int32 MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly = false, bool bNonEmptyServersOnly = false, bool bSecureServersOnly = false, int MinSlotsAvailable = 0, float CacheTTLSeconds = 0.f);
+
+	// Forgets every cached session search so the next search goes to the online subsystem
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions")
+	static void ClearSessionSearchCache();
 
 	static bool CompareVariants(const FVariantData &A, const FVariantData &B, EOnlineComparisonOpRedux Comparator);
 	
@@ -52,11 +67,20 @@ private:
 	// Internal callback when the session search completes, calls out to the public success/failure callbacks
 	void OnCompleted(bool bSuccess);
 
+	// Adds the results of one search phase that haven't been seen yet and broadcasts them as a batch
+	void AppendResults(const TArray<FOnlineSessionSearchResult>& Results);
+
+	// Updates the cache and calls out to the public callbacks once every search phase is done
+	void FinishSearch(bool bSuccess);
+
 	bool bRunSecondSearch;
 	bool bIsOnSecondSearch;
 
 	TArray<FBlueprintSessionResult> SessionSearchResults;
 
+	// Session ids already added, the dedicated search returns some of the same sessions as the first one
+	TSet<FString> SeenSessionIds;
+
 private:
 	// The player controller triggering things
 	TWeakObjectPtr<APlayerController> PlayerControllerWeakPtr;
@@ -95,6 +119,15 @@ private:
 	// Min slots requires to search
 	int MinSlotsAvailable;
 
+	// How long cached results can be returned for, 0 to not use the cache
+	float CacheTTLSeconds;
+
+	// Key of this search in the session search cache, empty when not caching
+	FString CacheKey;
+
+	// Cached results were already returned, the search that's running is a background refresh
+	bool bServedFromCache;
+
 	// The world context object in which this call is taking place
 	UObject* WorldContextObject;
 };
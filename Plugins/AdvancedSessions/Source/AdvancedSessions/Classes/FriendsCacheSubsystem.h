@@ -0,0 +1,115 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "BlueprintDataDefinitions.h"
+#include "Interfaces/OnlineFriendsInterface.h"
+#include "Interfaces/OnlinePresenceInterface.h"
+#include "FriendsCacheSubsystem.generated.h"
+
+// Called when a friends list read finishes, with whether the cache holds a list now
+DECLARE_DELEGATE_OneParam(FOnFriendsCacheReady, bool /*bWasSuccessful*/);
+
+/**
+ * Reads each local user's friends list once and keeps it up to date from presence and friends-changed events, so
+ * asking for the list again costs nothing. Every change bumps a version number and stamps the rows it touched, letting
+ * UI redraw only the rows that changed since the version it last drew.
+ * Rows never move except when a friend is removed, then the last row takes its place and is stamped as changed.
+ */
+UCLASS()
+class ADVANCEDSESSIONS_API UFriendsCacheSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	static UFriendsCacheSubsystem* Get(UObject* WorldContextObject);
+
+	// Calls OnReady once the user's list is cached, straight away if it already is
+	void RequestFriendsList(int32 LocalUserNum, FOnFriendsCacheReady OnReady);
+
+	// Reads the list from the online subsystem again, only rows that differ are stamped as changed
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedFriends|FriendsCache")
+	void RefreshFriendsList(int32 LocalUserNum);
+
+	UFUNCTION(BlueprintPure, Category = "Online|AdvancedFriends|FriendsCache")
+	bool HasFriendsList(int32 LocalUserNum) const;
+
+	// The cached friends, empty until the first read finishes
+	UFUNCTION(BlueprintPure, Category = "Online|AdvancedFriends|FriendsCache")
+	const TArray<FBPFriendInfo>& GetCachedFriends(int32 LocalUserNum) const;
+
+	// Goes up every time anything in the user's list changes
+	UFUNCTION(BlueprintPure, Category = "Online|AdvancedFriends|FriendsCache")
+	int32 GetFriendsListVersion(int32 LocalUserNum) const;
+
+	/**
+	* Lists the rows that changed after a version, pass the version returned last time to get only what to redraw.
+	* @param SinceVersion - The version the UI last drew, 0 returns every row
+	* @param ChangedRows - Indices into the cached friends that changed
+	* @param NumRows - How many rows the list has now, rows past this should be removed
+	* @param CurrentVersion - The version to pass next time
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedFriends|FriendsCache")
+	void GetChangedFriendRows(int32 LocalUserNum, int32 SinceVersion, TArray<int32>& ChangedRows, int32& NumRows, int32& CurrentVersion) const;
+
+	// Finds the row of a friend, returns false if they aren't in the list
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedFriends|FriendsCache")
+	bool FindFriendRow(int32 LocalUserNum, const FBPUniqueNetId& FriendId, int32& Row) const;
+
+	// Seconds between full re-reads, for subsystems that don't report every presence change. 0 turns them off
+	UPROPERTY(BlueprintReadWrite, Category = "Online|AdvancedFriends|FriendsCache")
+	float FullRefreshInterval = 60.f;
+
+private:
+
+	struct FFriendsList
+	{
+		TArray<FBPFriendInfo> Friends;
+
+		// Version each row last changed at, parallel to Friends
+		TArray<int32> RowVersions;
+
+		// Friend's net id as a string to their row
+		TMap<FString, int32> RowOfFriend;
+
+		int32 Version = 0;
+
+		bool bHasRead = false;
+		bool bReadInFlight = false;
+
+		double LastReadTime = 0.0;
+
+		TArray<FOnFriendsCacheReady> Waiting;
+
+		FDelegateHandle FriendsChangeHandle;
+	};
+
+	FFriendsList& FindOrAddList(int32 LocalUserNum);
+
+	void ReadFriendsList(int32 LocalUserNum);
+
+	void OnReadFriendsListCompleted(int32 LocalUserNum, bool bWasSuccessful, const FString& ListName, const FString& ErrorString);
+
+	// Diffs the subsystem's list into the cache
+	void ApplyFriendsList(FFriendsList& List, const TArray<TSharedRef<FOnlineFriend>>& OnlineFriends);
+
+	void OnPresenceReceived(const FUniqueNetId& UserId, const TSharedRef<FOnlineUserPresence>& Presence);
+
+	void OnFriendsChanged(int32 LocalUserNum);
+
+	bool Tick(float DeltaTime);
+
+	// Stamps a row as changed at a new list version
+	static void MarkRowChanged(FFriendsList& List, int32 Row);
+
+	TMap<int32, FFriendsList> Lists;
+
+	FDelegateHandle PresenceReceivedHandle;
+
+	FDelegateHandle TickerHandle;
+};
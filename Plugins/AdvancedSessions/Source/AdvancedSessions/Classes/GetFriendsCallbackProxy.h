@@ -24,20 +24,21 @@ class UGetFriendsCallbackProxy : public UOnlineBlueprintCallProxyBase
 	FBlueprintGetFriendsListDelegate OnFailure;
 
 	// Gets the players list of friends from the OnlineSubsystem and returns it, can be retrieved later with GetStoredFriendsList
+	// The list is read once and then kept up to date by the FriendsCacheSubsystem, so calling this again is cheap
 	UFUNCTION(BlueprintCallable, meta=(BlueprintInternalUseOnly = "true", WorldContext="WorldContextObject"), Category = "Online|AdvancedFriends")
 	static UGetFriendsCallbackProxy* GetAndStoreFriendsList(UObject* WorldContextObject, class APlayerController* PlayerController);
 
 	virtual void Activate() override;
 
 private:
-	// Internal callback when the friends list is retrieved
-	void OnReadFriendsListCompleted(int32 LocalUserNum, bool bWasSuccessful, const FString& ListName, const FString& ErrorString);
+	// Internal callback when the friends cache has the list
+	void OnFriendsCacheReady(bool bWasSuccessful);
 
 	// The player controller triggering things
 	TWeakObjectPtr<APlayerController> PlayerControllerWeakPtr;
 
-	// The delegate executed
-	FOnReadFriendsListComplete FriendListReadCompleteDelegate;
+	// Local user whose friends are being read
+	int32 LocalUserNum;
 
 	// The Type of friends list to get
 	// Removed because all but the facebook interfaces don't even currently support anything but the default friends list.
@@ -0,0 +1,134 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "BlueprintDataDefinitions.h"
+#include "SessionSettingsBuilder.h"
+#include "SessionAdvertiserSubsystem.generated.h"
+
+// Counters for the session advertiser, latencies are from UpdateSession to its completion
+USTRUCT(BlueprintType)
+struct FBPSessionAdvertiserStats
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	// Setting changes handed to the advertiser that differed from what was pending
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Advertiser")
+	int32 ChangesQueued = 0;
+
+	// Changes replaced by a newer value for the same key before they were sent
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Advertiser")
+	int32 ChangesCoalesced = 0;
+
+	// Changes thrown away because there was no session to update
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Advertiser")
+	int32 ChangesDropped = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Advertiser")
+	int32 UpdatesSent = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Advertiser")
+	int32 UpdatesFailed = 0;
+
+	// Updates that never reported back and were given up on
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Advertiser")
+	int32 UpdatesTimedOut = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Advertiser")
+	float LastLatencyMs = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Advertiser")
+	float AverageLatencyMs = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Advertiser")
+	float MaxLatencyMs = 0.f;
+};
+
+/**
+ * Advertises frequently changing match state (score, time left, player count) in the game session's settings.
+ * Changes are merged by key and sent together at most once every MinUpdateInterval, with never more than one
+ * UpdateSession in flight, so calling it every tick costs nothing but a map write.
+ */
+UCLASS()
+class ADVANCEDSESSIONS_API USessionAdvertiserSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	// Queues a setting to advertise, it is sent with the next update
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Advertiser")
+	void SetAdvertisedSetting(const FSessionPropertyKeyPair& Setting);
+
+	// Queues several settings to advertise, they are sent together with the next update
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Advertiser")
+	void SetAdvertisedSettings(const TArray<FSessionPropertyKeyPair>& Settings);
+
+	// Sends the queued settings as soon as no update is in flight, ignoring MinUpdateInterval
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Advertiser")
+	void FlushNow();
+
+	UFUNCTION(BlueprintPure, Category = "Online|AdvancedSessions|Advertiser")
+	const FBPSessionAdvertiserStats& GetStats() const { return Stats; }
+
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Advertiser")
+	void ResetStats() { Stats = FBPSessionAdvertiserStats(); }
+
+	// Shortest time between two updates, in seconds
+	UPROPERTY(BlueprintReadWrite, Category = "Online|AdvancedSessions|Advertiser")
+	float MinUpdateInterval = 5.f;
+
+	// Passed to UpdateSession, false only changes the local copy on subsystems that support it
+	UPROPERTY(BlueprintReadWrite, Category = "Online|AdvancedSessions|Advertiser")
+	bool bRefreshOnlineData = true;
+
+	// Session the settings are advertised on
+	FName SessionName = NAME_GameSession;
+
+	// An update that hasn't completed after this long is assumed lost so new changes can go out
+	static constexpr double UpdateTimeoutSeconds = 30.0;
+
+private:
+
+	// Arms the flush timer for when the next update is allowed
+	void ScheduleFlush();
+
+	void Flush();
+
+	void OnUpdateSessionComplete(FName InSessionName, bool bWasSuccessful);
+
+	// Puts the settings of an update that failed back in the queue, unless a newer value was queued since
+	void RequeueSentSettings();
+
+	// Settings waiting to be sent
+	FSessionSettingsBuilder PendingSettings;
+
+	// The queued settings the update in flight carries
+	TArray<FSessionPropertyKeyPair> SentSettings;
+
+	// Everything the update in flight carries, recorded as pushed once it succeeds
+	FOnlineSessionSettings SentSessionSettings;
+
+	FBPSessionAdvertiserStats Stats;
+
+	FTimerHandle FlushTimer;
+
+	FDelegateHandle UpdateCompleteHandle;
+
+	// FPlatformTime::Seconds() the last update was sent, 0 before the first
+	double LastSendTime = 0.0;
+
+	bool bUpdateInFlight = false;
+
+	// FlushNow was called while an update was in flight
+	bool bFlushRequested = false;
+
+	// Completed updates, for the running average
+	int32 NumLatencySamples = 0;
+};
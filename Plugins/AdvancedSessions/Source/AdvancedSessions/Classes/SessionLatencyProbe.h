@@ -0,0 +1,162 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Engine/Engine.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "FindSessionsCallbackProxy.h"
+#include "BlueprintDataDefinitions.h"
+#include "Containers/Ticker.h"
+#include "SessionLatencyProbe.generated.h"
+
+class FSocket;
+class FUdpSocketReceiver;
+class FInternetAddr;
+
+// A session result with the latency measured by UProbeSessionLatencyCallbackProxy
+USTRUCT(BlueprintType)
+struct FBPSessionLatency
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	// The session, its PingInMs is replaced with RoundTripMs when one was measured
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Latency")
+	FBlueprintSessionResult SessionResult;
+
+	// Median round trip of the answered probes, or the ping the subsystem reported if none were answered
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Latency")
+	int32 RoundTripMs = 0;
+
+	// Average difference between consecutive round trips
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Latency")
+	int32 JitterMs = 0;
+
+	// Probes that got an answer, out of ProbesPerSession
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Latency")
+	int32 ProbesAnswered = 0;
+
+	// True if RoundTripMs was measured rather than reported by the subsystem
+	UPROPERTY(BlueprintReadOnly, Category = "Online|AdvancedSessions|Latency")
+	bool bMeasured = false;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FBlueprintSessionLatencyDelegate, const TArray<FBPSessionLatency>&, Results);
+
+/**
+ * Answers latency probes by sending them straight back marked as answers. Anything that isn't a probe is dropped, so the
+ * server can't be used to reflect traffic or made to echo another server. Hosts run this on the QoS port so clients can
+ * measure them, it also works as a local stand-in when testing the probe.
+ */
+class ADVANCEDSESSIONS_API FSessionQosEchoServer
+{
+public:
+
+	static FSessionQosEchoServer& Get();
+
+	// Stops and destroys the shared echo server, called on module shutdown
+	static void Shutdown();
+
+	~FSessionQosEchoServer();
+
+	// Starts echoing on a UDP port, returns false if the port couldn't be bound
+	bool Start(int32 Port);
+
+	void Stop();
+
+	// Stops the server once the named session is destroyed
+	void StopWithSession(const IOnlineSessionPtr& Sessions, FName SessionName);
+
+	bool IsRunning() const { return Socket != nullptr; }
+
+private:
+
+	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
+
+	FSocket* Socket = nullptr;
+	FUdpSocketReceiver* Receiver = nullptr;
+
+	// Session whose destruction stops the server
+	TWeakPtr<IOnlineSession, ESPMode::ThreadSafe> BoundSessions;
+	FName BoundSessionName;
+	FDelegateHandle DestroySessionHandle;
+};
+
+UCLASS(MinimalAPI)
+class UProbeSessionLatencyCallbackProxy : public UOnlineBlueprintCallProxyBase
+{
+	GENERATED_UCLASS_BODY()
+
+	// Called with every session sorted from lowest to highest latency
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintSessionLatencyDelegate OnSuccess;
+
+	// Called when the probe couldn't run at all, the sessions are returned unmeasured
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintSessionLatencyDelegate OnFailure;
+
+	/**
+	* Pings the host of every session and sorts them by round trip time. Sessions whose host can't be reached by address
+	* (Steam relays for example) keep the ping the subsystem reported.
+	* @param QosPort - UDP port the hosts run the QoS echo server on
+	* @param MaxInFlight - Most probes waiting for an answer at once
+	* @param ProbesPerSession - Probes sent to each host, more gives a better jitter figure
+	* @param TimeoutSeconds - How long to wait for each answer
+	*/
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "Online|AdvancedSessions|Latency")
+	static UProbeSessionLatencyCallbackProxy* ProbeSessionLatency(UObject* WorldContextObject, const TArray<FBlueprintSessionResult>& SessionResults, int32 QosPort = 7787, int32 MaxInFlight = 8, int32 ProbesPerSession = 3, float TimeoutSeconds = 1.0f);
+
+	// Starts answering latency probes on this machine, Create Advanced Session does this when bAnswerLatencyProbes is set
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Latency")
+	static bool StartQosEchoServer(int32 QosPort = 7787);
+
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Latency")
+	static void StopQosEchoServer();
+
+	// UOnlineBlueprintCallProxyBase interface
+	virtual void Activate() override;
+	// End of UOnlineBlueprintCallProxyBase interface
+
+	virtual void BeginDestroy() override;
+
+private:
+
+	struct FProbeTarget
+	{
+		TSharedPtr<FInternetAddr> Address;
+
+		// Round trips of the answered probes in seconds
+		TArray<double> RoundTrips;
+
+		// Probes sent so far, also the sequence number of the last one
+		int32 ProbesSent = 0;
+
+		// When the probe being waited on was sent, 0 if nothing is outstanding
+		double SentTime = 0.0;
+	};
+
+	bool Tick(float DeltaTime);
+
+	void ReceiveAnswers(double Now);
+
+	void Finish(bool bSuccess);
+
+	TArray<FBPSessionLatency> Results;
+
+	// One per result, Address is null for results that can't be probed
+	TArray<FProbeTarget> Targets;
+
+	FSocket* Socket;
+
+	FDelegateHandle TickerHandle;
+
+	// Next target to consider sending to, so the window moves along the list instead of always starting at the top
+	int32 NextTarget;
+
+	int32 QosPort;
+	int32 MaxInFlight;
+	int32 ProbesPerSession;
+	float TimeoutSeconds;
+
+	// The world context object in which this call is taking place
+	UObject* WorldContextObject;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "FindSessionsCallbackProxy.h"
+#include "BlueprintDataDefinitions.h"
+
+// Results of one search along with when they were found
+struct FSessionSearchCacheEntry
+{
+	TArray<FBlueprintSessionResult> Results;
+
+	// FPlatformTime::Seconds() when the results were stored
+	double StoredTime = 0.0;
+
+	double GetAge() const { return FPlatformTime::Seconds() - StoredTime; }
+};
+
+/**
+ * Keeps recent session search results keyed by the settings that produced them, so opening the server browser again
+ * can show the last results straight away while a refresh runs in the background. Game thread only.
+ */
+class ADVANCEDSESSIONS_API FSessionSearchCache
+{
+public:
+
+	static FSessionSearchCache& Get();
+
+	// Destroys the shared cache, called on module shutdown
+	static void Shutdown();
+
+	// Builds a key from everything that changes what a search returns
+	static FString MakeKey(const FOnlineSessionSearch& Search, EBPServerPresenceSearchType ServerSearchType);
+
+	// Returns the cached entry for a key, or null if there isn't one
+	const FSessionSearchCacheEntry* Find(const FString& Key) const;
+
+	// Marks a refresh as running for a key, returns false if another search is already refreshing it. Doesn't add an entry.
+	bool TryBeginRefresh(const FString& Key);
+
+	// Stores new results for a key, optionally reporting which sessions appeared and disappeared since the last results
+	void Store(const FString& Key, const TArray<FBlueprintSessionResult>& Results, TArray<FBlueprintSessionResult>* OutAdded = nullptr, TArray<FBlueprintSessionResult>* OutRemoved = nullptr);
+
+	// Clears the running refresh for a key without storing anything, used when a search fails
+	void EndRefresh(const FString& Key);
+
+	// Forgets every cached search, call when sessions are known to have changed
+	void Empty();
+
+private:
+
+	friend class FSessionSearchCacheTest;
+
+	// Most searches kept at once, the oldest is dropped first
+	static constexpr int32 MaxEntries = 16;
+
+	// A refresh that hasn't reported back after this long is assumed lost
+	static constexpr double RefreshTimeoutSeconds = 30.0;
+
+	TMap<FString, FSessionSearchCacheEntry> Entries;
+
+	// FPlatformTime::Seconds() each running refresh was started, kept apart so a failed search never leaves an empty entry
+	TMap<FString, double> RefreshStartedTimes;
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+#include "BlueprintDataDefinitions.h"
+
+/**
+ * Session extra settings keyed by name. Merging m settings into n costs O(n + m) instead of a scan per setting,
+ * and the keys whose value actually changed are tracked so callers can skip work when nothing did.
+ */
+class ADVANCEDSESSIONS_API FSessionSettingsBuilder
+{
+public:
+
+	FSessionSettingsBuilder() = default;
+
+	// Starts from existing settings, a repeated key keeps its first position and its last value
+	explicit FSessionSettingsBuilder(const TArray<FSessionPropertyKeyPair>& InitialSettings);
+
+	// Adds or replaces one setting, returns true if the value changed
+	bool Set(FName Key, const FVariantData& Data);
+
+	// Adds or replaces every setting in the array, returns how many changed
+	int32 Merge(const TArray<FSessionPropertyKeyPair>& NewOrChangedSettings);
+
+	bool Contains(FName Key) const { return KeyToIndex.Contains(Key); }
+
+	bool IsEmpty() const { return Settings.Num() == 0; }
+
+	// Drops every setting and change
+	void Reset();
+
+	// Keys added or given a different value since construction or the last ResetChanges
+	const TArray<FName>& GetChangedKeys() const { return ChangedKeys; }
+
+	bool HasChanges() const { return ChangedKeys.Num() > 0; }
+
+	void ResetChanges();
+
+	// The merged settings, in the order keys were first seen
+	const TArray<FSessionPropertyKeyPair>& GetSettings() const { return Settings; }
+
+	/**
+	 * Writes extra settings into live session settings without touching the ones that already hold the same value.
+	 * @param SessionSettings - The live settings to update
+	 * @param ExtraSettings - Settings to add or replace, later entries win if a key repeats
+	 * @param OutChangedKeys - Optional, receives the keys that were added or changed
+	 * @return The number of settings that were added or changed
+	 */
+	static int32 ApplyToSessionSettings(FOnlineSessionSettings& SessionSettings, const TArray<FSessionPropertyKeyPair>& ExtraSettings, TArray<FName>* OutChangedKeys = nullptr);
+
+	// Remembers settings an UpdateSession call completed successfully with, game thread only
+	static void RecordPushedSettings(FName SessionName, const FOnlineSessionSettings& SessionSettings);
+
+	// Forgets what was pushed for a session, call when it is destroyed
+	static void ForgetPushedSettings(FName SessionName);
+
+	/**
+	 * Checks settings against the last ones successfully pushed for a session, not the live ones which may hold
+	 * values from an update that failed.
+	 * @return True if the session was pushed with exactly these settings
+	 */
+	static bool MatchesPushedSettings(FName SessionName, const FOnlineSessionSettings& SessionSettings);
+
+private:
+
+	void MarkChanged(FName Key);
+
+	TArray<FSessionPropertyKeyPair> Settings;
+
+	// Index into Settings for every key
+	TMap<FName, int32> KeyToIndex;
+
+	TArray<FName> ChangedKeys;
+	TSet<FName> ChangedKeySet;
+};
@@ -20,8 +20,9 @@ class UUpdateSessionCallbackProxyAdvanced : public UOnlineBlueprintCallProxyBase
 	FEmptyOnlineDelegate OnFailure;
 
 	// Creates a session with the default online subsystem with advanced optional inputs, you MUST fill in all categories or it will pass in values that you didn't want as default values
+	// With bSkipIfUnchanged the online call is skipped, and OnSuccess called straight away, when the session was last pushed successfully with the same settings
 	UFUNCTION(BlueprintCallable, meta=(BlueprintInternalUseOnly = "true", WorldContext="WorldContextObject",AutoCreateRefTerm="ExtraSettings"), Category = "Online|AdvancedSessions")
-	static UUpdateSessionCallbackProxyAdvanced* UpdateSession(UObject* WorldContextObject, const TArray<FSessionPropertyKeyPair> &ExtraSettings, int32 PublicConnections = 100, int32 PrivateConnections = 0, bool bUseLAN = false, bool bAllowInvites = false, bool bAllowJoinInProgress = false, bool bRefreshOnlineData = true, bool bIsDedicatedServer = false);
+	static UUpdateSessionCallbackProxyAdvanced* UpdateSession(UObject* WorldContextObject, const TArray<FSessionPropertyKeyPair> &ExtraSettings, int32 PublicConnections = 100, int32 PrivateConnections = 0, bool bUseLAN = false, bool bAllowInvites = false, bool bAllowJoinInProgress = false, bool bRefreshOnlineData = true, bool bIsDedicatedServer = false, bool bSkipIfUnchanged = false);
 
 	// UOnlineBlueprintCallProxyBase interface
 	virtual void Activate() override;
@@ -61,6 +62,12 @@ private:
 	// Update whether this is a dedicated server or not
 	bool bDedicatedServer;
 
+	// Don't call the online subsystem if nothing would change
+	bool bSkipIfUnchanged;
+
+	// What was sent, recorded as pushed once the update succeeds
+	FOnlineSessionSettings SentSettings;
+
 	// The world context object in which this call is taking place
 	UObject* WorldContextObject;
 };
@@ -1,5 +1,7 @@
 //#include "StandAlonePrivatePCH.h"
 #include "AdvancedSessions.h"
+#include "SessionLatencyProbe.h"
+#include "SessionSearchCache.h"
 
 void AdvancedSessions::StartupModule()
 {
@@ -7,6 +9,8 @@ void AdvancedSessions::StartupModule()
  
 void AdvancedSessions::ShutdownModule()
 {
+	FSessionQosEchoServer::Shutdown();
+	FSessionSearchCache::Shutdown();
 }
  
 IMPLEMENT_MODULE(AdvancedSessions, AdvancedSessions)
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "AdvancedSessionsLibrary.h"
 #include "GameFramework/PlayerState.h"
 #include "GameFramework/GameStateBase.h"
+#include "FindSessionsCallbackProxyAdvanced.h"
+#include "SessionSettingsBuilder.h"
 
 //General Log
 DEFINE_LOG_CATEGORY(AdvancedSessionsLog);
@@ -125,31 +127,10 @@ void UAdvancedSessionsLibrary::FindSessionPropertyIndexByName(const TArray<FSess
 
 void UAdvancedSessionsLibrary::AddOrModifyExtraSettings(UPARAM(ref) TArray<FSessionPropertyKeyPair> & SettingsArray, UPARAM(ref) TArray<FSessionPropertyKeyPair> & NewOrChangedSettings, TArray<FSessionPropertyKeyPair> & ModifiedSettingsArray)
 {
-	ModifiedSettingsArray = SettingsArray;
-
-	bool bFoundSetting = false;
-	// For each new setting
-	for (const FSessionPropertyKeyPair& Setting : NewOrChangedSettings)
-	{
-		bFoundSetting = false;
-
-		for (FSessionPropertyKeyPair & itr : ModifiedSettingsArray)
-		{
-			// Manually comparing the keys
-			if (itr.Key == Setting.Key)
-			{
-				bFoundSetting = true;
-				itr.Data = Setting.Data;
-			}
-		}
-
-		// If it was not found, add to the array instead
-		if (!bFoundSetting)
-		{
-			ModifiedSettingsArray.Add(Setting);
-		}
-	}
-
+	// Keyed merge, existing settings keep their order and new ones are appended
+	FSessionSettingsBuilder Builder(SettingsArray);
+	Builder.Merge(NewOrChangedSettings);
+	ModifiedSettingsArray = Builder.GetSettings();
 }
 
 void UAdvancedSessionsLibrary::GetExtraSettings(FBlueprintSessionResult SessionResult, TArray<FSessionPropertyKeyPair> & ExtraSettings)
@@ -282,122 +263,266 @@ FSessionPropertyKeyPair UAdvancedSessionsLibrary::MakeLiteralSessionPropertyFloa
 	return Prop;
 }
 
-void UAdvancedSessionsLibrary::GetSessionPropertyByte(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, uint8 &SettingValue)
+namespace AdvancedSessionsProperties
 {
-	for (FSessionPropertyKeyPair itr : ExtraSettings)
+	static const FVariantData* FindInArray(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName)
 	{
-		if (itr.Key == SettingName)
+		const FSessionPropertyKeyPair* Property = ExtraSettings.FindByPredicate([&](const FSessionPropertyKeyPair& it) {return it.Key == SettingName; });
+		return Property ? &Property->Data : nullptr;
+	}
+
+	// Reads a found property as ValueType, bytes are stored as Int32 like MakeLiteralSessionPropertyByte does
+	template<typename ValueType>
+	static ESessionSettingSearchResult ReadValue(const FVariantData* Data, EOnlineKeyValuePairDataType::Type ExpectedType, ValueType &SettingValue)
+	{
+		if (!Data)
 		{
-			if (itr.Data.GetType() == EOnlineKeyValuePairDataType::Int32)
-			{
-				int32 Val;
-				itr.Data.GetValue(Val);
-				SettingValue = (uint8)(Val);
-				SearchResult = ESessionSettingSearchResult::Found;
-			}
-			else
-			{
-				SearchResult = ESessionSettingSearchResult::WrongType;
-			}
-			return;
+			return ESessionSettingSearchResult::NotFound;
 		}
+
+		if (Data->GetType() != ExpectedType)
+		{
+			return ESessionSettingSearchResult::WrongType;
+		}
+
+		Data->GetValue(SettingValue);
+		return ESessionSettingSearchResult::Found;
 	}
 
-	SearchResult = ESessionSettingSearchResult::NotFound;
-	return;
+	static ESessionSettingSearchResult ReadByte(const FVariantData* Data, uint8 &SettingValue)
+	{
+		int32 Val;
+		ESessionSettingSearchResult SearchResult = ReadValue(Data, EOnlineKeyValuePairDataType::Int32, Val);
+		if (SearchResult == ESessionSettingSearchResult::Found)
+		{
+			SettingValue = (uint8)(Val);
+		}
+		return SearchResult;
+	}
+}
+
+void UAdvancedSessionsLibrary::GetSessionPropertyByte(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, uint8 &SettingValue)
+{
+	SearchResult = AdvancedSessionsProperties::ReadByte(AdvancedSessionsProperties::FindInArray(ExtraSettings, SettingName), SettingValue);
 }
 
 void UAdvancedSessionsLibrary::GetSessionPropertyBool(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, bool &SettingValue)
 {
-	for (FSessionPropertyKeyPair itr : ExtraSettings)
+	SearchResult = AdvancedSessionsProperties::ReadValue(AdvancedSessionsProperties::FindInArray(ExtraSettings, SettingName), EOnlineKeyValuePairDataType::Bool, SettingValue);
+}
+
+void UAdvancedSessionsLibrary::GetSessionPropertyString(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, FString &SettingValue)
+{
+	SearchResult = AdvancedSessionsProperties::ReadValue(AdvancedSessionsProperties::FindInArray(ExtraSettings, SettingName), EOnlineKeyValuePairDataType::String, SettingValue);
+}
+
+void UAdvancedSessionsLibrary::GetSessionPropertyInt(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, int32 &SettingValue)
+{
+	SearchResult = AdvancedSessionsProperties::ReadValue(AdvancedSessionsProperties::FindInArray(ExtraSettings, SettingName), EOnlineKeyValuePairDataType::Int32, SettingValue);
+}
+
+void UAdvancedSessionsLibrary::GetSessionPropertyFloat(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, float &SettingValue)
+{
+	SearchResult = AdvancedSessionsProperties::ReadValue(AdvancedSessionsProperties::FindInArray(ExtraSettings, SettingName), EOnlineKeyValuePairDataType::Float, SettingValue);
+}
+
+FBPSessionPropertyIndex UAdvancedSessionsLibrary::MakeSessionPropertyIndex(const FBlueprintSessionResult& SessionResult)
+{
+	const FSessionSettings& Settings = SessionResult.OnlineResult.Session.SessionSettings.Settings;
+
+	FBPSessionPropertyIndex PropertyIndex;
+	PropertyIndex.Properties.Reserve(Settings.Num());
+	for (const auto& Elem : Settings)
 	{
-		if (itr.Key == SettingName)
-		{
-			if (itr.Data.GetType() == EOnlineKeyValuePairDataType::Bool)
-			{
-				itr.Data.GetValue(SettingValue);
-				SearchResult = ESessionSettingSearchResult::Found;
-			}
-			else
-			{
-				SearchResult = ESessionSettingSearchResult::WrongType;
-			}
-			return;
-		}
+		PropertyIndex.Properties.Add(Elem.Key, Elem.Value.Data);
 	}
+	return PropertyIndex;
+}
 
-	SearchResult = ESessionSettingSearchResult::NotFound;
-	return;
+FBPSessionPropertyIndex UAdvancedSessionsLibrary::MakeSessionPropertyIndexFromArray(const TArray<FSessionPropertyKeyPair>& ExtraSettings)
+{
+	FBPSessionPropertyIndex PropertyIndex;
+	PropertyIndex.Properties.Reserve(ExtraSettings.Num());
+	for (const FSessionPropertyKeyPair& Setting : ExtraSettings)
+	{
+		PropertyIndex.Properties.Add(Setting.Key, Setting.Data);
+	}
+	return PropertyIndex;
 }
 
-void UAdvancedSessionsLibrary::GetSessionPropertyString(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, FString &SettingValue)
+void UAdvancedSessionsLibrary::MakeSessionPropertyIndices(const TArray<FBlueprintSessionResult>& SessionResults, TArray<FBPSessionPropertyIndex>& Indices)
 {
-	for (FSessionPropertyKeyPair itr : ExtraSettings)
+	Indices.Reset(SessionResults.Num());
+	for (const FBlueprintSessionResult& SessionResult : SessionResults)
 	{
-		if (itr.Key == SettingName)
-		{
-			if (itr.Data.GetType() == EOnlineKeyValuePairDataType::String)
-			{
-				itr.Data.GetValue(SettingValue);
-				SearchResult = ESessionSettingSearchResult::Found;
-			}
-			else
-			{
-				SearchResult = ESessionSettingSearchResult::WrongType;
-			}
-			return;
-		}
+		Indices.Add(MakeSessionPropertyIndex(SessionResult));
 	}
+}
 
-	SearchResult = ESessionSettingSearchResult::NotFound;
-	return;
+void UAdvancedSessionsLibrary::FindIndexedSessionProperty(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, EBlueprintResultSwitch &Result, FSessionPropertyKeyPair& OutProperty)
+{
+	if (const FVariantData* Data = PropertyIndex.Find(SettingName))
+	{
+		OutProperty.Key = SettingName;
+		OutProperty.Data = *Data;
+		Result = EBlueprintResultSwitch::OnSuccess;
+		return;
+	}
+
+	Result = EBlueprintResultSwitch::OnFailure;
 }
 
-void UAdvancedSessionsLibrary::GetSessionPropertyInt(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, int32 &SettingValue)
+void UAdvancedSessionsLibrary::GetIndexedSessionPropertyByte(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, uint8 &SettingValue)
+{
+	SearchResult = AdvancedSessionsProperties::ReadByte(PropertyIndex.Find(SettingName), SettingValue);
+}
+
+void UAdvancedSessionsLibrary::GetIndexedSessionPropertyBool(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, bool &SettingValue)
 {
-	for (FSessionPropertyKeyPair itr : ExtraSettings)
+	SearchResult = AdvancedSessionsProperties::ReadValue(PropertyIndex.Find(SettingName), EOnlineKeyValuePairDataType::Bool, SettingValue);
+}
+
+void UAdvancedSessionsLibrary::GetIndexedSessionPropertyString(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, FString &SettingValue)
+{
+	SearchResult = AdvancedSessionsProperties::ReadValue(PropertyIndex.Find(SettingName), EOnlineKeyValuePairDataType::String, SettingValue);
+}
+
+void UAdvancedSessionsLibrary::GetIndexedSessionPropertyInt(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, int32 &SettingValue)
+{
+	SearchResult = AdvancedSessionsProperties::ReadValue(PropertyIndex.Find(SettingName), EOnlineKeyValuePairDataType::Int32, SettingValue);
+}
+
+void UAdvancedSessionsLibrary::GetIndexedSessionPropertyFloat(const FBPSessionPropertyIndex& PropertyIndex, FName SettingName, ESessionSettingSearchResult &SearchResult, float &SettingValue)
+{
+	SearchResult = AdvancedSessionsProperties::ReadValue(PropertyIndex.Find(SettingName), EOnlineKeyValuePairDataType::Float, SettingValue);
+}
+
+bool UAdvancedSessionsLibrary::SessionPassesFilters(const FBlueprintSessionResult& SessionResult, const TArray<FSessionsSearchSetting>& Filters)
+{
+	// The session settings are already a map, so look each filter up there rather than building an index first
+	const FSessionSettings& Settings = SessionResult.OnlineResult.Session.SessionSettings.Settings;
+	for (const FSessionsSearchSetting& Filter : Filters)
 	{
-		if (itr.Key == SettingName)
-		{
-			if (itr.Data.GetType() == EOnlineKeyValuePairDataType::Int32)
-			{
-				itr.Data.GetValue(SettingValue);
-				SearchResult = ESessionSettingSearchResult::Found;
-			}
-			else
-			{
-				SearchResult = ESessionSettingSearchResult::WrongType;
-			}
-			return;
-		}
+		const FOnlineSessionSetting* Setting = Settings.Find(Filter.PropertyKeyPair.Key);
+
+		// Couldn't find this key
+		if (!Setting)
+			continue;
+
+		if (!UFindSessionsCallbackProxyAdvanced::CompareVariants(Setting->Data, Filter.PropertyKeyPair.Data, Filter.ComparisonOp))
+			return false;
 	}
 
-	SearchResult = ESessionSettingSearchResult::NotFound;
-	return;
+	return true;
 }
 
-void UAdvancedSessionsLibrary::GetSessionPropertyFloat(const TArray<FSessionPropertyKeyPair> & ExtraSettings, FName SettingName, ESessionSettingSearchResult &SearchResult, float &SettingValue)
+void UAdvancedSessionsLibrary::FilterSessionResultIndices(const TArray<FBlueprintSessionResult>& SessionResults, const TArray<FSessionsSearchSetting>& Filters, TArray<int32>& MatchingIndices)
 {
-	for (FSessionPropertyKeyPair itr : ExtraSettings)
+	MatchingIndices.Reset(SessionResults.Num());
+	for (int32 Index = 0; Index < SessionResults.Num(); ++Index)
 	{
-		if (itr.Key == SettingName)
+		if (SessionPassesFilters(SessionResults[Index], Filters))
+		{
+			MatchingIndices.Add(Index);
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+// Times the array accessors against the indexed view and the bulk filter on generated sessions
+// AdvancedSessions.BenchSessionProperties [NumSessions] [NumProperties] [Iterations]
+static FAutoConsoleCommand BenchSessionPropertiesCommand(
+	TEXT("AdvancedSessions.BenchSessionProperties"),
+	TEXT("Compares session property lookups by array scan and by index. Args: [NumSessions=1000] [NumProperties=10] [Iterations=10]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumSessions = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		const int32 NumProperties = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 10;
+		const int32 Iterations = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 10;
+
+		TArray<FName> Keys;
+		for (int32 Prop = 0; Prop < NumProperties; ++Prop)
+		{
+			Keys.Add(FName(*FString::Printf(TEXT("BENCHPROP%d"), Prop)));
+		}
+
+		TArray<FBlueprintSessionResult> Sessions;
+		Sessions.SetNum(NumSessions);
+		for (int32 Session = 0; Session < NumSessions; ++Session)
+		{
+			for (int32 Prop = 0; Prop < NumProperties; ++Prop)
+			{
+				Sessions[Session].OnlineResult.Session.SessionSettings.Set(Keys[Prop], (Session + Prop) % 16, EOnlineDataAdvertisementType::ViaOnlineService);
+			}
+		}
+
+		// Keep roughly half of the sessions on every filtered key
+		TArray<FSessionsSearchSetting> Filters;
+		for (const FName& Key : Keys)
 		{
-			if (itr.Data.GetType() == EOnlineKeyValuePairDataType::Float)
+			FSessionsSearchSetting& Filter = Filters.AddDefaulted_GetRef();
+			Filter.ComparisonOp = EOnlineComparisonOpRedux::LessThan;
+			Filter.PropertyKeyPair = UAdvancedSessionsLibrary::MakeLiteralSessionPropertyInt(Key, 16);
+		}
+		Filters[0].PropertyKeyPair = UAdvancedSessionsLibrary::MakeLiteralSessionPropertyInt(Keys[0], 8);
+
+		int64 Checksum = 0;
+		ESessionSettingSearchResult SearchResult;
+		int32 Value = 0;
+
+		// What a browser blueprint does today, copy the settings out and scan them once per property
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			for (const FBlueprintSessionResult& Session : Sessions)
 			{
-				itr.Data.GetValue(SettingValue);
-				SearchResult = ESessionSettingSearchResult::Found;
+				TArray<FSessionPropertyKeyPair> ExtraSettings;
+				UAdvancedSessionsLibrary::GetExtraSettings(Session, ExtraSettings);
+				for (const FName& Key : Keys)
+				{
+					UAdvancedSessionsLibrary::GetSessionPropertyInt(ExtraSettings, Key, SearchResult, Value);
+					Checksum += Value;
+				}
 			}
-			else
+		}
+		const double ArrayMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			for (const FBlueprintSessionResult& Session : Sessions)
 			{
-				SearchResult = ESessionSettingSearchResult::WrongType;
+				const FBPSessionPropertyIndex PropertyIndex = UAdvancedSessionsLibrary::MakeSessionPropertyIndex(Session);
+				for (const FName& Key : Keys)
+				{
+					UAdvancedSessionsLibrary::GetIndexedSessionPropertyInt(PropertyIndex, Key, SearchResult, Value);
+					Checksum -= Value;
+				}
 			}
-			return;
 		}
-	}
+		const double IndexedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
 
-	SearchResult = ESessionSettingSearchResult::NotFound;
-	return;
-}
+		TArray<FBlueprintSessionResult> Filtered;
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			Filtered.Reset();
+			UFindSessionsCallbackProxyAdvanced::FilterSessionResults(Sessions, Filters, Filtered);
+		}
+		const double FilterCopyMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		TArray<int32> Matching;
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			UAdvancedSessionsLibrary::FilterSessionResultIndices(Sessions, Filters, Matching);
+		}
+		const double FilterIndicesMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		UE_LOG(AdvancedSessionsLog, Display, TEXT("BenchSessionProperties - %d sessions x %d properties, per pass: array %.3f ms, indexed %.3f ms, FilterSessionResults %.3f ms, FilterSessionResultIndices %.3f ms (%d of %d matched, checksum %lld)"),
+			NumSessions, NumProperties, ArrayMs, IndexedMs, FilterCopyMs, FilterIndicesMs, Matching.Num(), NumSessions, Checksum);
+	}));
+#endif
 
 
 bool UAdvancedSessionsLibrary::HasOnlineSubsystem(FName SubSystemName)
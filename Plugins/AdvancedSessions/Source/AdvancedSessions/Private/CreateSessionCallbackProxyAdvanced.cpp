@@ -1,5 +1,7 @@
 // Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
 #include "CreateSessionCallbackProxyAdvanced.h"
+#include "SessionSettingsBuilder.h"
+#include "SessionLatencyProbe.h"
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -10,10 +12,12 @@ UCreateSessionCallbackProxyAdvanced::UCreateSessionCallbackProxyAdvanced(const F
 	, CreateCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateCompleted))
 	, StartCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartCompleted))
 	, NumPublicConnections(1)
+	, bAnswerLatencyProbes(false)
+	, QosPort(7787)
 {
 }
 
-UCreateSessionCallbackProxyAdvanced* UCreateSessionCallbackProxyAdvanced::CreateAdvancedSession(UObject* WorldContextObject, const TArray<FSessionPropertyKeyPair> &ExtraSettings, class APlayerController* PlayerController, int32 PublicConnections, int32 PrivateConnections, bool bUseLAN, bool bAllowInvites, bool bIsDedicatedServer, bool bUsePresence, bool bAllowJoinViaPresence, bool bAllowJoinViaPresenceFriendsOnly, bool bAntiCheatProtected, bool bUsesStats, bool bShouldAdvertise)
+UCreateSessionCallbackProxyAdvanced* UCreateSessionCallbackProxyAdvanced::CreateAdvancedSession(UObject* WorldContextObject, const TArray<FSessionPropertyKeyPair> &ExtraSettings, class APlayerController* PlayerController, int32 PublicConnections, int32 PrivateConnections, bool bUseLAN, bool bAllowInvites, bool bIsDedicatedServer, bool bUsePresence, bool bAllowJoinViaPresence, bool bAllowJoinViaPresenceFriendsOnly, bool bAntiCheatProtected, bool bUsesStats, bool bShouldAdvertise, bool bAnswerLatencyProbes, int32 QosPort)
 {
 	UCreateSessionCallbackProxyAdvanced* Proxy = NewObject<UCreateSessionCallbackProxyAdvanced>();
 	Proxy->PlayerControllerWeakPtr = PlayerController;
@@ -30,6 +34,8 @@ UCreateSessionCallbackProxyAdvanced* UCreateSessionCallbackProxyAdvanced::Create
 	Proxy->bAntiCheatProtected = bAntiCheatProtected;
 	Proxy->bUsesStats = bUsesStats;
 	Proxy->bShouldAdvertise = bShouldAdvertise;
+	Proxy->bAnswerLatencyProbes = bAnswerLatencyProbes;
+	Proxy->QosPort = QosPort;
 	return Proxy;
 }
 
@@ -121,9 +127,18 @@ void UCreateSessionCallbackProxyAdvanced::OnCreateCompleted(FName SessionName, b
 		if (Sessions.IsValid())
 		{
 			Sessions->ClearOnCreateSessionCompleteDelegate_Handle(CreateCompleteDelegateHandle);
+
+			// Anything pushed was for a session that no longer exists
+			FSessionSettingsBuilder::ForgetPushedSettings(SessionName);
 			
 			if (bWasSuccessful)
 			{
+				// Clients can only measure this host if something answers, a port that can't be bound isn't fatal to the session
+				if (bAnswerLatencyProbes && FSessionQosEchoServer::Get().Start(QosPort))
+				{
+					FSessionQosEchoServer::Get().StopWithSession(Sessions, SessionName);
+				}
+
 				StartCompleteDelegateHandle = Sessions->AddOnStartSessionCompleteDelegate_Handle(StartCompleteDelegate);
 				Sessions->StartSession(NAME_GameSession);
 
@@ -1,5 +1,7 @@
 // Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
 #include "FindSessionsCallbackProxyAdvanced.h"
+#include "AdvancedSessionsLibrary.h"
+#include "SessionSearchCache.h"
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -10,12 +12,14 @@ UFindSessionsCallbackProxyAdvanced::UFindSessionsCallbackProxyAdvanced(const FOb
 	: Super(ObjectInitializer)
 	, Delegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnCompleted))
 	, bUseLAN(false)
+	, CacheTTLSeconds(0.f)
+	, bServedFromCache(false)
 {
 	bRunSecondSearch = false;
 	bIsOnSecondSearch = false;
 }
 
-UFindSessionsCallbackProxyAdvanced* UFindSessionsCallbackProxyAdvanced::FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly, bool bNonEmptyServersOnly, bool bSecureServersOnly, int MinSlotsAvailable)
+UFindSessionsCallbackProxyAdvanced* UFindSessionsCallbackProxyAdvanced::FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly, bool bNonEmptyServersOnly, bool bSecureServersOnly, int MinSlotsAvailable, float CacheTTLSeconds)
 {
 	UFindSessionsCallbackProxyAdvanced* Proxy = NewObject<UFindSessionsCallbackProxyAdvanced>();	
 	Proxy->PlayerControllerWeakPtr = PlayerController;
@@ -28,9 +32,15 @@ UFindSessionsCallbackProxyAdvanced* UFindSessionsCallbackProxyAdvanced::FindSess
 	Proxy->bNonEmptyServersOnly = bNonEmptyServersOnly;
 	Proxy->bSecureServersOnly = bSecureServersOnly;
 	Proxy->MinSlotsAvailable = MinSlotsAvailable;
+	Proxy->CacheTTLSeconds = CacheTTLSeconds;
 	return Proxy;
 }
 
+void UFindSessionsCallbackProxyAdvanced::ClearSessionSearchCache()
+{
+	FSessionSearchCache::Get().Empty();
+}
+
 void UFindSessionsCallbackProxyAdvanced::Activate()
 {
 	FOnlineSubsystemBPCallHelperAdvanced Helper(TEXT("FindSessions"), GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull));
@@ -44,6 +54,10 @@ void UFindSessionsCallbackProxyAdvanced::Activate()
 			// Re-initialize here, otherwise I think there might be issues with people re-calling search for some reason before it is destroyed
 			bRunSecondSearch = false;
 			bIsOnSecondSearch = false;
+			SessionSearchResults.Reset();
+			SeenSessionIds.Reset();
+			CacheKey.Reset();
+			bServedFromCache = false;
 
 			DelegateHandle = Sessions->AddOnFindSessionsCompleteDelegate_Handle(Delegate);
 
@@ -138,6 +152,38 @@ void UFindSessionsCallbackProxyAdvanced::Activate()
 			// Copy the derived temp variable over to it's base class
 			SearchObject->QuerySettings = tem;
 
+			if (CacheTTLSeconds > 0.f)
+			{
+				FSessionSearchCache& Cache = FSessionSearchCache::Get();
+				CacheKey = FSessionSearchCache::MakeKey(*SearchObject, ServerSearchType);
+
+				const FSessionSearchCacheEntry* Entry = Cache.Find(CacheKey);
+
+				if (Entry && Entry->GetAge() < CacheTTLSeconds)
+				{
+					// Copy everything out first, a callback could start another search that changes the cache
+					const double Age = Entry->GetAge();
+					SessionSearchResults = Entry->Results;
+					bServedFromCache = true;
+
+					OnResultsBatch.Broadcast(SessionSearchResults);
+					OnSuccess.Broadcast(SessionSearchResults);
+
+					// Still fresh, or someone else is already refreshing it
+					if (Age < CacheTTLSeconds * 0.5f || !Cache.TryBeginRefresh(CacheKey))
+					{
+						Sessions->ClearOnFindSessionsCompleteDelegate_Handle(DelegateHandle);
+						return;
+					}
+
+					SessionSearchResults.Reset();
+				}
+				else
+				{
+					Cache.TryBeginRefresh(CacheKey);
+				}
+			}
+
 			Sessions->FindSessions(*Helper.UserID, SearchObject.ToSharedRef());
 
 			// OnQueryCompleted will get called, nothing more to do now
@@ -173,18 +219,8 @@ void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
 		{
 			if (SearchObjectDedicated.IsValid())
 			{
-				// Just log the results for now, will need to add a blueprint-compatible search result struct
-				for (auto& Result : SearchObjectDedicated->SearchResults)
-				{
-					FString ResultText = FString::Printf(TEXT("Found a session. Ping is %d"), Result.PingInMs);
-
-					FFrame::KismetExecutionMessage(*ResultText, ELogVerbosity::Log);
-
-					FBlueprintSessionResult BPResult;
-					BPResult.OnlineResult = Result;
-					SessionSearchResults.Add(BPResult);
-				}
-				OnSuccess.Broadcast(SessionSearchResults);
+				AppendResults(SearchObjectDedicated->SearchResults);
+				FinishSearch(true);
 				return;
 			}
 		}
@@ -192,20 +228,10 @@ void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
 		{
 			if (SearchObject.IsValid())
 			{
-				// Just log the results for now, will need to add a blueprint-compatible search result struct
-				for (auto& Result : SearchObject->SearchResults)
-				{
-					FString ResultText = FString::Printf(TEXT("Found a session. Ping is %d"), Result.PingInMs);
-
-					FFrame::KismetExecutionMessage(*ResultText, ELogVerbosity::Log);
-
-					FBlueprintSessionResult BPResult;
-					BPResult.OnlineResult = Result;
-					SessionSearchResults.Add(BPResult);
-				}
+				AppendResults(SearchObject->SearchResults);
 				if (!bRunSecondSearch)
 				{
-					OnSuccess.Broadcast(SessionSearchResults);
+					FinishSearch(true);
 					return;
 				}
 			}
@@ -216,10 +242,7 @@ void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
 		if (!bRunSecondSearch)
 		{
 			// Need to account for only one of the searches failing
-			if (SessionSearchResults.Num() > 0)
-				OnSuccess.Broadcast(SessionSearchResults);
-			else
-				OnFailure.Broadcast(SessionSearchResults);
+			FinishSearch(SessionSearchResults.Num() > 0);
 			return;
 		}
 	}
@@ -233,45 +256,88 @@ void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
 	}
 	else // We lost our player controller
 	{
-		if (bSuccess && SessionSearchResults.Num() > 0)
-			OnSuccess.Broadcast(SessionSearchResults);
-		else
-			OnFailure.Broadcast(SessionSearchResults);
+		FinishSearch(bSuccess && SessionSearchResults.Num() > 0);
 	}
 }
 
-
-void UFindSessionsCallbackProxyAdvanced::FilterSessionResults(const TArray<FBlueprintSessionResult> &SessionResults, const TArray<FSessionsSearchSetting> &Filters, TArray<FBlueprintSessionResult> &FilteredResults)
+void UFindSessionsCallbackProxyAdvanced::FinishSearch(bool bSuccess)
 {
-	for (int j = 0; j < SessionResults.Num(); j++)
+	if (!CacheKey.IsEmpty())
 	{
-		bool bAddResult = true;
+		FSessionSearchCache& Cache = FSessionSearchCache::Get();
 
-		// Filter results
-		if (Filters.Num() > 0)
+		if (bSuccess)
 		{
-			const FOnlineSessionSetting * setting;
-			for (int i = 0; i < Filters.Num(); i++)
+			TArray<FBlueprintSessionResult> Added;
+			TArray<FBlueprintSessionResult> Removed;
+			Cache.Store(CacheKey, SessionSearchResults, &Added, &Removed);
+
+			// The caller already has the old results, only tell them what changed
+			if (bServedFromCache)
 			{
-				setting = SessionResults[j].OnlineResult.Session.SessionSettings.Settings.Find(Filters[i].PropertyKeyPair.Key);
+				if (Added.Num() > 0 || Removed.Num() > 0)
+					OnCacheRefreshed.Broadcast(Added, Removed);
+				return;
+			}
+		}
+		else
+		{
+			Cache.EndRefresh(CacheKey);
 
-				// Couldn't find this key
-				if (!setting)
-					continue;
+			// A failed refresh leaves the cached results the caller already has
+			if (bServedFromCache)
+				return;
+		}
+	}
 
-				if (!CompareVariants(setting->Data, Filters[i].PropertyKeyPair.Data, Filters[i].ComparisonOp))
-				{
-					bAddResult = false;
-					break;
-				}
-			}
+	if (bSuccess)
+		OnSuccess.Broadcast(SessionSearchResults);
+	else
+		OnFailure.Broadcast(SessionSearchResults);
+}
+
+void UFindSessionsCallbackProxyAdvanced::AppendResults(const TArray<FOnlineSessionSearchResult>& Results)
+{
+	const int32 FirstNewIndex = SessionSearchResults.Num();
+	SessionSearchResults.Reserve(FirstNewIndex + Results.Num());
+
+	for (const FOnlineSessionSearchResult& Result : Results)
+	{
+		// Results without session info can't be told apart, keep them all
+		if (Result.IsSessionInfoValid())
+		{
+			bool bAlreadySeen = false;
+			SeenSessionIds.Add(Result.GetSessionIdStr(), &bAlreadySeen);
+
+			if (bAlreadySeen)
+				continue;
 		}
 
-		if (bAddResult)
-			FilteredResults.Add(SessionResults[j]);
+		FBlueprintSessionResult& BPResult = SessionSearchResults.AddDefaulted_GetRef();
+		BPResult.OnlineResult = Result;
+	}
+
+	const int32 NumNew = SessionSearchResults.Num() - FirstNewIndex;
+
+	// One line per phase instead of a formatted message per result
+	UE_LOG(AdvancedSessionsLog, Verbose, TEXT("FindSessionsAdvanced: search phase returned %d sessions, %d new"), Results.Num(), NumNew);
+
+	// A background refresh reports through OnCacheRefreshed instead
+	if (NumNew > 0 && !bServedFromCache && OnResultsBatch.IsBound())
+	{
+		TArray<FBlueprintSessionResult> Batch(SessionSearchResults.GetData() + FirstNewIndex, NumNew);
+		OnResultsBatch.Broadcast(Batch);
 	}
+}
 
-	return;
+void UFindSessionsCallbackProxyAdvanced::FilterSessionResults(const TArray<FBlueprintSessionResult> &SessionResults, const TArray<FSessionsSearchSetting> &Filters, TArray<FBlueprintSessionResult> &FilteredResults)
+{
+	FilteredResults.Reserve(FilteredResults.Num() + SessionResults.Num());
+	for (const FBlueprintSessionResult& SessionResult : SessionResults)
+	{
+		if (UAdvancedSessionsLibrary::SessionPassesFilters(SessionResult, Filters))
+			FilteredResults.Add(SessionResult);
+	}
 }
 
 
@@ -0,0 +1,354 @@
+#include "FriendsCacheSubsystem.h"
+#include "GetFriendsCallbackProxy.h"
+#include "Engine/GameInstance.h"
+#include "Containers/Ticker.h"
+#include "OnlineSubsystemUtils.h"
+
+namespace FriendsCache
+{
+	static const TArray<FBPFriendInfo> EmptyFriends;
+
+	static void MakeFriendInfo(const FOnlineFriend& Friend, FBPFriendInfo& BPF)
+	{
+		const FOnlineUserPresence& pres = Friend.GetPresence();
+		BPF.OnlineState = ((EBPOnlinePresenceState)((int32)pres.Status.State));
+		BPF.DisplayName = Friend.GetDisplayName();
+		BPF.RealName = Friend.GetRealName();
+		BPF.UniqueNetId.SetUniqueNetId(Friend.GetUserId());
+		BPF.bIsPlayingSameGame = pres.bIsPlayingThisGame;
+	}
+
+	static void MakePresenceInfo(const FOnlineUserPresence& pres, FBPFriendPresenceInfo& PresenceInfo)
+	{
+		PresenceInfo.bIsOnline = pres.bIsOnline;
+		PresenceInfo.bHasVoiceSupport = pres.bHasVoiceSupport;
+		PresenceInfo.bIsPlaying = pres.bIsPlaying;
+		PresenceInfo.PresenceState = ((EBPOnlinePresenceState)((int32)pres.Status.State));
+		PresenceInfo.StatusString = pres.Status.StatusStr;
+		PresenceInfo.bIsJoinable = pres.bIsJoinable;
+		PresenceInfo.bIsPlayingThisGame = pres.bIsPlayingThisGame;
+	}
+
+	static bool PresenceMatches(const FBPFriendPresenceInfo& A, const FBPFriendPresenceInfo& B)
+	{
+		return A.bIsOnline == B.bIsOnline && A.bHasVoiceSupport == B.bHasVoiceSupport && A.bIsPlaying == B.bIsPlaying &&
+			A.PresenceState == B.PresenceState && A.bIsJoinable == B.bIsJoinable && A.bIsPlayingThisGame == B.bIsPlayingThisGame &&
+			A.StatusString == B.StatusString;
+	}
+
+	// Compares everything but the net id, which is what the rows are matched by
+	static bool FriendMatches(const FBPFriendInfo& A, const FBPFriendInfo& B)
+	{
+		return A.OnlineState == B.OnlineState && A.bIsPlayingSameGame == B.bIsPlayingSameGame &&
+			A.DisplayName == B.DisplayName && A.RealName == B.RealName && PresenceMatches(A.PresenceInfo, B.PresenceInfo);
+	}
+}
+
+void UFriendsCacheSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	IOnlinePresencePtr Presence = Online::GetPresenceInterface();
+	if (Presence.IsValid())
+	{
+		PresenceReceivedHandle = Presence->AddOnPresenceReceivedDelegate_Handle(FOnPresenceReceivedDelegate::CreateUObject(this, &ThisClass::OnPresenceReceived));
+	}
+
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick), 1.0f);
+}
+
+void UFriendsCacheSubsystem::Deinitialize()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	IOnlinePresencePtr Presence = Online::GetPresenceInterface();
+	if (Presence.IsValid())
+	{
+		Presence->ClearOnPresenceReceivedDelegate_Handle(PresenceReceivedHandle);
+	}
+
+	IOnlineFriendsPtr Friends = Online::GetFriendsInterface();
+	for (TPair<int32, FFriendsList>& Pair : Lists)
+	{
+		if (Friends.IsValid())
+		{
+			Friends->ClearOnFriendsChangeDelegate_Handle(Pair.Key, Pair.Value.FriendsChangeHandle);
+		}
+
+		for (FOnFriendsCacheReady& OnReady : Pair.Value.Waiting)
+		{
+			OnReady.ExecuteIfBound(false);
+		}
+	}
+	Lists.Empty();
+
+	Super::Deinitialize();
+}
+
+UFriendsCacheSubsystem* UFriendsCacheSubsystem::Get(UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetSubsystem<UFriendsCacheSubsystem>() : nullptr;
+}
+
+UFriendsCacheSubsystem::FFriendsList& UFriendsCacheSubsystem::FindOrAddList(int32 LocalUserNum)
+{
+	if (FFriendsList* List = Lists.Find(LocalUserNum))
+	{
+		return *List;
+	}
+
+	FFriendsList& List = Lists.Add(LocalUserNum);
+
+	IOnlineFriendsPtr Friends = Online::GetFriendsInterface();
+	if (Friends.IsValid())
+	{
+		List.FriendsChangeHandle = Friends->AddOnFriendsChangeDelegate_Handle(LocalUserNum, FOnFriendsChangeDelegate::CreateUObject(this, &ThisClass::OnFriendsChanged, LocalUserNum));
+	}
+	return List;
+}
+
+void UFriendsCacheSubsystem::RequestFriendsList(int32 LocalUserNum, FOnFriendsCacheReady OnReady)
+{
+	FFriendsList& List = FindOrAddList(LocalUserNum);
+	if (List.bHasRead)
+	{
+		OnReady.ExecuteIfBound(true);
+		return;
+	}
+
+	List.Waiting.Add(MoveTemp(OnReady));
+	ReadFriendsList(LocalUserNum);
+}
+
+void UFriendsCacheSubsystem::RefreshFriendsList(int32 LocalUserNum)
+{
+	FindOrAddList(LocalUserNum);
+	ReadFriendsList(LocalUserNum);
+}
+
+void UFriendsCacheSubsystem::ReadFriendsList(int32 LocalUserNum)
+{
+	FFriendsList& List = Lists.FindChecked(LocalUserNum);
+	if (List.bReadInFlight)
+	{
+		return;
+	}
+
+	IOnlineFriendsPtr Friends = Online::GetFriendsInterface();
+	if (!Friends.IsValid())
+	{
+		UE_LOG(AdvancedGetFriendsLog, Warning, TEXT("FriendsCache - No friends interface"));
+		OnReadFriendsListCompleted(LocalUserNum, false, EFriendsLists::ToString(EFriendsLists::Default), FString());
+		return;
+	}
+
+	List.bReadInFlight = true;
+	List.LastReadTime = FPlatformTime::Seconds();
+	Friends->ReadFriendsList(LocalUserNum, EFriendsLists::ToString((EFriendsLists::Default)), FOnReadFriendsListComplete::CreateUObject(this, &ThisClass::OnReadFriendsListCompleted));
+}
+
+void UFriendsCacheSubsystem::OnReadFriendsListCompleted(int32 LocalUserNum, bool bWasSuccessful, const FString& ListName, const FString& ErrorString)
+{
+	FFriendsList* List = Lists.Find(LocalUserNum);
+	if (!List)
+	{
+		return;
+	}
+
+	List->bReadInFlight = false;
+
+	IOnlineFriendsPtr Friends = Online::GetFriendsInterface();
+	if (bWasSuccessful && Friends.IsValid())
+	{
+		TArray<TSharedRef<FOnlineFriend>> FriendList;
+		Friends->GetFriendsList(LocalUserNum, ListName, FriendList);
+		ApplyFriendsList(*List, FriendList);
+		List->bHasRead = true;
+	}
+	else
+	{
+		UE_LOG(AdvancedGetFriendsLog, Warning, TEXT("FriendsCache - Reading the friends list of user %d failed: %s"), LocalUserNum, *ErrorString);
+	}
+
+	// A failed refresh keeps the old list, so only the very first read can fail the callers
+	TArray<FOnFriendsCacheReady> Waiting = MoveTemp(List->Waiting);
+	const bool bHasRead = List->bHasRead;
+	for (FOnFriendsCacheReady& OnReady : Waiting)
+	{
+		OnReady.ExecuteIfBound(bHasRead);
+	}
+}
+
+void UFriendsCacheSubsystem::ApplyFriendsList(FFriendsList& List, const TArray<TSharedRef<FOnlineFriend>>& OnlineFriends)
+{
+	TSet<int32> SeenRows;
+	SeenRows.Reserve(OnlineFriends.Num());
+
+	FBPFriendInfo BPF;
+	for (const TSharedRef<FOnlineFriend>& Friend : OnlineFriends)
+	{
+		FriendsCache::MakeFriendInfo(*Friend, BPF);
+		FriendsCache::MakePresenceInfo(Friend->GetPresence(), BPF.PresenceInfo);
+
+		const FString Key = Friend->GetUserId()->ToString();
+		if (const int32* Row = List.RowOfFriend.Find(Key))
+		{
+			SeenRows.Add(*Row);
+			if (!FriendsCache::FriendMatches(List.Friends[*Row], BPF))
+			{
+				List.Friends[*Row] = BPF;
+				MarkRowChanged(List, *Row);
+			}
+		}
+		else
+		{
+			const int32 NewRow = List.Friends.Add(BPF);
+			List.RowVersions.Add(0);
+			List.RowOfFriend.Add(Key, NewRow);
+			SeenRows.Add(NewRow);
+			MarkRowChanged(List, NewRow);
+		}
+	}
+
+	// Remove friends that are gone, walking backwards so the rows moved into their place have been checked already
+	for (int32 Row = List.Friends.Num() - 1; Row >= 0; --Row)
+	{
+		if (SeenRows.Contains(Row))
+		{
+			continue;
+		}
+
+		List.RowOfFriend.Remove(List.Friends[Row].UniqueNetId.GetUniqueNetId()->ToString());
+
+		const int32 LastRow = List.Friends.Num() - 1;
+		List.Friends.RemoveAtSwap(Row, 1, false);
+		List.RowVersions.RemoveAtSwap(Row, 1, false);
+
+		if (Row != LastRow)
+		{
+			List.RowOfFriend.Add(List.Friends[Row].UniqueNetId.GetUniqueNetId()->ToString(), Row);
+			MarkRowChanged(List, Row);
+		}
+		else
+		{
+			++List.Version;
+		}
+	}
+}
+
+void UFriendsCacheSubsystem::OnPresenceReceived(const FUniqueNetId& UserId, const TSharedRef<FOnlineUserPresence>& Presence)
+{
+	const FString Key = UserId.ToString();
+
+	FBPFriendPresenceInfo PresenceInfo;
+	FriendsCache::MakePresenceInfo(*Presence, PresenceInfo);
+
+	for (TPair<int32, FFriendsList>& Pair : Lists)
+	{
+		FFriendsList& List = Pair.Value;
+		const int32* Row = List.RowOfFriend.Find(Key);
+		if (!Row || FriendsCache::PresenceMatches(List.Friends[*Row].PresenceInfo, PresenceInfo))
+		{
+			continue;
+		}
+
+		FBPFriendInfo& Friend = List.Friends[*Row];
+		Friend.PresenceInfo = PresenceInfo;
+		Friend.OnlineState = PresenceInfo.PresenceState;
+		Friend.bIsPlayingSameGame = PresenceInfo.bIsPlayingThisGame;
+		MarkRowChanged(List, *Row);
+	}
+}
+
+void UFriendsCacheSubsystem::OnFriendsChanged(int32 LocalUserNum)
+{
+	// Friends were added or removed, read again and let the diff find which
+	ReadFriendsList(LocalUserNum);
+}
+
+bool UFriendsCacheSubsystem::Tick(float DeltaTime)
+{
+	if (FullRefreshInterval > 0.f)
+	{
+		const double Now = FPlatformTime::Seconds();
+		for (TPair<int32, FFriendsList>& Pair : Lists)
+		{
+			if (Pair.Value.bHasRead && Now - Pair.Value.LastReadTime >= FullRefreshInterval)
+			{
+				ReadFriendsList(Pair.Key);
+			}
+		}
+	}
+	return true;
+}
+
+void UFriendsCacheSubsystem::MarkRowChanged(FFriendsList& List, int32 Row)
+{
+	List.RowVersions[Row] = ++List.Version;
+}
+
+bool UFriendsCacheSubsystem::HasFriendsList(int32 LocalUserNum) const
+{
+	const FFriendsList* List = Lists.Find(LocalUserNum);
+	return List && List->bHasRead;
+}
+
+const TArray<FBPFriendInfo>& UFriendsCacheSubsystem::GetCachedFriends(int32 LocalUserNum) const
+{
+	const FFriendsList* List = Lists.Find(LocalUserNum);
+	return List ? List->Friends : FriendsCache::EmptyFriends;
+}
+
+int32 UFriendsCacheSubsystem::GetFriendsListVersion(int32 LocalUserNum) const
+{
+	const FFriendsList* List = Lists.Find(LocalUserNum);
+	return List ? List->Version : 0;
+}
+
+void UFriendsCacheSubsystem::GetChangedFriendRows(int32 LocalUserNum, int32 SinceVersion, TArray<int32>& ChangedRows, int32& NumRows, int32& CurrentVersion) const
+{
+	ChangedRows.Reset();
+	NumRows = 0;
+	CurrentVersion = 0;
+
+	const FFriendsList* List = Lists.Find(LocalUserNum);
+	if (!List)
+	{
+		return;
+	}
+
+	NumRows = List->Friends.Num();
+	CurrentVersion = List->Version;
+	if (SinceVersion >= List->Version)
+	{
+		return;
+	}
+
+	for (int32 Row = 0; Row < List->RowVersions.Num(); ++Row)
+	{
+		if (List->RowVersions[Row] > SinceVersion)
+		{
+			ChangedRows.Add(Row);
+		}
+	}
+}
+
+bool UFriendsCacheSubsystem::FindFriendRow(int32 LocalUserNum, const FBPUniqueNetId& FriendId, int32& Row) const
+{
+	Row = INDEX_NONE;
+
+	const FFriendsList* List = Lists.Find(LocalUserNum);
+	if (!List || !FriendId.IsValid())
+	{
+		return false;
+	}
+
+	if (const int32* FoundRow = List->RowOfFriend.Find(FriendId.GetUniqueNetId()->ToString()))
+	{
+		Row = *FoundRow;
+		return true;
+	}
+	return false;
+}
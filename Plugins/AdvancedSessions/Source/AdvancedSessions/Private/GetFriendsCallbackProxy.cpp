@@ -1,5 +1,6 @@
 // Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
 #include "GetFriendsCallbackProxy.h"
+#include "FriendsCacheSubsystem.h"
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -8,7 +9,7 @@ DEFINE_LOG_CATEGORY(AdvancedGetFriendsLog);
 
 UGetFriendsCallbackProxy::UGetFriendsCallbackProxy(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
-	, FriendListReadCompleteDelegate(FOnReadFriendsListComplete::CreateUObject(this, &ThisClass::OnReadFriendsListCompleted))
+	, LocalUserNum(0)
 {
 }
 
@@ -31,12 +32,13 @@ void UGetFriendsCallbackProxy::Activate()
 		return;
 	}
 
-	IOnlineFriendsPtr Friends = Online::GetFriendsInterface();
-	if (Friends.IsValid())
-	{	
-		ULocalPlayer* Player = Cast<ULocalPlayer>(PlayerControllerWeakPtr->Player);
-
-		Friends->ReadFriendsList(Player->GetControllerId(), EFriendsLists::ToString((EFriendsLists::Default)), FriendListReadCompleteDelegate);
+	ULocalPlayer* Player = Cast<ULocalPlayer>(PlayerControllerWeakPtr->Player);
+	UFriendsCacheSubsystem* FriendsCache = UFriendsCacheSubsystem::Get(WorldContextObject);
+	if (Player && FriendsCache)
+	{
+		// Served from the cache after the first read, OnFriendsCacheReady will get called, possibly right away
+		LocalUserNum = Player->GetControllerId();
+		FriendsCache->RequestFriendsList(LocalUserNum, FOnFriendsCacheReady::CreateUObject(this, &ThisClass::OnFriendsCacheReady));
 		return;
 	}
 
@@ -46,45 +48,12 @@ void UGetFriendsCallbackProxy::Activate()
 	OnFailure.Broadcast(EmptyArray);
 }
 
-void UGetFriendsCallbackProxy::OnReadFriendsListCompleted(int32 LocalUserNum, bool bWasSuccessful, const FString& ListName, const FString& ErrorString)
+void UGetFriendsCallbackProxy::OnFriendsCacheReady(bool bWasSuccessful)
 {
-	if (bWasSuccessful)
+	UFriendsCacheSubsystem* FriendsCache = UFriendsCacheSubsystem::Get(WorldContextObject);
+	if (bWasSuccessful && FriendsCache)
 	{
-		IOnlineFriendsPtr Friends = Online::GetFriendsInterface();
-		if (Friends.IsValid())
-		{
-			// Not actually needed anymore, plus was not being validated and causing a crash
-			//ULocalPlayer* Player = Cast<ULocalPlayer>(PlayerControllerWeakPtr->Player);
-
-			TArray<FBPFriendInfo> FriendsListOut;
-			TArray< TSharedRef<FOnlineFriend> > FriendList;
-			Friends->GetFriendsList(LocalUserNum, ListName, FriendList);
-
-			for (int32 i = 0; i < FriendList.Num(); i++)
-			{
-				TSharedRef<FOnlineFriend> Friend = FriendList[i];
-				FBPFriendInfo BPF;
-				FOnlineUserPresence pres = Friend->GetPresence();
-				BPF.OnlineState = ((EBPOnlinePresenceState)((int32)pres.Status.State));
-				BPF.DisplayName = Friend->GetDisplayName();
-				BPF.RealName = Friend->GetRealName();
-				BPF.UniqueNetId.SetUniqueNetId(Friend->GetUserId());
-				BPF.bIsPlayingSameGame = pres.bIsPlayingThisGame;
-
-				BPF.PresenceInfo.bIsOnline = pres.bIsOnline;
-				BPF.PresenceInfo.bHasVoiceSupport = pres.bHasVoiceSupport;
-				BPF.PresenceInfo.bIsPlaying = pres.bIsPlaying;
-				BPF.PresenceInfo.PresenceState = ((EBPOnlinePresenceState)((int32)pres.Status.State));
-				BPF.PresenceInfo.StatusString = pres.Status.StatusStr;
-				BPF.PresenceInfo.bIsJoinable = pres.bIsJoinable;
-				BPF.PresenceInfo.bIsPlayingThisGame = pres.bIsPlayingThisGame;
-
-
-				FriendsListOut.Add(BPF);
-			}
-
-			OnSuccess.Broadcast(FriendsListOut);
-		}
+		OnSuccess.Broadcast(FriendsCache->GetCachedFriends(LocalUserNum));
 	}
 	else
 	{
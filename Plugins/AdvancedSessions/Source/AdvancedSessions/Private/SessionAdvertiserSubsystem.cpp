@@ -0,0 +1,213 @@
+#include "SessionAdvertiserSubsystem.h"
+#include "AdvancedSessionsLibrary.h"
+#include "Engine/GameInstance.h"
+#include "TimerManager.h"
+
+void USessionAdvertiserSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	IOnlineSessionPtr Sessions = Online::GetSessionInterface(GetGameInstance()->GetWorld());
+	if (Sessions.IsValid())
+	{
+		UpdateCompleteHandle = Sessions->AddOnUpdateSessionCompleteDelegate_Handle(FOnUpdateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnUpdateSessionComplete));
+	}
+}
+
+void USessionAdvertiserSubsystem::Deinitialize()
+{
+	GetGameInstance()->GetTimerManager().ClearTimer(FlushTimer);
+
+	IOnlineSessionPtr Sessions = Online::GetSessionInterface(GetGameInstance()->GetWorld());
+	if (Sessions.IsValid())
+	{
+		Sessions->ClearOnUpdateSessionCompleteDelegate_Handle(UpdateCompleteHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+void USessionAdvertiserSubsystem::SetAdvertisedSetting(const FSessionPropertyKeyPair& Setting)
+{
+	const bool bWasPending = PendingSettings.Contains(Setting.Key);
+	if (!PendingSettings.Set(Setting.Key, Setting.Data))
+	{
+		return;
+	}
+
+	++Stats.ChangesQueued;
+	if (bWasPending)
+	{
+		++Stats.ChangesCoalesced;
+	}
+
+	ScheduleFlush();
+}
+
+void USessionAdvertiserSubsystem::SetAdvertisedSettings(const TArray<FSessionPropertyKeyPair>& Settings)
+{
+	for (const FSessionPropertyKeyPair& Setting : Settings)
+	{
+		SetAdvertisedSetting(Setting);
+	}
+}
+
+void USessionAdvertiserSubsystem::FlushNow()
+{
+	GetGameInstance()->GetTimerManager().ClearTimer(FlushTimer);
+
+	if (!bUpdateInFlight)
+	{
+		Flush();
+	}
+	else
+	{
+		// The completion sends whatever is pending without waiting out the interval
+		bFlushRequested = true;
+	}
+}
+
+void USessionAdvertiserSubsystem::ScheduleFlush()
+{
+	FTimerManager& TimerManager = GetGameInstance()->GetTimerManager();
+	if (TimerManager.IsTimerActive(FlushTimer) || PendingSettings.IsEmpty())
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (bUpdateInFlight)
+	{
+		if (Now - LastSendTime < UpdateTimeoutSeconds)
+		{
+			// The completion schedules the next flush
+			return;
+		}
+
+		UE_LOG(AdvancedSessionsLog, Warning, TEXT("SessionAdvertiser - Update of %s never completed, sending the next one anyway"), *SessionName.ToString());
+		++Stats.UpdatesTimedOut;
+		bUpdateInFlight = false;
+		RequeueSentSettings();
+	}
+
+	// Wait out the rest of the interval, at least until next tick so changes made this frame go together
+	const float Delay = LastSendTime > 0.0 && !bFlushRequested ? FMath::Max(0.f, (float)(LastSendTime + MinUpdateInterval - Now)) : 0.f;
+	if (Delay > 0.f)
+	{
+		TimerManager.SetTimer(FlushTimer, this, &ThisClass::Flush, Delay, false);
+	}
+	else
+	{
+		FlushTimer = TimerManager.SetTimerForNextTick(this, &ThisClass::Flush);
+	}
+}
+
+void USessionAdvertiserSubsystem::Flush()
+{
+	FlushTimer.Invalidate();
+	bFlushRequested = false;
+
+	if (PendingSettings.IsEmpty() || bUpdateInFlight)
+	{
+		return;
+	}
+
+	IOnlineSessionPtr Sessions = Online::GetSessionInterface(GetGameInstance()->GetWorld());
+	const FOnlineSessionSettings* LiveSettings = Sessions.IsValid() ? Sessions->GetSessionSettings(SessionName) : nullptr;
+
+	if (!LiveSettings)
+	{
+		UE_LOG(AdvancedSessionsLog, Verbose, TEXT("SessionAdvertiser - No session %s, dropping %d settings"), *SessionName.ToString(), PendingSettings.GetSettings().Num());
+		Stats.ChangesDropped += PendingSettings.GetSettings().Num();
+		PendingSettings.Reset();
+		return;
+	}
+
+	// The live settings only change once the update goes through, so a failed one is never mistaken for advertised
+	SentSessionSettings = *LiveSettings;
+	SentSettings = PendingSettings.GetSettings();
+	PendingSettings.Reset();
+
+	FSessionSettingsBuilder::ApplyToSessionSettings(SentSessionSettings, SentSettings);
+
+	// Everything queued was already advertised
+	if (FSessionSettingsBuilder::MatchesPushedSettings(SessionName, SentSessionSettings))
+	{
+		SentSettings.Reset();
+		return;
+	}
+
+	bUpdateInFlight = true;
+	LastSendTime = FPlatformTime::Seconds();
+	++Stats.UpdatesSent;
+
+	if (!Sessions->UpdateSession(SessionName, SentSessionSettings, bRefreshOnlineData))
+	{
+		// Some subsystems fail without calling the delegate
+		if (bUpdateInFlight)
+		{
+			OnUpdateSessionComplete(SessionName, false);
+		}
+	}
+}
+
+void USessionAdvertiserSubsystem::OnUpdateSessionComplete(FName InSessionName, bool bWasSuccessful)
+{
+	// Updates started elsewhere report through the same delegate
+	if (!bUpdateInFlight || InSessionName != SessionName)
+	{
+		return;
+	}
+
+	bUpdateInFlight = false;
+
+	Stats.LastLatencyMs = (float)((FPlatformTime::Seconds() - LastSendTime) * 1000.0);
+	Stats.MaxLatencyMs = FMath::Max(Stats.MaxLatencyMs, Stats.LastLatencyMs);
+	++NumLatencySamples;
+	Stats.AverageLatencyMs += (Stats.LastLatencyMs - Stats.AverageLatencyMs) / NumLatencySamples;
+
+	if (bWasSuccessful)
+	{
+		FSessionSettingsBuilder::RecordPushedSettings(SessionName, SentSessionSettings);
+		SentSettings.Reset();
+	}
+	else
+	{
+		++Stats.UpdatesFailed;
+		UE_LOG(AdvancedSessionsLog, Warning, TEXT("SessionAdvertiser - Update of %s failed after %.0f ms, retrying it with the next update"), *SessionName.ToString(), Stats.LastLatencyMs);
+		RequeueSentSettings();
+	}
+
+	ScheduleFlush();
+}
+
+void USessionAdvertiserSubsystem::RequeueSentSettings()
+{
+	for (const FSessionPropertyKeyPair& Setting : SentSettings)
+	{
+		if (!PendingSettings.Contains(Setting.Key))
+		{
+			PendingSettings.Set(Setting.Key, Setting.Data);
+		}
+	}
+
+	SentSettings.Reset();
+}
+
+static FAutoConsoleCommandWithWorld SessionAdvertiserStatsCommand(
+	TEXT("AdvancedSessions.AdvertiserStats"),
+	TEXT("Logs the session advertiser's update counts and latency"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		USessionAdvertiserSubsystem* Advertiser = GameInstance ? GameInstance->GetSubsystem<USessionAdvertiserSubsystem>() : nullptr;
+		if (!Advertiser)
+		{
+			return;
+		}
+
+		const FBPSessionAdvertiserStats& Stats = Advertiser->GetStats();
+		UE_LOG(AdvancedSessionsLog, Display, TEXT("SessionAdvertiser - queued %d, coalesced %d, dropped %d, sent %d, failed %d, timed out %d, latency last %.0f avg %.0f max %.0f ms"),
+			Stats.ChangesQueued, Stats.ChangesCoalesced, Stats.ChangesDropped, Stats.UpdatesSent, Stats.UpdatesFailed, Stats.UpdatesTimedOut,
+			Stats.LastLatencyMs, Stats.AverageLatencyMs, Stats.MaxLatencyMs);
+	}));
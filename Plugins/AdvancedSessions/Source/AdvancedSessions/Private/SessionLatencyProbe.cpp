@@ -0,0 +1,484 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+#include "SessionLatencyProbe.h"
+#include "AdvancedSessionsLibrary.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Common/UdpSocketReceiver.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "Misc/AutomationTest.h"
+
+namespace SessionLatencyProbe
+{
+	// 'LTQS', lets the echo server ignore anything that isn't a probe
+	static const uint32 PacketMagic = 0x5351544C;
+
+	// 'LTQR', answers carry this instead so an echo server never answers another one
+	static const uint32 AnswerMagic = 0x5251544C;
+
+	struct FProbePacket
+	{
+		uint32 Magic;
+		uint16 TargetIndex;
+		uint16 Sequence;
+	};
+
+	// Sessions the subsystem couldn't ping report this, they sort after everything else
+	static const int32 UnreachablePing = 9999;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSessionQosEchoServer
+
+static FSessionQosEchoServer* GSessionQosEchoServer = nullptr;
+
+FSessionQosEchoServer& FSessionQosEchoServer::Get()
+{
+	if (!GSessionQosEchoServer)
+	{
+		GSessionQosEchoServer = new FSessionQosEchoServer();
+	}
+	return *GSessionQosEchoServer;
+}
+
+void FSessionQosEchoServer::Shutdown()
+{
+	// Before the socket subsystem goes, rather than during static destruction
+	delete GSessionQosEchoServer;
+	GSessionQosEchoServer = nullptr;
+}
+
+FSessionQosEchoServer::~FSessionQosEchoServer()
+{
+	Stop();
+}
+
+bool FSessionQosEchoServer::Start(int32 Port)
+{
+	Stop();
+
+	Socket = FUdpSocketBuilder(TEXT("SessionQosEcho"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToPort(Port)
+		.WithReceiveBufferSize(64 * 1024)
+		.WithSendBufferSize(64 * 1024);
+
+	if (!Socket)
+	{
+		UE_LOG(AdvancedSessionsLog, Warning, TEXT("SessionQosEcho - Couldn't bind UDP port %d"), Port);
+		return false;
+	}
+
+	// Answers go out from the receiver thread, the socket is only ever used by it once started
+	FSocket* EchoSocket = Socket;
+	Receiver = new FUdpSocketReceiver(Socket, FTimespan::FromMilliseconds(100), TEXT("SessionQosEchoReceiver"));
+	Receiver->OnDataReceived().BindLambda([EchoSocket](const FArrayReaderPtr& Data, const FIPv4Endpoint& Sender)
+	{
+		SessionLatencyProbe::FProbePacket Packet;
+		if (Data->Num() != sizeof(Packet))
+		{
+			return;
+		}
+
+		FMemory::Memcpy(&Packet, Data->GetData(), sizeof(Packet));
+		if (Packet.Magic != SessionLatencyProbe::PacketMagic)
+		{
+			return;
+		}
+
+		Packet.Magic = SessionLatencyProbe::AnswerMagic;
+
+		int32 BytesSent = 0;
+		EchoSocket->SendTo((const uint8*)&Packet, sizeof(Packet), BytesSent, *Sender.ToInternetAddr());
+	});
+	Receiver->Start();
+
+	UE_LOG(AdvancedSessionsLog, Log, TEXT("SessionQosEcho - Answering latency probes on UDP port %d"), Port);
+	return true;
+}
+
+void FSessionQosEchoServer::Stop()
+{
+	if (IOnlineSessionPtr Sessions = BoundSessions.Pin())
+	{
+		Sessions->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionHandle);
+	}
+	BoundSessions.Reset();
+	BoundSessionName = NAME_None;
+
+	if (Receiver)
+	{
+		// Joins the receiver thread so the socket is no longer in use below
+		delete Receiver;
+		Receiver = nullptr;
+	}
+
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
+
+void FSessionQosEchoServer::StopWithSession(const IOnlineSessionPtr& Sessions, FName SessionName)
+{
+	if (IOnlineSessionPtr OldSessions = BoundSessions.Pin())
+	{
+		OldSessions->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionHandle);
+	}
+
+	BoundSessions = Sessions;
+	BoundSessionName = SessionName;
+
+	if (Sessions.IsValid())
+	{
+		DestroySessionHandle = Sessions->AddOnDestroySessionCompleteDelegate_Handle(FOnDestroySessionCompleteDelegate::CreateRaw(this, &FSessionQosEchoServer::OnDestroySessionComplete));
+	}
+}
+
+void FSessionQosEchoServer::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if (SessionName == BoundSessionName)
+	{
+		UE_LOG(AdvancedSessionsLog, Log, TEXT("SessionQosEcho - %s was destroyed, no longer answering latency probes"), *SessionName.ToString());
+		Stop();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UProbeSessionLatencyCallbackProxy
+
+UProbeSessionLatencyCallbackProxy::UProbeSessionLatencyCallbackProxy(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, Socket(nullptr)
+	, NextTarget(0)
+	, QosPort(0)
+	, MaxInFlight(8)
+	, ProbesPerSession(3)
+	, TimeoutSeconds(1.0f)
+	, WorldContextObject(nullptr)
+{
+}
+
+UProbeSessionLatencyCallbackProxy* UProbeSessionLatencyCallbackProxy::ProbeSessionLatency(UObject* WorldContextObject, const TArray<FBlueprintSessionResult>& SessionResults, int32 QosPort, int32 MaxInFlight, int32 ProbesPerSession, float TimeoutSeconds)
+{
+	UProbeSessionLatencyCallbackProxy* Proxy = NewObject<UProbeSessionLatencyCallbackProxy>();
+	Proxy->WorldContextObject = WorldContextObject;
+	Proxy->QosPort = QosPort;
+	Proxy->MaxInFlight = FMath::Max(1, MaxInFlight);
+	Proxy->ProbesPerSession = FMath::Clamp(ProbesPerSession, 1, (int32)MAX_uint16);
+	Proxy->TimeoutSeconds = FMath::Max(0.05f, TimeoutSeconds);
+
+	Proxy->Results.Reserve(SessionResults.Num());
+	for (const FBlueprintSessionResult& SessionResult : SessionResults)
+	{
+		FBPSessionLatency& Result = Proxy->Results.AddDefaulted_GetRef();
+		Result.SessionResult = SessionResult;
+		Result.RoundTripMs = SessionResult.OnlineResult.PingInMs;
+	}
+
+	return Proxy;
+}
+
+bool UProbeSessionLatencyCallbackProxy::StartQosEchoServer(int32 QosPort)
+{
+	return FSessionQosEchoServer::Get().Start(QosPort);
+}
+
+void UProbeSessionLatencyCallbackProxy::StopQosEchoServer()
+{
+	FSessionQosEchoServer::Shutdown();
+}
+
+void UProbeSessionLatencyCallbackProxy::Activate()
+{
+	FOnlineSubsystemBPCallHelperAdvanced Helper(TEXT("ProbeSessionLatency"), GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull));
+
+	IOnlineSessionPtr Sessions = Helper.OnlineSub ? Helper.OnlineSub->GetSessionInterface() : nullptr;
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+	if (!Sessions.IsValid() || !SocketSubsystem || Results.Num() > MAX_uint16)
+	{
+		Finish(false);
+		return;
+	}
+
+	// Resolve every host up front, results without a plain address keep their reported ping
+	Targets.SetNum(Results.Num());
+	int32 NumProbed = 0;
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		FString ConnectString;
+		if (!Sessions->GetResolvedConnectString(Results[Index].SessionResult.OnlineResult, NAME_GamePort, ConnectString))
+		{
+			continue;
+		}
+
+		FString Host = ConnectString;
+		ConnectString.Split(TEXT(":"), &Host, nullptr, ESearchCase::IgnoreCase, ESearchDir::FromEnd);
+
+		bool bIsValid = false;
+		TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+		Address->SetIp(*Host, bIsValid);
+		if (bIsValid)
+		{
+			Address->SetPort(QosPort);
+			Targets[Index].Address = Address;
+			Targets[Index].RoundTrips.Reserve(ProbesPerSession);
+			++NumProbed;
+		}
+	}
+
+	if (NumProbed == 0)
+	{
+		Finish(true);
+		return;
+	}
+
+	Socket = FUdpSocketBuilder(TEXT("SessionLatencyProbe")).AsNonBlocking().WithReceiveBufferSize(64 * 1024);
+	if (!Socket)
+	{
+		Finish(false);
+		return;
+	}
+
+	UE_LOG(AdvancedSessionsLog, Verbose, TEXT("ProbeSessionLatency - Probing %d of %d sessions, %d in flight"), NumProbed, Results.Num(), MaxInFlight);
+
+	// Keep ourselves alive until the ticker lets go of us
+	AddToRoot();
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick));
+}
+
+bool UProbeSessionLatencyCallbackProxy::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	ReceiveAnswers(Now);
+
+	int32 InFlight = 0;
+	bool bAnyRemaining = false;
+	for (FProbeTarget& Target : Targets)
+	{
+		if (Target.SentTime > 0.0)
+		{
+			if (Now - Target.SentTime > TimeoutSeconds)
+			{
+				// Lost, the next probe goes out under a new sequence number so a late answer is ignored
+				Target.SentTime = 0.0;
+			}
+			else
+			{
+				++InFlight;
+			}
+		}
+
+		bAnyRemaining |= Target.Address.IsValid() && (Target.SentTime > 0.0 || Target.ProbesSent < ProbesPerSession);
+	}
+
+	if (!bAnyRemaining)
+	{
+		Finish(true);
+		return false;
+	}
+
+	// Fill the window, walking the list from where the last tick stopped
+	for (int32 Visited = 0; Visited < Targets.Num() && InFlight < MaxInFlight; ++Visited)
+	{
+		const int32 Index = NextTarget;
+		NextTarget = (NextTarget + 1) % Targets.Num();
+
+		FProbeTarget& Target = Targets[Index];
+		if (!Target.Address.IsValid() || Target.SentTime > 0.0 || Target.ProbesSent >= ProbesPerSession)
+		{
+			continue;
+		}
+
+		SessionLatencyProbe::FProbePacket Packet;
+		Packet.Magic = SessionLatencyProbe::PacketMagic;
+		Packet.TargetIndex = (uint16)Index;
+		Packet.Sequence = (uint16)(++Target.ProbesSent);
+
+		int32 BytesSent = 0;
+		if (Socket->SendTo((const uint8*)&Packet, sizeof(Packet), BytesSent, *Target.Address))
+		{
+			Target.SentTime = Now;
+			++InFlight;
+		}
+	}
+
+	return true;
+}
+
+void UProbeSessionLatencyCallbackProxy::ReceiveAnswers(double Now)
+{
+	TSharedRef<FInternetAddr> Sender = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	SessionLatencyProbe::FProbePacket Packet;
+	int32 BytesRead = 0;
+
+	while (Socket->RecvFrom((uint8*)&Packet, sizeof(Packet), BytesRead, *Sender))
+	{
+		if (BytesRead != sizeof(Packet) || Packet.Magic != SessionLatencyProbe::AnswerMagic || !Targets.IsValidIndex(Packet.TargetIndex))
+		{
+			continue;
+		}
+
+		FProbeTarget& Target = Targets[Packet.TargetIndex];
+		if (Target.SentTime > 0.0 && Packet.Sequence == Target.ProbesSent && Target.Address.IsValid() && *Sender == *Target.Address)
+		{
+			Target.RoundTrips.Add(Now - Target.SentTime);
+			Target.SentTime = 0.0;
+		}
+	}
+}
+
+void UProbeSessionLatencyCallbackProxy::Finish(bool bSuccess)
+{
+	if (TickerHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+		RemoveFromRoot();
+	}
+
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	for (int32 Index = 0; Index < Targets.Num(); ++Index)
+	{
+		TArray<double>& RoundTrips = Targets[Index].RoundTrips;
+		if (RoundTrips.Num() == 0)
+		{
+			continue;
+		}
+
+		// Jitter follows probe order, so take it before sorting for the median
+		double JitterTotal = 0.0;
+		for (int32 Sample = 1; Sample < RoundTrips.Num(); ++Sample)
+		{
+			JitterTotal += FMath::Abs(RoundTrips[Sample] - RoundTrips[Sample - 1]);
+		}
+
+		RoundTrips.Sort();
+
+		FBPSessionLatency& Result = Results[Index];
+		Result.bMeasured = true;
+		Result.ProbesAnswered = RoundTrips.Num();
+		Result.RoundTripMs = FMath::RoundToInt(RoundTrips[RoundTrips.Num() / 2] * 1000.0);
+		Result.JitterMs = RoundTrips.Num() > 1 ? FMath::RoundToInt(JitterTotal / (RoundTrips.Num() - 1) * 1000.0) : 0;
+		Result.SessionResult.OnlineResult.PingInMs = Result.RoundTripMs;
+	}
+
+	// Probed hosts that never answered are likely unreachable on this route, push them behind everything that did
+	for (int32 Index = 0; Index < Targets.Num(); ++Index)
+	{
+		if (Targets[Index].Address.IsValid() && !Results[Index].bMeasured)
+		{
+			Results[Index].RoundTripMs = SessionLatencyProbe::UnreachablePing;
+		}
+	}
+
+	Targets.Empty();
+
+	Results.StableSort([](const FBPSessionLatency& A, const FBPSessionLatency& B)
+	{
+		return A.RoundTripMs < B.RoundTripMs;
+	});
+
+	if (bSuccess)
+	{
+		OnSuccess.Broadcast(Results);
+	}
+	else
+	{
+		OnFailure.Broadcast(Results);
+	}
+}
+
+void UProbeSessionLatencyCallbackProxy::BeginDestroy()
+{
+	if (Socket)
+	{
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	Super::BeginDestroy();
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionQosEchoServerTest, "AdvancedSessions.QosEchoServer", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Sends packets to an echo server on the loopback address and checks only the probe is answered
+bool FSessionQosEchoServerTest::RunTest(const FString& Parameters)
+{
+	// Away from the default QoS port so a host running in the same process isn't disturbed
+	const int32 TestPort = 17787;
+
+	FSessionQosEchoServer EchoServer;
+	if (!TestTrue(TEXT("Echo server binds its port"), EchoServer.Start(TestPort)))
+	{
+		return false;
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FSocket* ClientSocket = FUdpSocketBuilder(TEXT("SessionQosEchoTest")).AsNonBlocking();
+	if (!TestNotNull(TEXT("Client socket is created"), ClientSocket))
+	{
+		return false;
+	}
+
+	bool bIsValid = false;
+	TSharedRef<FInternetAddr> ServerAddress = SocketSubsystem->CreateInternetAddr();
+	ServerAddress->SetIp(TEXT("127.0.0.1"), bIsValid);
+	ServerAddress->SetPort(TestPort);
+
+	SessionLatencyProbe::FProbePacket Sent;
+	Sent.Magic = SessionLatencyProbe::PacketMagic;
+	Sent.TargetIndex = 3;
+	Sent.Sequence = 7;
+
+	// Neither of these is a probe, the first thing echoed back has to be the probe below
+	SessionLatencyProbe::FProbePacket Answer = Sent;
+	Answer.Magic = SessionLatencyProbe::AnswerMagic;
+	const uint8 Junk[] = { 1, 2, 3 };
+
+	int32 BytesSent = 0;
+	ClientSocket->SendTo((const uint8*)&Answer, sizeof(Answer), BytesSent, *ServerAddress);
+	ClientSocket->SendTo(Junk, sizeof(Junk), BytesSent, *ServerAddress);
+
+	TestTrue(TEXT("Probe is sent"), ClientSocket->SendTo((const uint8*)&Sent, sizeof(Sent), BytesSent, *ServerAddress) && BytesSent == sizeof(Sent));
+
+	// The receiver thread waits up to 100ms per read, allow it a few rounds
+	SessionLatencyProbe::FProbePacket Received;
+	FMemory::Memzero(Received);
+	int32 BytesRead = 0;
+	TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
+	const double Deadline = FPlatformTime::Seconds() + 2.0;
+	while (!ClientSocket->RecvFrom((uint8*)&Received, sizeof(Received), BytesRead, *Sender) && FPlatformTime::Seconds() < Deadline)
+	{
+		FPlatformProcess::Sleep(0.01f);
+	}
+
+	TestEqual(TEXT("Whole probe is echoed"), BytesRead, (int32)sizeof(Sent));
+	TestEqual(TEXT("Echo is marked as an answer"), Received.Magic, SessionLatencyProbe::AnswerMagic);
+	TestEqual(TEXT("Echo keeps the target index"), Received.TargetIndex, Sent.TargetIndex);
+	TestEqual(TEXT("Echo keeps the sequence"), Received.Sequence, Sent.Sequence);
+	TestTrue(TEXT("Echo comes from the server"), *Sender == *ServerAddress);
+
+	ClientSocket->Close();
+	SocketSubsystem->DestroySocket(ClientSocket);
+
+	EchoServer.Stop();
+	TestFalse(TEXT("Stopped echo server isn't running"), EchoServer.IsRunning());
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,462 @@
+#include "SessionSearchCache.h"
+#include "AdvancedSessionsLibrary.h"
+#include "OnlineSubsystem.h"
+#include "OnlineSubsystemModule.h"
+#include "OnlineSessionSettings.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "Misc/AutomationTest.h"
+
+static FSessionSearchCache* GSessionSearchCache = nullptr;
+
+FSessionSearchCache& FSessionSearchCache::Get()
+{
+	if (!GSessionSearchCache)
+	{
+		GSessionSearchCache = new FSessionSearchCache();
+	}
+	return *GSessionSearchCache;
+}
+
+void FSessionSearchCache::Shutdown()
+{
+	// The results hold session infos owned by the online subsystem modules, release them while those are still loaded
+	delete GSessionSearchCache;
+	GSessionSearchCache = nullptr;
+}
+
+FString FSessionSearchCache::MakeKey(const FOnlineSessionSearch& Search, EBPServerPresenceSearchType ServerSearchType)
+{
+	FString Key = FString::Printf(TEXT("LAN=%d;Type=%d;Max=%d"), Search.bIsLanQuery ? 1 : 0, (int32)ServerSearchType, Search.MaxSearchResults);
+
+	// Map order isn't stable so sort the params to get the same key for the same settings
+	TArray<FName> ParamNames;
+	Search.QuerySettings.SearchParams.GetKeys(ParamNames);
+	ParamNames.Sort(FNameLexicalLess());
+
+	for (const FName& ParamName : ParamNames)
+	{
+		const FOnlineSessionSearchParam& Param = Search.QuerySettings.SearchParams.FindChecked(ParamName);
+		Key += FString::Printf(TEXT(";%s%s%s"), *ParamName.ToString(), EOnlineComparisonOp::ToString(Param.ComparisonOp), *Param.Data.ToString());
+	}
+
+	return Key;
+}
+
+const FSessionSearchCacheEntry* FSessionSearchCache::Find(const FString& Key) const
+{
+	check(IsInGameThread());
+
+	return Entries.Find(Key);
+}
+
+bool FSessionSearchCache::TryBeginRefresh(const FString& Key)
+{
+	check(IsInGameThread());
+
+	const double Now = FPlatformTime::Seconds();
+	double& StartedTime = RefreshStartedTimes.FindOrAdd(Key);
+
+	if (StartedTime > 0.0 && Now - StartedTime < RefreshTimeoutSeconds)
+		return false;
+
+	StartedTime = Now;
+	return true;
+}
+
+void FSessionSearchCache::EndRefresh(const FString& Key)
+{
+	check(IsInGameThread());
+
+	RefreshStartedTimes.Remove(Key);
+}
+
+void FSessionSearchCache::Store(const FString& Key, const TArray<FBlueprintSessionResult>& Results, TArray<FBlueprintSessionResult>* OutAdded, TArray<FBlueprintSessionResult>* OutRemoved)
+{
+	check(IsInGameThread());
+
+	FSessionSearchCacheEntry* Entry = Entries.Find(Key);
+
+	if (!Entry)
+	{
+		// Make room by dropping the oldest search
+		if (Entries.Num() >= MaxEntries)
+		{
+			const FString* OldestKey = nullptr;
+			double OldestTime = TNumericLimits<double>::Max();
+
+			for (const TPair<FString, FSessionSearchCacheEntry>& Pair : Entries)
+			{
+				if (Pair.Value.StoredTime < OldestTime)
+				{
+					OldestTime = Pair.Value.StoredTime;
+					OldestKey = &Pair.Key;
+				}
+			}
+
+			if (OldestKey)
+			{
+				Entries.Remove(FString(*OldestKey));
+			}
+		}
+
+		Entry = &Entries.Add(Key);
+	}
+
+	if (OutAdded || OutRemoved)
+	{
+		TSet<FString> OldIds;
+		OldIds.Reserve(Entry->Results.Num());
+
+		for (const FBlueprintSessionResult& Result : Entry->Results)
+		{
+			OldIds.Add(Result.OnlineResult.GetSessionIdStr());
+		}
+
+		TSet<FString> NewIds;
+		NewIds.Reserve(Results.Num());
+
+		for (const FBlueprintSessionResult& Result : Results)
+		{
+			const FString Id = Result.OnlineResult.GetSessionIdStr();
+			NewIds.Add(Id);
+
+			if (OutAdded && !OldIds.Contains(Id))
+			{
+				OutAdded->Add(Result);
+			}
+		}
+
+		if (OutRemoved)
+		{
+			for (const FBlueprintSessionResult& Result : Entry->Results)
+			{
+				if (!NewIds.Contains(Result.OnlineResult.GetSessionIdStr()))
+				{
+					OutRemoved->Add(Result);
+				}
+			}
+		}
+	}
+
+	Entry->Results = Results;
+	Entry->StoredTime = FPlatformTime::Seconds();
+
+	RefreshStartedTimes.Remove(Key);
+
+	UE_LOG(AdvancedSessionsLog, Verbose, TEXT("Session search cache stored %d results for %s"), Results.Num(), *Key);
+}
+
+void FSessionSearchCache::Empty()
+{
+	check(IsInGameThread());
+
+	Entries.Empty();
+	RefreshStartedTimes.Empty();
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionSearchCacheTest, "AdvancedSessions.SessionSearchCache", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Checks keys, refresh tracking and eviction, none of which need real search results
+bool FSessionSearchCacheTest::RunTest(const FString& Parameters)
+{
+	FSessionSearchCache Cache;
+	const int32 MaxEntries = FSessionSearchCache::MaxEntries;
+
+	FOnlineSessionSearch SearchA;
+	SearchA.bIsLanQuery = true;
+	SearchA.QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
+	SearchA.QuerySettings.Set(SEARCH_KEYWORDS, FString(TEXT("Arena")), EOnlineComparisonOp::Equals);
+
+	FOnlineSessionSearch SearchB;
+	SearchB.bIsLanQuery = true;
+	SearchB.QuerySettings.Set(SEARCH_KEYWORDS, FString(TEXT("Arena")), EOnlineComparisonOp::Equals);
+	SearchB.QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
+
+	const FString Key = FSessionSearchCache::MakeKey(SearchA, EBPServerPresenceSearchType::AllServers);
+	TestEqual(TEXT("Param order doesn't change the key"), FSessionSearchCache::MakeKey(SearchB, EBPServerPresenceSearchType::AllServers), Key);
+	TestNotEqual(TEXT("Server type changes the key"), FSessionSearchCache::MakeKey(SearchA, EBPServerPresenceSearchType::DedicatedServersOnly), Key);
+
+	SearchB.bIsLanQuery = false;
+	TestNotEqual(TEXT("LAN changes the key"), FSessionSearchCache::MakeKey(SearchB, EBPServerPresenceSearchType::AllServers), Key);
+
+	TestTrue(TEXT("First refresh begins"), Cache.TryBeginRefresh(Key));
+	TestFalse(TEXT("Second refresh of the same key waits"), Cache.TryBeginRefresh(Key));
+	TestNull(TEXT("Refreshing doesn't add an entry"), Cache.Find(Key));
+
+	Cache.EndRefresh(Key);
+	TestTrue(TEXT("Failed refresh can be retried"), Cache.TryBeginRefresh(Key));
+
+	Cache.Store(Key, TArray<FBlueprintSessionResult>());
+	TestNotNull(TEXT("Stored results are found"), Cache.Find(Key));
+	TestTrue(TEXT("Storing ends the refresh"), Cache.TryBeginRefresh(Key));
+	Cache.EndRefresh(Key);
+
+	// Keys that are only being refreshed mustn't count towards the limit or be picked for eviction
+	for (int32 Index = 0; Index < MaxEntries * 2; ++Index)
+	{
+		Cache.TryBeginRefresh(FString::Printf(TEXT("Refreshing%d"), Index));
+	}
+
+	for (int32 Index = 1; Index < MaxEntries; ++Index)
+	{
+		Cache.Store(FString::Printf(TEXT("Stored%d"), Index), TArray<FBlueprintSessionResult>());
+	}
+
+	TestEqual(TEXT("Cache fills up to the limit"), Cache.Entries.Num(), MaxEntries);
+	TestNotNull(TEXT("Oldest entry is kept while there's room"), Cache.Find(Key));
+
+	Cache.Store(TEXT("Newest"), TArray<FBlueprintSessionResult>());
+	TestEqual(TEXT("Cache stays at the limit"), Cache.Entries.Num(), MaxEntries);
+	TestNull(TEXT("Oldest entry is evicted"), Cache.Find(Key));
+	TestNotNull(TEXT("Newest entry is kept"), Cache.Find(TEXT("Newest")));
+
+	Cache.Empty();
+	TestEqual(TEXT("Empty drops every entry"), Cache.Entries.Num(), 0);
+	TestTrue(TEXT("Empty drops every running refresh"), Cache.TryBeginRefresh(TEXT("Refreshing0")));
+
+	return true;
+}
+
+/**
+ * Hosts a LAN session on one OnlineSubsystemNull instance and searches for it from another in the same process, storing
+ * each search in a cache to check the added and removed sessions it reports.
+ */
+class FSessionSearchCacheLoopbackCommand : public IAutomationLatentCommand
+{
+public:
+
+	explicit FSessionSearchCacheLoopbackCommand(FAutomationTestBase* InTest)
+		: Test(InTest)
+	{
+	}
+
+	virtual ~FSessionSearchCacheLoopbackCommand()
+	{
+		if (HostSessions.IsValid())
+		{
+			HostSessions->ClearOnCreateSessionCompleteDelegate_Handle(CreateHandle);
+			HostSessions->ClearOnDestroySessionCompleteDelegate_Handle(DestroyHandle);
+
+			if (HostSessions->GetNamedSession(SessionName))
+			{
+				HostSessions->DestroySession(SessionName);
+			}
+		}
+
+		if (ClientSessions.IsValid())
+		{
+			ClientSessions->ClearOnFindSessionsCompleteDelegate_Handle(FindHandle);
+		}
+
+		HostSessions.Reset();
+		ClientSessions.Reset();
+
+		FOnlineSubsystemModule& OnlineSubsystemModule = FModuleManager::GetModuleChecked<FOnlineSubsystemModule>(TEXT("OnlineSubsystem"));
+		OnlineSubsystemModule.DestroyOnlineSubsystem(HostInstance);
+		OnlineSubsystemModule.DestroyOnlineSubsystem(ClientInstance);
+	}
+
+	virtual bool Update() override
+	{
+		if (GetCurrentRunTime() > TimeoutSeconds)
+		{
+			Test->AddError(FString::Printf(TEXT("LAN loopback timed out at step %d"), (int32)Step));
+			return true;
+		}
+
+		switch (Step)
+		{
+		case EStep::Host:
+			return Host();
+
+		case EStep::WaitForHost:
+		case EStep::WaitForFirstSearch:
+		case EStep::WaitForStop:
+		case EStep::WaitForSecondSearch:
+			// The delegates move the step on
+			return false;
+
+		case EStep::FirstSearch:
+		case EStep::SecondSearch:
+			return BeginSearch();
+
+		case EStep::Stop:
+			return StopHosting();
+
+		default:
+			return true;
+		}
+	}
+
+private:
+
+	enum class EStep : uint8
+	{
+		Host,
+		WaitForHost,
+		FirstSearch,
+		WaitForFirstSearch,
+		Stop,
+		WaitForStop,
+		SecondSearch,
+		WaitForSecondSearch,
+		Done
+	};
+
+	bool Host()
+	{
+		IOnlineSubsystem* HostSubsystem = IOnlineSubsystem::Get(HostInstance);
+		IOnlineSubsystem* ClientSubsystem = IOnlineSubsystem::Get(ClientInstance);
+		HostSessions = HostSubsystem ? HostSubsystem->GetSessionInterface() : nullptr;
+		ClientSessions = ClientSubsystem ? ClientSubsystem->GetSessionInterface() : nullptr;
+
+		if (!HostSessions.IsValid() || !ClientSessions.IsValid())
+		{
+			Test->AddError(TEXT("OnlineSubsystemNull sessions aren't available"));
+			return true;
+		}
+
+		CreateHandle = HostSessions->AddOnCreateSessionCompleteDelegate_Handle(FOnCreateSessionCompleteDelegate::CreateLambda([this](FName, bool bWasSuccessful)
+		{
+			HostSessions->ClearOnCreateSessionCompleteDelegate_Handle(CreateHandle);
+
+			const FNamedOnlineSession* Session = HostSessions->GetNamedSession(SessionName);
+			if (!bWasSuccessful || !Session || !Session->SessionInfo.IsValid())
+			{
+				Test->AddError(TEXT("LAN session couldn't be hosted"));
+				Step = EStep::Done;
+				return;
+			}
+
+			HostSessionId = Session->SessionInfo->GetSessionId().ToString();
+			Step = EStep::FirstSearch;
+		}));
+
+		FOnlineSessionSettings Settings;
+		Settings.NumPublicConnections = 2;
+		Settings.bIsLANMatch = true;
+		Settings.bShouldAdvertise = true;
+		Settings.bUsesPresence = false;
+
+		Step = EStep::WaitForHost;
+		HostSessions->CreateSession(0, SessionName, Settings);
+		return false;
+	}
+
+	bool BeginSearch()
+	{
+		Search = MakeShared<FOnlineSessionSearch>();
+		Search->bIsLanQuery = true;
+		Search->MaxSearchResults = 100;
+
+		const FString Key = FSessionSearchCache::MakeKey(*Search, EBPServerPresenceSearchType::AllServers);
+		Test->TestTrue(TEXT("Refresh begins"), Cache.TryBeginRefresh(Key));
+		Test->TestFalse(TEXT("Overlapping refresh waits"), Cache.TryBeginRefresh(Key));
+
+		const bool bFirst = Step == EStep::FirstSearch;
+		FindHandle = ClientSessions->AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateLambda([this, Key, bFirst](bool bWasSuccessful)
+		{
+			ClientSessions->ClearOnFindSessionsCompleteDelegate_Handle(FindHandle);
+
+			if (!bWasSuccessful)
+			{
+				Cache.EndRefresh(Key);
+				Test->AddError(TEXT("LAN search failed"));
+				Step = EStep::Done;
+				return;
+			}
+
+			TArray<FBlueprintSessionResult> Results;
+			for (const FOnlineSessionSearchResult& SearchResult : Search->SearchResults)
+			{
+				FBlueprintSessionResult& Result = Results.AddDefaulted_GetRef();
+				Result.OnlineResult = SearchResult;
+			}
+
+			TArray<FBlueprintSessionResult> Added;
+			TArray<FBlueprintSessionResult> Removed;
+			Cache.Store(Key, Results, &Added, &Removed);
+
+			// Other hosts on the network may turn up too, only the session hosted here is checked
+			auto IsHostSession = [this](const FBlueprintSessionResult& Result) { return Result.OnlineResult.GetSessionIdStr() == HostSessionId; };
+
+			if (bFirst)
+			{
+				Test->TestTrue(TEXT("Hosted session is found over loopback"), Results.ContainsByPredicate(IsHostSession));
+				Test->TestTrue(TEXT("First search reports the session as added"), Added.ContainsByPredicate(IsHostSession));
+				Test->TestEqual(TEXT("First search removes nothing"), Removed.Num(), 0);
+				Step = EStep::Stop;
+			}
+			else
+			{
+				Test->TestFalse(TEXT("Stopped session isn't found"), Results.ContainsByPredicate(IsHostSession));
+				Test->TestFalse(TEXT("Stopped session isn't added"), Added.ContainsByPredicate(IsHostSession));
+				Test->TestTrue(TEXT("Second search reports the session as removed"), Removed.ContainsByPredicate(IsHostSession));
+				Step = EStep::Done;
+			}
+
+			const FSessionSearchCacheEntry* Entry = Cache.Find(Key);
+			Test->TestTrue(TEXT("Search results are cached"), Entry != nullptr && Entry->Results.Num() == Results.Num());
+		}));
+
+		Step = bFirst ? EStep::WaitForFirstSearch : EStep::WaitForSecondSearch;
+		if (!ClientSessions->FindSessions(0, Search.ToSharedRef()))
+		{
+			ClientSessions->ClearOnFindSessionsCompleteDelegate_Handle(FindHandle);
+			Cache.EndRefresh(Key);
+			Test->AddError(TEXT("LAN search couldn't start"));
+			return true;
+		}
+
+		return false;
+	}
+
+	bool StopHosting()
+	{
+		DestroyHandle = HostSessions->AddOnDestroySessionCompleteDelegate_Handle(FOnDestroySessionCompleteDelegate::CreateLambda([this](FName, bool)
+		{
+			HostSessions->ClearOnDestroySessionCompleteDelegate_Handle(DestroyHandle);
+			Step = EStep::SecondSearch;
+		}));
+
+		Step = EStep::WaitForStop;
+		HostSessions->DestroySession(SessionName);
+		return false;
+	}
+
+	// LAN searches wait out the beacon timeout, two of them fit well within this
+	static constexpr double TimeoutSeconds = 30.0;
+
+	const FName HostInstance = TEXT("NULL:SessionSearchCacheHost");
+	const FName ClientInstance = TEXT("NULL:SessionSearchCacheClient");
+	const FName SessionName = TEXT("SessionSearchCacheTest");
+
+	FAutomationTestBase* Test;
+
+	EStep Step = EStep::Host;
+
+	FSessionSearchCache Cache;
+
+	IOnlineSessionPtr HostSessions;
+	IOnlineSessionPtr ClientSessions;
+
+	TSharedPtr<FOnlineSessionSearch> Search;
+
+	FString HostSessionId;
+
+	FDelegateHandle CreateHandle;
+	FDelegateHandle DestroyHandle;
+	FDelegateHandle FindHandle;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionSearchCacheLoopbackTest, "AdvancedSessions.SessionSearchCache.LanLoopback", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FSessionSearchCacheLoopbackTest::RunTest(const FString& Parameters)
+{
+	ADD_LATENT_AUTOMATION_COMMAND(FSessionSearchCacheLoopbackCommand(this));
+	return true;
+}
+
+#endif
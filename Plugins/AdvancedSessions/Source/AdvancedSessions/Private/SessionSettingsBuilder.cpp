@@ -0,0 +1,155 @@
+#include "SessionSettingsBuilder.h"
+
+// Settings of the last successful UpdateSession for each session
+static TMap<FName, FOnlineSessionSettings> GPushedSessionSettings;
+
+FSessionSettingsBuilder::FSessionSettingsBuilder(const TArray<FSessionPropertyKeyPair>& InitialSettings)
+{
+	Settings.Reserve(InitialSettings.Num());
+	KeyToIndex.Reserve(InitialSettings.Num());
+	for (const FSessionPropertyKeyPair& Setting : InitialSettings)
+	{
+		Set(Setting.Key, Setting.Data);
+	}
+
+	// The starting settings aren't changes
+	ResetChanges();
+}
+
+bool FSessionSettingsBuilder::Set(FName Key, const FVariantData& Data)
+{
+	if (const int32* Index = KeyToIndex.Find(Key))
+	{
+		FVariantData& Existing = Settings[*Index].Data;
+		if (Existing == Data)
+		{
+			return false;
+		}
+
+		Existing = Data;
+	}
+	else
+	{
+		KeyToIndex.Add(Key, Settings.Num());
+
+		FSessionPropertyKeyPair& NewSetting = Settings.AddDefaulted_GetRef();
+		NewSetting.Key = Key;
+		NewSetting.Data = Data;
+	}
+
+	MarkChanged(Key);
+	return true;
+}
+
+int32 FSessionSettingsBuilder::Merge(const TArray<FSessionPropertyKeyPair>& NewOrChangedSettings)
+{
+	Settings.Reserve(Settings.Num() + NewOrChangedSettings.Num());
+
+	int32 NumChanged = 0;
+	for (const FSessionPropertyKeyPair& Setting : NewOrChangedSettings)
+	{
+		if (Set(Setting.Key, Setting.Data))
+		{
+			++NumChanged;
+		}
+	}
+	return NumChanged;
+}
+
+void FSessionSettingsBuilder::Reset()
+{
+	Settings.Reset();
+	KeyToIndex.Reset();
+	ResetChanges();
+}
+
+void FSessionSettingsBuilder::ResetChanges()
+{
+	ChangedKeys.Reset();
+	ChangedKeySet.Reset();
+}
+
+void FSessionSettingsBuilder::MarkChanged(FName Key)
+{
+	bool bAlreadyChanged = false;
+	ChangedKeySet.Add(Key, &bAlreadyChanged);
+	if (!bAlreadyChanged)
+	{
+		ChangedKeys.Add(Key);
+	}
+}
+
+int32 FSessionSettingsBuilder::ApplyToSessionSettings(FOnlineSessionSettings& SessionSettings, const TArray<FSessionPropertyKeyPair>& ExtraSettings, TArray<FName>* OutChangedKeys)
+{
+	int32 NumChanged = 0;
+	for (const FSessionPropertyKeyPair& Setting : ExtraSettings)
+	{
+		if (FOnlineSessionSetting* LiveSetting = SessionSettings.Settings.Find(Setting.Key))
+		{
+			if (LiveSetting->Data == Setting.Data)
+			{
+				continue;
+			}
+
+			LiveSetting->Data = Setting.Data;
+		}
+		else
+		{
+			SessionSettings.Settings.Add(Setting.Key, FOnlineSessionSetting(Setting.Data, EOnlineDataAdvertisementType::ViaOnlineService));
+		}
+
+		++NumChanged;
+		if (OutChangedKeys)
+		{
+			OutChangedKeys->AddUnique(Setting.Key);
+		}
+	}
+	return NumChanged;
+}
+
+void FSessionSettingsBuilder::RecordPushedSettings(FName SessionName, const FOnlineSessionSettings& SessionSettings)
+{
+	check(IsInGameThread());
+
+	GPushedSessionSettings.Add(SessionName, SessionSettings);
+}
+
+void FSessionSettingsBuilder::ForgetPushedSettings(FName SessionName)
+{
+	check(IsInGameThread());
+
+	GPushedSessionSettings.Remove(SessionName);
+}
+
+bool FSessionSettingsBuilder::MatchesPushedSettings(FName SessionName, const FOnlineSessionSettings& SessionSettings)
+{
+	check(IsInGameThread());
+
+	const FOnlineSessionSettings* Pushed = GPushedSessionSettings.Find(SessionName);
+	if (!Pushed)
+	{
+		return false;
+	}
+
+	if (Pushed->NumPublicConnections != SessionSettings.NumPublicConnections ||
+		Pushed->NumPrivateConnections != SessionSettings.NumPrivateConnections ||
+		Pushed->bAllowJoinInProgress != SessionSettings.bAllowJoinInProgress ||
+		Pushed->bIsLANMatch != SessionSettings.bIsLANMatch ||
+		Pushed->bAllowInvites != SessionSettings.bAllowInvites ||
+		Pushed->bIsDedicated != SessionSettings.bIsDedicated ||
+		Pushed->Settings.Num() != SessionSettings.Settings.Num())
+	{
+		return false;
+	}
+
+	for (const TPair<FName, FOnlineSessionSetting>& Setting : SessionSettings.Settings)
+	{
+		const FOnlineSessionSetting* PushedSetting = Pushed->Settings.Find(Setting.Key);
+		if (!PushedSetting || !(PushedSetting->Data == Setting.Value.Data))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -1,5 +1,7 @@
 // Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
 #include "UpdateSessionCallbackProxyAdvanced.h"
+#include "AdvancedSessionsLibrary.h"
+#include "SessionSettingsBuilder.h"
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -9,10 +11,11 @@ UUpdateSessionCallbackProxyAdvanced::UUpdateSessionCallbackProxyAdvanced(const F
 	: Super(ObjectInitializer)
 	, OnUpdateSessionCompleteDelegate(FOnUpdateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnUpdateCompleted))
 	, NumPublicConnections(1)
+	, bSkipIfUnchanged(false)
 {
 }	
 
-UUpdateSessionCallbackProxyAdvanced* UUpdateSessionCallbackProxyAdvanced::UpdateSession(UObject* WorldContextObject, const TArray<FSessionPropertyKeyPair> &ExtraSettings, int32 PublicConnections, int32 PrivateConnections, bool bUseLAN, bool bAllowInvites, bool bAllowJoinInProgress, bool bRefreshOnlineData, bool bIsDedicatedServer)
+UUpdateSessionCallbackProxyAdvanced* UUpdateSessionCallbackProxyAdvanced::UpdateSession(UObject* WorldContextObject, const TArray<FSessionPropertyKeyPair> &ExtraSettings, int32 PublicConnections, int32 PrivateConnections, bool bUseLAN, bool bAllowInvites, bool bAllowJoinInProgress, bool bRefreshOnlineData, bool bIsDedicatedServer, bool bSkipIfUnchanged)
 {
 	UUpdateSessionCallbackProxyAdvanced* Proxy = NewObject<UUpdateSessionCallbackProxyAdvanced>();
 	Proxy->NumPublicConnections = PublicConnections;
@@ -24,6 +27,7 @@ UUpdateSessionCallbackProxyAdvanced* UUpdateSessionCallbackProxyAdvanced::Update
 	Proxy->bRefreshOnlineData = bRefreshOnlineData;
 	Proxy->bAllowJoinInProgress = bAllowJoinInProgress;
 	Proxy->bDedicatedServer = bIsDedicatedServer;
+	Proxy->bSkipIfUnchanged = bSkipIfUnchanged;
 	return Proxy;	
 }
 
@@ -43,16 +47,18 @@ void UUpdateSessionCallbackProxyAdvanced::Activate()
 
 		// This gets the actual session itself
 		//FNamedOnlineSession * curSession = Sessions->GetNamedSession(NAME_GameSession);
-		FOnlineSessionSettings* Settings = Sessions->GetSessionSettings(NAME_GameSession);
+		FOnlineSessionSettings* LiveSettings = Sessions->GetSessionSettings(NAME_GameSession);
 
-		if (!Settings)
+		if (!LiveSettings)
 		{
 			// Fail immediately
 			OnFailure.Broadcast();
 			return;
 		}
 
-		OnUpdateSessionCompleteDelegateHandle = Sessions->AddOnUpdateSessionCompleteDelegate_Handle(OnUpdateSessionCompleteDelegate);
+		// The live settings are left alone until the update succeeds, so a failed one is sent again next time
+		SentSettings = *LiveSettings;
+		FOnlineSessionSettings* Settings = &SentSettings;
 
 	//	FOnlineSessionSettings Settings;
 		//Settings->BuildUniqueId = GetBuildUniqueId();
@@ -64,27 +70,19 @@ void UUpdateSessionCallbackProxyAdvanced::Activate()
 		//Settings->bUsesPresence = true;
 		//Settings->bAllowJoinViaPresence = true;
 		Settings->bAllowInvites = bAllowInvites;
-		Settings->bAllowJoinInProgress = bAllowJoinInProgress;
 		Settings->bIsDedicated = bDedicatedServer;
 
-		FOnlineSessionSetting * fSetting = NULL;
-		FOnlineSessionSetting ExtraSetting;
-		for (int i = 0; i < ExtraSettings.Num(); i++)
+		FSessionSettingsBuilder::ApplyToSessionSettings(*Settings, ExtraSettings);
+
+		if (bSkipIfUnchanged && FSessionSettingsBuilder::MatchesPushedSettings(NAME_GameSession, *Settings))
 		{
-			fSetting = Settings->Settings.Find(ExtraSettings[i].Key);
-
-			if (fSetting)
-			{
-				fSetting->Data = ExtraSettings[i].Data;
-			}
-			else
-			{
-				ExtraSetting.Data = ExtraSettings[i].Data;
-				ExtraSetting.AdvertisementType = EOnlineDataAdvertisementType::ViaOnlineService;
-				Settings->Settings.Add(ExtraSettings[i].Key, ExtraSetting);
-			}
+			UE_LOG(AdvancedSessionsLog, Verbose, TEXT("UpdateSession - Settings unchanged, skipping the online update"));
+			OnSuccess.Broadcast();
+			return;
 		}
 
+		OnUpdateSessionCompleteDelegateHandle = Sessions->AddOnUpdateSessionCompleteDelegate_Handle(OnUpdateSessionCompleteDelegate);
+
 		Sessions->UpdateSession(NAME_GameSession, *Settings, bRefreshOnlineData);
 
 		// OnUpdateCompleted will get called, nothing more to do now
@@ -108,6 +106,7 @@ void UUpdateSessionCallbackProxyAdvanced::OnUpdateCompleted(FName SessionName, b
 			
 		if (bWasSuccessful)
 		{
+			FSessionSettingsBuilder::RecordPushedSettings(SessionName, SentSettings);
 			OnSuccess.Broadcast();
 			return;
 		}
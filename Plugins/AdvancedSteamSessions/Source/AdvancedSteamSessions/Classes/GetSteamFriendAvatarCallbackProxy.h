@@ -0,0 +1,43 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "BlueprintDataDefinitions.h"
+#include "AdvancedSteamFriendsLibrary.h"
+#include "GetSteamFriendAvatarCallbackProxy.generated.h"
+
+class UTexture2D;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FBlueprintSteamAvatarDelegate, UTexture2D*, Avatar);
+
+UCLASS(MinimalAPI)
+class UGetSteamFriendAvatarCallbackProxy : public UOnlineBlueprintCallProxyBase
+{
+	GENERATED_UCLASS_BODY()
+
+	// Called with the avatar once it is available
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintSteamAvatarDelegate OnSuccess;
+
+	// Called if the user has no avatar or Steam isn't running
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintSteamAvatarDelegate OnFailure;
+
+	// Gets a steam user's avatar, waiting for it to download if needed. STEAM ONLY, the texture is shared with every other request for the same avatar
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "Online|AdvancedFriends|SteamAPI")
+	static UGetSteamFriendAvatarCallbackProxy* GetSteamFriendAvatarAsync(UObject* WorldContextObject, const FBPUniqueNetId UniqueNetId, SteamAvatarSize AvatarSize = SteamAvatarSize::SteamAvatar_Medium);
+
+	// UOnlineBlueprintCallProxyBase interface
+	virtual void Activate() override;
+	// End of UOnlineBlueprintCallProxyBase interface
+
+private:
+
+	void OnAvatarReady(UTexture2D* Avatar);
+
+	FBPUniqueNetId UniqueNetId;
+
+	SteamAvatarSize AvatarSize;
+
+	// The world context object in which this call is taking place
+	UObject* WorldContextObject;
+};
@@ -0,0 +1,126 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Containers/LruCache.h"
+#include "Styling/SlateBrush.h"
+#include "BlueprintDataDefinitions.h"
+#include "AdvancedSteamFriendsLibrary.h"
+#include "SteamAvatarAtlas.generated.h"
+
+class ISteamAvatarProvider;
+class UTexture2D;
+
+/**
+ * Packs steam avatars of one size into a single texture page so a scoreboard or friends list showing dozens of them
+ * draws from one texture. Each player gets a brush onto their cell, which is filled in place when the avatar arrives
+ * or changes, and the least recently requested cell is reused once the page is full. Every cell has a one pixel gutter
+ * repeating its edge so filtering never picks up a neighbour.
+ */
+UCLASS(BlueprintType)
+class ADVANCEDSTEAMSESSIONS_API USteamAvatarAtlas : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	* Creates an atlas for one avatar size, STEAM ONLY. Returns null if Steam isn't running.
+	* @param AvatarSize - Small (32px) or Medium (64px) avatars pack best, Large (184px) works but fits few per page
+	* @param PageSize - Width and height of the atlas texture in pixels, limited to the largest texture the RHI supports
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedFriends|SteamAPI|Atlas")
+	static USteamAvatarAtlas* CreateSteamAvatarAtlas(SteamAvatarSize AvatarSize = SteamAvatarSize::SteamAvatar_Medium, int32 PageSize = 1024);
+
+	/**
+	* Gets a brush showing a player's avatar. The brush fills in by itself if the avatar is still downloading, but shows
+	* someone else once the cell is reused, check IsAvatarCellCurrent with CellGeneration before keeping it around.
+	* @param bIsReady - False while the cell is still blank
+	* @param CellGeneration - Identifies this player's hold on the cell
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedFriends|SteamAPI|Atlas")
+	FSlateBrush GetAvatarBrush(const FBPUniqueNetId& UniqueNetId, bool& bIsReady, int32& CellGeneration);
+
+	// Gets the UV rectangle of a player's cell, adding them to the atlas if needed
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedFriends|SteamAPI|Atlas")
+	bool GetAvatarUVs(const FBPUniqueNetId& UniqueNetId, FVector2D& UVMin, FVector2D& UVMax, int32& CellGeneration);
+
+	// True while the player still holds the cell they were given with CellGeneration, false once it went to someone else
+	UFUNCTION(BlueprintPure, Category = "Online|AdvancedFriends|SteamAPI|Atlas")
+	bool IsAvatarCellCurrent(const FBPUniqueNetId& UniqueNetId, int32 CellGeneration) const;
+
+	UFUNCTION(BlueprintPure, Category = "Online|AdvancedFriends|SteamAPI|Atlas")
+	UTexture2D* GetAtlasTexture() const { return AtlasTexture; }
+
+	UFUNCTION(BlueprintPure, Category = "Online|AdvancedFriends|SteamAPI|Atlas")
+	int32 GetNumAvatars() const { return CellOfUser.Num(); }
+
+	UFUNCTION(BlueprintPure, Category = "Online|AdvancedFriends|SteamAPI|Atlas")
+	int32 GetCapacity() const { return CellOfUser.Max(); }
+
+	virtual void BeginDestroy() override;
+
+private:
+
+	friend class FSteamAvatarAtlasTest;
+
+	bool Initialize(const TSharedRef<ISteamAvatarProvider, ESPMode::ThreadSafe>& InProvider, SteamAvatarSize InAvatarSize, int32 PageSize);
+
+	// Returns the player's cell, reserving one and starting the fill if they don't have one yet
+	int32 FindOrAddCell(uint64 SteamId);
+
+	// Copies the avatar into its cell if Steam has it, returns false while it is still downloading
+	bool TryFillCell(uint64 SteamId, int32 Cell);
+
+	// Fills a cell again after its player's avatar changed, blanking it if the new one is still downloading or there is none
+	void RefillCell(uint64 SteamId, int32 Cell);
+
+	// Queues a render thread copy of CellSize x CellSize RGBA pixels into a cell and its gutter, takes ownership of Pixels
+	void UploadCell(int32 Cell, uint8* Pixels);
+
+	void OnAvatarLoaded(uint64 SteamId);
+
+	void OnAvatarChanged(uint64 SteamId);
+
+	FBox2D GetCellUVs(int32 Cell) const;
+
+	UPROPERTY()
+	UTexture2D* AtlasTexture;
+
+	TSharedPtr<ISteamAvatarProvider, ESPMode::ThreadSafe> Provider;
+
+	FDelegateHandle AvatarLoadedHandle;
+	FDelegateHandle AvatarChangedHandle;
+
+	// Player to cell index, in least recently requested order
+	TLruCache<uint64, int32> CellOfUser;
+
+	// Player each cell was last given to
+	TArray<uint64> UserOfCell;
+
+	// Generation each cell was last given out with, unique across the atlas so a stale one never matches again
+	TArray<int32> GenerationOfCell;
+
+	int32 NextGeneration;
+
+	// Cells holding a finished avatar
+	TBitArray<> FilledCells;
+
+	// Steam image each cell was last filled from, a new handle for the same player means their avatar changed
+	TArray<int32> ImageOfCell;
+
+	// Cells handed out so far, cells are only reused once every one has been
+	int32 NumCellsUsed;
+
+	// Players whose cell is waiting on a download
+	TSet<uint64> PendingUsers;
+
+	SteamAvatarSize AvatarSize;
+	int32 CellSize;
+	int32 CellsPerRow;
+
+	// Pixels from one cell to the next, the avatar plus its gutter on both sides
+	int32 CellStride;
+
+	// Width of a texel in UV space
+	float TexelUVSize;
+};
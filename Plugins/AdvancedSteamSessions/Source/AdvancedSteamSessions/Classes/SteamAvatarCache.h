@@ -0,0 +1,140 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "Containers/LruCache.h"
+#include "AdvancedSteamFriendsLibrary.h"
+
+class UTexture2D;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSteamAvatarEvent, uint64 /*SteamId*/);
+
+// Called once an avatar is ready, with null if the user has no avatar of that size
+DECLARE_DELEGATE_OneParam(FOnSteamAvatarReady, UTexture2D* /*Avatar*/);
+
+/**
+ * Where avatar pixels come from. The cache only talks to this, so it can be driven with fake images
+ * without Steam running. Events must be broadcast on the game thread.
+ */
+class ISteamAvatarProvider
+{
+public:
+
+	virtual ~ISteamAvatarProvider() {}
+
+	// Returns the image handle of an avatar, -1 while it is still being downloaded or 0 if the user has none
+	virtual int32 GetAvatarImage(uint64 SteamId, SteamAvatarSize Size) = 0;
+
+	virtual bool GetImageSize(int32 Image, uint32& OutWidth, uint32& OutHeight) = 0;
+
+	// Copies an image as RGBA8 into Dest, which holds DestSize bytes
+	virtual bool CopyImageRGBA(int32 Image, uint8* Dest, int32 DestSize) = 0;
+
+	// An avatar that was downloading has arrived
+	FOnSteamAvatarEvent OnAvatarLoaded;
+
+	// A user changed their avatar, anything cached for them is stale
+	FOnSteamAvatarEvent OnAvatarChanged;
+};
+
+/**
+ * Avatar textures keyed by Steam ID and size. Asking again for the same avatar returns the same texture, avatars
+ * still downloading are finished off by the provider's events rather than by polling, and the least recently used
+ * textures are let go once there are more than MaxTextures. Game thread only.
+ */
+class ADVANCEDSTEAMSESSIONS_API FSteamAvatarCache : public FGCObject
+{
+public:
+
+	struct FStats
+	{
+		int32 Hits = 0;
+		int32 Misses = 0;
+		int32 TexturesCreated = 0;
+		int32 TexturesEvicted = 0;
+	};
+
+	static constexpr int32 DefaultMaxTextures = 128;
+
+	// The cache backed by Steam, null if Steam isn't running
+	static FSteamAvatarCache* Get();
+
+	// Destroys the Steam backed cache, called on module shutdown
+	static void Shutdown();
+
+	explicit FSteamAvatarCache(const TSharedRef<ISteamAvatarProvider, ESPMode::ThreadSafe>& InProvider, int32 MaxTextures = DefaultMaxTextures);
+	virtual ~FSteamAvatarCache();
+
+	/**
+	 * Returns the avatar if it is cached or can be made now. Otherwise returns null, and bOutLoading tells whether
+	 * it is still downloading, in which case it is cached as soon as it arrives.
+	 */
+	UTexture2D* Find(uint64 SteamId, SteamAvatarSize Size, bool& bOutLoading);
+
+	// Calls OnReady with the avatar, straight away if it is available or once it has downloaded
+	void Request(uint64 SteamId, SteamAvatarSize Size, FOnSteamAvatarReady OnReady);
+
+	// Drops every cached texture, requests still waiting are kept
+	void Empty();
+
+	int32 Num() const { return Lookup.Num(); }
+
+	int32 NumPending() const { return Pending.Num(); }
+
+	const FStats& GetStats() const { return Stats; }
+
+	// Where the cache reads avatars from, for users that need the pixels rather than a texture
+	const TSharedRef<ISteamAvatarProvider, ESPMode::ThreadSafe>& GetProvider() const { return Provider; }
+
+	// FGCObject interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FSteamAvatarCache"); }
+	// End of FGCObject interface
+
+private:
+
+	struct FAvatarKey
+	{
+		uint64 SteamId;
+		SteamAvatarSize Size;
+
+		bool operator==(const FAvatarKey& Other) const { return SteamId == Other.SteamId && Size == Other.Size; }
+
+		friend uint32 GetTypeHash(const FAvatarKey& Key) { return HashCombine(GetTypeHash(Key.SteamId), (uint32)Key.Size); }
+	};
+
+	enum class ELoadResult : uint8
+	{
+		Loaded,
+		Loading,
+		Failed
+	};
+
+	// Looks the avatar up in the cache or makes it from the provider
+	ELoadResult Load(const FAvatarKey& Key, UTexture2D*& OutTexture);
+
+	UTexture2D* CreateTexture(int32 Image);
+
+	// Stores a texture, evicting the least recently used one if the cache is full
+	void Store(const FAvatarKey& Key, UTexture2D* Texture);
+
+	void OnAvatarLoaded(uint64 SteamId);
+
+	void OnAvatarChanged(uint64 SteamId);
+
+	TSharedRef<ISteamAvatarProvider, ESPMode::ThreadSafe> Provider;
+
+	// Key to index in Slots, in least recently used order
+	TLruCache<FAvatarKey, int32> Lookup;
+
+	// Textures kept alive by the cache, null slots are listed in FreeSlots
+	TArray<UTexture2D*> Slots;
+	TArray<int32> FreeSlots;
+
+	// Callbacks waiting for avatars that are still downloading
+	TMap<FAvatarKey, TArray<FOnSteamAvatarReady>> Pending;
+
+	FDelegateHandle AvatarLoadedHandle;
+	FDelegateHandle AvatarChangedHandle;
+
+	FStats Stats;
+};
@@ -0,0 +1,43 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AdvancedSteamWorkshopLibrary.h"
+#include "BlueprintDataDefinitions.h"
+#include "SteamWSRequestUGCDetailsBatchCallbackProxy.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FBlueprintWorkshopDetailsBatchDelegate, const TArray<FBPSteamWorkshopItemDetails>&, WorkshopDetails);
+
+UCLASS(MinimalAPI)
+class USteamWSRequestUGCDetailsBatchCallbackProxy : public UOnlineBlueprintCallProxyBase
+{
+	GENERATED_UCLASS_BODY()
+
+	// Called when the details of every item were found
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintWorkshopDetailsBatchDelegate OnSuccess;
+
+	// Called when some items couldn't be found, their entries have ResultOfRequest set to why
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintWorkshopDetailsBatchDelegate OnFailure;
+
+	/**
+	 * Gets the details of many workshop items at once, in as few UGC queries as possible.
+	 * The details come back in the same order as WorkShopIDs.
+	 * @param MaxCacheAgeSeconds - Details fetched longer ago than this are fetched again, negative never refetches
+	 */
+	UFUNCTION(BlueprintCallable, meta=(BlueprintInternalUseOnly = "true", WorldContext="WorldContextObject"), Category = "Online|AdvancedSteamWorkshop")
+	static USteamWSRequestUGCDetailsBatchCallbackProxy* GetWorkshopItemDetailsBatch(UObject* WorldContextObject, const TArray<FBPSteamWorkshopID>& WorkShopIDs, float MaxCacheAgeSeconds = 300.0f);
+
+	// UOnlineBlueprintCallProxyBase interface
+	virtual void Activate() override;
+	// End of UOnlineBlueprintCallProxyBase interface
+
+private:
+
+	// Internal callback when the details are ready, calls out to the public success/failure callbacks
+	void OnDetailsReady(bool bAllFound, const TArray<FBPSteamWorkshopItemDetails>& Details);
+
+	TArray<FBPSteamWorkshopID> WorkShopIDs;
+	float MaxCacheAgeSeconds;
+};
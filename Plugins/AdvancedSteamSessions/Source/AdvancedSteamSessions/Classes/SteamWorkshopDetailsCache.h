@@ -0,0 +1,107 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "AdvancedSteamWorkshopLibrary.h"
+
+typedef TMap<uint64, FBPSteamWorkshopItemDetails> FWorkshopDetailsMap;
+
+// Called with the details a query found keyed by item id, items that weren't found are left out
+DECLARE_DELEGATE_TwoParams(FOnWorkshopDetailsQueried, bool /*bWasSuccessful*/, const FWorkshopDetailsMap& /*DetailsById*/);
+
+// Called with the details of every requested item in request order, bAllFound is false if any are placeholders
+DECLARE_DELEGATE_TwoParams(FOnWorkshopDetailsReady, bool /*bAllFound*/, const TArray<FBPSteamWorkshopItemDetails>& /*Details*/);
+
+/**
+ * Runs UGC detail queries. The cache only talks to this, so it can be driven offline with made up items.
+ * Completions must be called on the game thread.
+ */
+class IWorkshopUGCProvider
+{
+public:
+
+	virtual ~IWorkshopUGCProvider() {}
+
+	// Most items one query can ask for
+	virtual int32 GetMaxItemsPerQuery() const = 0;
+
+	// Starts a query for the details of up to GetMaxItemsPerQuery items
+	virtual void QueryDetails(const TArray<uint64>& ItemIds, FOnWorkshopDetailsQueried OnComplete) = 0;
+};
+
+/**
+ * Workshop item details keyed by item id along with when they were fetched. A request for many items asks only for
+ * the ones missing or older than the caller allows, a page of items per UGC query, and answers with one array.
+ * Game thread only.
+ */
+class ADVANCEDSTEAMSESSIONS_API FSteamWorkshopDetailsCache
+{
+public:
+
+	struct FStats
+	{
+		int32 ItemsRequested = 0;
+		int32 CacheHits = 0;
+		int32 QueriesSent = 0;
+		int32 QueriesFailed = 0;
+	};
+
+	// The cache backed by Steam, null if Steam isn't running
+	static FSteamWorkshopDetailsCache* Get();
+
+	// Destroys the Steam backed cache, called on module shutdown
+	static void Shutdown();
+
+	explicit FSteamWorkshopDetailsCache(const TSharedRef<IWorkshopUGCProvider, ESPMode::ThreadSafe>& InProvider);
+
+	/**
+	 * Gets the details of many items, OnReady is called once, straight away if everything is cached.
+	 * @param ItemIds - Items to get, the details come back in the same order
+	 * @param MaxAgeSeconds - Cached details older than this are fetched again, negative never refetches
+	 */
+	void RequestDetails(const TArray<uint64>& ItemIds, double MaxAgeSeconds, FOnWorkshopDetailsReady OnReady);
+
+	// Returns cached details if they are younger than MaxAgeSeconds, negative accepts any age
+	const FBPSteamWorkshopItemDetails* FindCached(uint64 ItemId, double MaxAgeSeconds = -1.0) const;
+
+	void Empty() { Cache.Empty(); }
+
+	int32 Num() const { return Cache.Num(); }
+
+	const FStats& GetStats() const { return Stats; }
+
+private:
+
+	struct FCachedDetails
+	{
+		FBPSteamWorkshopItemDetails Details;
+
+		// FPlatformTime::Seconds() when the details were fetched
+		double FetchedTime = 0.0;
+	};
+
+	// One RequestDetails call working through its pages
+	struct FBatch
+	{
+		TArray<uint64> ItemIds;
+
+		// Items that need fetching, in pages of GetMaxItemsPerQuery
+		TArray<uint64> ToFetch;
+		int32 NextToFetch = 0;
+
+		// Items a failed query couldn't fetch
+		TSet<uint64> Failed;
+
+		FOnWorkshopDetailsReady OnReady;
+	};
+
+	void QueryNextPage(TSharedRef<FBatch> Batch);
+
+	void OnPageQueried(bool bWasSuccessful, const FWorkshopDetailsMap& DetailsById, TSharedRef<FBatch> Batch, int32 PageStart, int32 PageSize);
+
+	void FinishBatch(const FBatch& Batch);
+
+	TSharedRef<IWorkshopUGCProvider, ESPMode::ThreadSafe> Provider;
+
+	TMap<uint64, FCachedDetails> Cache;
+
+	FStats Stats;
+};
@@ -1,5 +1,7 @@
 //#include "StandAlonePrivatePCH.h"
 #include "AdvancedSteamSessions.h"
+#include "SteamAvatarCache.h"
+#include "SteamWorkshopDetailsCache.h"
 
 void AdvancedSteamSessions::StartupModule()
 {
@@ -7,6 +9,8 @@ void AdvancedSteamSessions::StartupModule()
  
 void AdvancedSteamSessions::ShutdownModule()
 {
+	FSteamAvatarCache::Shutdown();
+	FSteamWorkshopDetailsCache::Shutdown();
 }
  
 IMPLEMENT_MODULE(AdvancedSteamSessions, AdvancedSteamSessions)
\ No newline at end of file
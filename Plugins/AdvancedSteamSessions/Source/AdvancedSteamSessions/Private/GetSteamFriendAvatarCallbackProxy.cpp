@@ -0,0 +1,58 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+#include "GetSteamFriendAvatarCallbackProxy.h"
+#include "SteamAvatarCache.h"
+
+//////////////////////////////////////////////////////////////////////////
+// UGetSteamFriendAvatarCallbackProxy
+
+UGetSteamFriendAvatarCallbackProxy::UGetSteamFriendAvatarCallbackProxy(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, AvatarSize(SteamAvatarSize::SteamAvatar_Medium)
+	, WorldContextObject(nullptr)
+{
+}
+
+UGetSteamFriendAvatarCallbackProxy* UGetSteamFriendAvatarCallbackProxy::GetSteamFriendAvatarAsync(UObject* WorldContextObject, const FBPUniqueNetId UniqueNetId, SteamAvatarSize AvatarSize)
+{
+	UGetSteamFriendAvatarCallbackProxy* Proxy = NewObject<UGetSteamFriendAvatarCallbackProxy>();
+	Proxy->UniqueNetId = UniqueNetId;
+	Proxy->AvatarSize = AvatarSize;
+	Proxy->WorldContextObject = WorldContextObject;
+	return Proxy;
+}
+
+void UGetSteamFriendAvatarCallbackProxy::Activate()
+{
+#if PLATFORM_WINDOWS || PLATFORM_MAC || PLATFORM_LINUX
+	if (!UniqueNetId.IsValid() || !UniqueNetId.UniqueNetId->IsValid() || UniqueNetId.UniqueNetId->GetType() != STEAM_SUBSYSTEM)
+	{
+		UE_LOG(AdvancedSteamFriendsLog, Warning, TEXT("GetSteamFriendAvatarAsync Had a bad UniqueNetId!"));
+		OnFailure.Broadcast(nullptr);
+		return;
+	}
+
+	if (FSteamAvatarCache* AvatarCache = FSteamAvatarCache::Get())
+	{
+		uint64 id = *((uint64*)UniqueNetId.UniqueNetId->GetBytes());
+
+		// OnAvatarReady will get called, possibly right away
+		AvatarCache->Request(id, AvatarSize, FOnSteamAvatarReady::CreateUObject(this, &ThisClass::OnAvatarReady));
+		return;
+	}
+#endif
+
+	UE_LOG(AdvancedSteamFriendsLog, Warning, TEXT("STEAM Couldn't be verified as initialized"));
+	OnFailure.Broadcast(nullptr);
+}
+
+void UGetSteamFriendAvatarCallbackProxy::OnAvatarReady(UTexture2D* Avatar)
+{
+	if (Avatar)
+	{
+		OnSuccess.Broadcast(Avatar);
+	}
+	else
+	{
+		OnFailure.Broadcast(nullptr);
+	}
+}
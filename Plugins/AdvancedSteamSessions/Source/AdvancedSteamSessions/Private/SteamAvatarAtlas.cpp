@@ -0,0 +1,426 @@
+#include "SteamAvatarAtlas.h"
+#include "SteamAvatarCache.h"
+#include "Engine/Texture2D.h"
+#include "RHI.h"
+#include "Misc/AutomationTest.h"
+
+namespace SteamAvatarAtlas
+{
+	// Pixels repeated around each avatar, bilinear filtering reads at most one texel past the edge of a cell
+	static const int32 GutterPixels = 1;
+
+	// Steam's avatar sizes in pixels
+	static int32 GetAvatarPixels(SteamAvatarSize Size)
+	{
+		switch (Size)
+		{
+		case SteamAvatarSize::SteamAvatar_Small: return 32;
+		case SteamAvatarSize::SteamAvatar_Medium: return 64;
+		case SteamAvatarSize::SteamAvatar_Large: return 184;
+		default: return 0;
+		}
+	}
+
+	static bool GetSteamId(const FBPUniqueNetId& UniqueNetId, uint64& OutSteamId)
+	{
+#if PLATFORM_WINDOWS || PLATFORM_MAC || PLATFORM_LINUX
+		if (UniqueNetId.IsValid() && UniqueNetId.UniqueNetId->IsValid() && UniqueNetId.UniqueNetId->GetType() == STEAM_SUBSYSTEM)
+		{
+			OutSteamId = *((uint64*)UniqueNetId.UniqueNetId->GetBytes());
+			return true;
+		}
+#endif
+		return false;
+	}
+}
+
+USteamAvatarAtlas* USteamAvatarAtlas::CreateSteamAvatarAtlas(SteamAvatarSize AvatarSize, int32 PageSize)
+{
+	FSteamAvatarCache* AvatarCache = FSteamAvatarCache::Get();
+	if (!AvatarCache)
+	{
+		UE_LOG(AdvancedSteamFriendsLog, Warning, TEXT("CreateSteamAvatarAtlas Couldn't init steamAPI!"));
+		return nullptr;
+	}
+
+	USteamAvatarAtlas* Atlas = NewObject<USteamAvatarAtlas>();
+	if (!Atlas->Initialize(AvatarCache->GetProvider(), AvatarSize, PageSize))
+	{
+		return nullptr;
+	}
+	return Atlas;
+}
+
+bool USteamAvatarAtlas::Initialize(const TSharedRef<ISteamAvatarProvider, ESPMode::ThreadSafe>& InProvider, SteamAvatarSize InAvatarSize, int32 PageSize)
+{
+	AvatarSize = InAvatarSize;
+
+	// The RHI can't create anything bigger, asking for it anyway fails the texture or the device
+	const int32 MaxPageSize = (int32)GetMax2DTextureDimension();
+	if (PageSize > MaxPageSize)
+	{
+		UE_LOG(AdvancedSteamFriendsLog, Warning, TEXT("CreateSteamAvatarAtlas - Page size %d is over the RHI limit, using %d"), PageSize, MaxPageSize);
+		PageSize = MaxPageSize;
+	}
+
+	CellSize = SteamAvatarAtlas::GetAvatarPixels(AvatarSize);
+	CellStride = CellSize + 2 * SteamAvatarAtlas::GutterPixels;
+	if (CellSize == 0 || PageSize < CellStride)
+	{
+		UE_LOG(AdvancedSteamFriendsLog, Warning, TEXT("CreateSteamAvatarAtlas - A %d pixel page can't hold avatars of size %d"), PageSize, (int32)AvatarSize);
+		return false;
+	}
+
+	CellsPerRow = PageSize / CellStride;
+	TexelUVSize = 1.0f / PageSize;
+	const int32 NumCells = CellsPerRow * CellsPerRow;
+
+	AtlasTexture = UTexture2D::CreateTransient(PageSize, PageSize, PF_R8G8B8A8);
+	if (!AtlasTexture)
+	{
+		return false;
+	}
+
+	// Start transparent, cells are only ever written one region at a time after this
+	FTexture2DMipMap& Mip = AtlasTexture->PlatformData->Mips[0];
+	FMemory::Memzero(Mip.BulkData.Lock(LOCK_READ_WRITE), PageSize * PageSize * 4);
+	Mip.BulkData.Unlock();
+	AtlasTexture->NeverStream = true;
+	AtlasTexture->UpdateResource();
+
+	CellOfUser.Empty(NumCells);
+	FilledCells.Init(false, NumCells);
+	UserOfCell.SetNumZeroed(NumCells);
+	GenerationOfCell.SetNumZeroed(NumCells);
+	ImageOfCell.SetNumZeroed(NumCells);
+	NumCellsUsed = 0;
+	NextGeneration = 1;
+
+	Provider = InProvider;
+	AvatarLoadedHandle = Provider->OnAvatarLoaded.AddUObject(this, &USteamAvatarAtlas::OnAvatarLoaded);
+	AvatarChangedHandle = Provider->OnAvatarChanged.AddUObject(this, &USteamAvatarAtlas::OnAvatarChanged);
+	return true;
+}
+
+void USteamAvatarAtlas::BeginDestroy()
+{
+	if (Provider.IsValid())
+	{
+		Provider->OnAvatarLoaded.Remove(AvatarLoadedHandle);
+		Provider->OnAvatarChanged.Remove(AvatarChangedHandle);
+		Provider.Reset();
+	}
+
+	Super::BeginDestroy();
+}
+
+FSlateBrush USteamAvatarAtlas::GetAvatarBrush(const FBPUniqueNetId& UniqueNetId, bool& bIsReady, int32& CellGeneration)
+{
+	FSlateBrush Brush;
+	bIsReady = false;
+	CellGeneration = 0;
+
+	uint64 SteamId = 0;
+	if (!AtlasTexture || !SteamAvatarAtlas::GetSteamId(UniqueNetId, SteamId))
+	{
+		return Brush;
+	}
+
+	const int32 Cell = FindOrAddCell(SteamId);
+	bIsReady = FilledCells[Cell];
+	CellGeneration = GenerationOfCell[Cell];
+
+	Brush.SetResourceObject(AtlasTexture);
+	Brush.ImageSize = FVector2D(CellSize, CellSize);
+	Brush.SetUVRegion(GetCellUVs(Cell));
+	return Brush;
+}
+
+bool USteamAvatarAtlas::GetAvatarUVs(const FBPUniqueNetId& UniqueNetId, FVector2D& UVMin, FVector2D& UVMax, int32& CellGeneration)
+{
+	CellGeneration = 0;
+
+	uint64 SteamId = 0;
+	if (!AtlasTexture || !SteamAvatarAtlas::GetSteamId(UniqueNetId, SteamId))
+	{
+		return false;
+	}
+
+	const int32 Cell = FindOrAddCell(SteamId);
+	const FBox2D UVs = GetCellUVs(Cell);
+	UVMin = UVs.Min;
+	UVMax = UVs.Max;
+	CellGeneration = GenerationOfCell[Cell];
+	return true;
+}
+
+bool USteamAvatarAtlas::IsAvatarCellCurrent(const FBPUniqueNetId& UniqueNetId, int32 CellGeneration) const
+{
+	uint64 SteamId = 0;
+	if (!AtlasTexture || !SteamAvatarAtlas::GetSteamId(UniqueNetId, SteamId))
+	{
+		return false;
+	}
+
+	// Asking isn't using, leave the order alone
+	const int32* Cell = CellOfUser.Find(SteamId);
+	return Cell && GenerationOfCell[*Cell] == CellGeneration;
+}
+
+int32 USteamAvatarAtlas::FindOrAddCell(uint64 SteamId)
+{
+	if (const int32* Cell = CellOfUser.FindAndTouch(SteamId))
+	{
+		return *Cell;
+	}
+
+	int32 Cell = INDEX_NONE;
+	if (NumCellsUsed < CellOfUser.Max())
+	{
+		Cell = NumCellsUsed++;
+	}
+	else
+	{
+		// Page is full, take over the cell nobody has asked for the longest
+		Cell = CellOfUser.RemoveLeastRecent();
+		PendingUsers.Remove(UserOfCell[Cell]);
+
+		// Blank it so the previous face doesn't show while the new one downloads
+		if (FilledCells[Cell])
+		{
+			FilledCells[Cell] = false;
+			UploadCell(Cell, (uint8*)FMemory::MallocZeroed(CellSize * CellSize * 4));
+		}
+	}
+
+	CellOfUser.Add(SteamId, Cell);
+	UserOfCell[Cell] = SteamId;
+	GenerationOfCell[Cell] = NextGeneration++;
+
+	if (!TryFillCell(SteamId, Cell))
+	{
+		PendingUsers.Add(SteamId);
+	}
+	return Cell;
+}
+
+bool USteamAvatarAtlas::TryFillCell(uint64 SteamId, int32 Cell)
+{
+	const int32 Image = Provider->GetAvatarImage(SteamId, AvatarSize);
+	if (Image == -1)
+	{
+		return false;
+	}
+
+	ImageOfCell[Cell] = Image;
+
+	// No avatar, the cell stays blank but there's nothing to wait for
+	if (Image == 0)
+	{
+		return true;
+	}
+
+	uint32 Width = 0;
+	uint32 Height = 0;
+	if (!Provider->GetImageSize(Image, Width, Height) || Width != (uint32)CellSize || Height != (uint32)CellSize)
+	{
+		UE_LOG(AdvancedSteamFriendsLog, Warning, TEXT("SteamAvatarAtlas - Avatar is %ux%u, expected %d"), Width, Height, CellSize);
+		return true;
+	}
+
+	// The render thread reads the pixels later, so they need their own buffer which it frees when done
+	const int32 NumBytes = CellSize * CellSize * 4;
+	uint8* Pixels = (uint8*)FMemory::Malloc(NumBytes);
+	if (!Provider->CopyImageRGBA(Image, Pixels, NumBytes))
+	{
+		FMemory::Free(Pixels);
+		return true;
+	}
+
+	FilledCells[Cell] = true;
+	UploadCell(Cell, Pixels);
+	return true;
+}
+
+void USteamAvatarAtlas::RefillCell(uint64 SteamId, int32 Cell)
+{
+	const bool bWasFilled = FilledCells[Cell];
+	FilledCells[Cell] = false;
+
+	if (TryFillCell(SteamId, Cell))
+	{
+		PendingUsers.Remove(SteamId);
+	}
+	else
+	{
+		PendingUsers.Add(SteamId);
+	}
+
+	// Nothing replaced the old face, so take it down rather than keep showing it
+	if (bWasFilled && !FilledCells[Cell])
+	{
+		UploadCell(Cell, (uint8*)FMemory::MallocZeroed(CellSize * CellSize * 4));
+	}
+}
+
+void USteamAvatarAtlas::UploadCell(int32 Cell, uint8* Pixels)
+{
+	// Repeat the outermost pixels into the gutter, so sampling the edge of the cell blends with itself
+	const int32 Gutter = SteamAvatarAtlas::GutterPixels;
+	uint8* Padded = (uint8*)FMemory::Malloc(CellStride * CellStride * 4);
+	for (int32 Y = 0; Y < CellStride; ++Y)
+	{
+		const uint32* SrcRow = (const uint32*)Pixels + FMath::Clamp(Y - Gutter, 0, CellSize - 1) * CellSize;
+		uint32* DestRow = (uint32*)Padded + Y * CellStride;
+
+		for (int32 X = 0; X < CellStride; ++X)
+		{
+			DestRow[X] = SrcRow[FMath::Clamp(X - Gutter, 0, CellSize - 1)];
+		}
+	}
+	FMemory::Free(Pixels);
+
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D((Cell % CellsPerRow) * CellStride, (Cell / CellsPerRow) * CellStride, 0, 0, CellStride, CellStride);
+
+	AtlasTexture->UpdateTextureRegions(0, 1, Region, CellStride * 4, 4, Padded, [](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+	{
+		FMemory::Free(SrcData);
+		delete Regions;
+	});
+}
+
+void USteamAvatarAtlas::OnAvatarLoaded(uint64 SteamId)
+{
+	// Don't touch the order here, arriving isn't the same as being asked for
+	const int32* Cell = CellOfUser.Find(SteamId);
+
+	if (PendingUsers.Contains(SteamId))
+	{
+		if (!Cell || TryFillCell(SteamId, *Cell))
+		{
+			PendingUsers.Remove(SteamId);
+		}
+		return;
+	}
+
+	// Also sent when a user's new avatar has downloaded, which shows up as a different image for the same player
+	if (Cell && Provider->GetAvatarImage(SteamId, AvatarSize) != ImageOfCell[*Cell])
+	{
+		RefillCell(SteamId, *Cell);
+	}
+}
+
+void USteamAvatarAtlas::OnAvatarChanged(uint64 SteamId)
+{
+	// The player keeps their cell and its generation, brushes onto it pick up the new face by themselves
+	if (const int32* Cell = CellOfUser.Find(SteamId))
+	{
+		RefillCell(SteamId, *Cell);
+	}
+}
+
+FBox2D USteamAvatarAtlas::GetCellUVs(int32 Cell) const
+{
+	// The avatar sits inside the gutter
+	const int32 Gutter = SteamAvatarAtlas::GutterPixels;
+	const FVector2D Min(((Cell % CellsPerRow) * CellStride + Gutter) * TexelUVSize, ((Cell / CellsPerRow) * CellStride + Gutter) * TexelUVSize);
+	return FBox2D(Min, Min + FVector2D(CellSize * TexelUVSize, CellSize * TexelUVSize));
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Serves solid colour medium avatars from memory, an id ending in 2 arrives on Deliver() and ChangeAvatar() gives a player a new image
+class FFakeAtlasAvatarProvider : public ISteamAvatarProvider
+{
+public:
+
+	virtual int32 GetAvatarImage(uint64 SteamId, SteamAvatarSize Size) override
+	{
+		if (SteamId % 10 == 2 && !Delivered.Contains(SteamId))
+		{
+			return -1;
+		}
+
+		// Encode the id and how often it changed in the handle so the pixels can be made from it
+		return (int32)((SteamId % 100000) * 16 + Versions.FindRef(SteamId) % 16);
+	}
+
+	virtual bool GetImageSize(int32 Image, uint32& OutWidth, uint32& OutHeight) override
+	{
+		OutWidth = OutHeight = 64;
+		return true;
+	}
+
+	virtual bool CopyImageRGBA(int32 Image, uint8* Dest, int32 DestSize) override
+	{
+		FMemory::Memset(Dest, (uint8)Image, DestSize);
+		return true;
+	}
+
+	void Deliver(uint64 SteamId)
+	{
+		Delivered.Add(SteamId);
+		OnAvatarLoaded.Broadcast(SteamId);
+	}
+
+	void ChangeAvatar(uint64 SteamId)
+	{
+		++Versions.FindOrAdd(SteamId);
+		OnAvatarChanged.Broadcast(SteamId);
+	}
+
+private:
+
+	TSet<uint64> Delivered;
+	TMap<uint64, int32> Versions;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSteamAvatarAtlasTest, "AdvancedSteamSessions.AvatarAtlas", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Checks cell allocation, reuse and generations, and that downloads and avatar changes fill cells in place
+bool FSteamAvatarAtlasTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<FFakeAtlasAvatarProvider, ESPMode::ThreadSafe> Provider = MakeShared<FFakeAtlasAvatarProvider, ESPMode::ThreadSafe>();
+
+	// Two 66 pixel cells fit across a 140 pixel page
+	USteamAvatarAtlas* Atlas = NewObject<USteamAvatarAtlas>();
+	if (!TestTrue(TEXT("Atlas initializes"), Atlas->Initialize(Provider, SteamAvatarSize::SteamAvatar_Medium, 140)))
+	{
+		return false;
+	}
+	TestEqual(TEXT("Page holds four cells"), Atlas->GetCapacity(), 4);
+
+	const int32 First = Atlas->FindOrAddCell(100);
+	const int32 FirstGeneration = Atlas->GenerationOfCell[First];
+	TestTrue(TEXT("Available avatar fills its cell"), Atlas->FilledCells[First]);
+	TestEqual(TEXT("Same player keeps the same cell"), Atlas->FindOrAddCell(100), First);
+	TestEqual(TEXT("Asking again keeps the generation"), Atlas->GenerationOfCell[First], FirstGeneration);
+
+	Atlas->FindOrAddCell(110);
+	Atlas->FindOrAddCell(120);
+	Atlas->FindOrAddCell(130);
+	TestEqual(TEXT("Every cell is handed out before any is reused"), Atlas->GetNumAvatars(), 4);
+
+	// Page is full, 100 was asked for least recently
+	const int32 Reused = Atlas->FindOrAddCell(102);
+	TestEqual(TEXT("Least recently requested cell is reused"), Reused, First);
+	TestNotEqual(TEXT("Reused cell gets a new generation"), Atlas->GenerationOfCell[Reused], FirstGeneration);
+	TestFalse(TEXT("Reused cell is blank while the avatar downloads"), Atlas->FilledCells[Reused]);
+	TestFalse(TEXT("Evicted player no longer has a cell"), Atlas->CellOfUser.Contains(100));
+
+	Provider->Deliver(102);
+	TestTrue(TEXT("Downloaded avatar fills its cell"), Atlas->FilledCells[Reused]);
+	TestEqual(TEXT("Nothing is pending after delivery"), Atlas->PendingUsers.Num(), 0);
+
+	const int32 Changed = Atlas->FindOrAddCell(110);
+	const int32 ChangedGeneration = Atlas->GenerationOfCell[Changed];
+	const int32 OldImage = Atlas->ImageOfCell[Changed];
+	Provider->ChangeAvatar(110);
+	TestNotEqual(TEXT("Changed avatar is copied into the cell"), Atlas->ImageOfCell[Changed], OldImage);
+	TestTrue(TEXT("Changed avatar keeps the cell filled"), Atlas->FilledCells[Changed]);
+	TestEqual(TEXT("Changed avatar keeps the generation"), Atlas->GenerationOfCell[Changed], ChangedGeneration);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,359 @@
+#include "SteamAvatarCache.h"
+#include "Engine/Texture2D.h"
+#include "Async/Async.h"
+#include "Misc/AutomationTest.h"
+
+#if PLATFORM_WINDOWS || PLATFORM_MAC || PLATFORM_LINUX
+
+// Reads avatars through ISteamFriends / ISteamUtils
+class FSteamworksAvatarProvider : public ISteamAvatarProvider, public TSharedFromThis<FSteamworksAvatarProvider, ESPMode::ThreadSafe>
+{
+public:
+
+	virtual int32 GetAvatarImage(uint64 SteamId, SteamAvatarSize Size) override
+	{
+		int32 Image = 0;
+		switch (Size)
+		{
+		case SteamAvatarSize::SteamAvatar_Small: Image = SteamFriends()->GetSmallFriendAvatar(SteamId); break;
+		case SteamAvatarSize::SteamAvatar_Medium: Image = SteamFriends()->GetMediumFriendAvatar(SteamId); break;
+		case SteamAvatarSize::SteamAvatar_Large: Image = SteamFriends()->GetLargeFriendAvatar(SteamId); break;
+		default: break;
+		}
+
+		// Avatars of users who aren't friends only download once their info is asked for
+		if (Image == -1)
+		{
+			SteamFriends()->RequestUserInformation(SteamId, false);
+		}
+		return Image;
+	}
+
+	virtual bool GetImageSize(int32 Image, uint32& OutWidth, uint32& OutHeight) override
+	{
+		return SteamUtils()->GetImageSize(Image, &OutWidth, &OutHeight);
+	}
+
+	virtual bool CopyImageRGBA(int32 Image, uint8* Dest, int32 DestSize) override
+	{
+		return SteamUtils()->GetImageRGBA(Image, Dest, DestSize);
+	}
+
+private:
+
+	// Steam callbacks run on the online thread, the cache is only touched on the game thread
+	void BroadcastOnGameThread(FOnSteamAvatarEvent ISteamAvatarProvider::* Event, uint64 SteamId)
+	{
+		TWeakPtr<FSteamworksAvatarProvider, ESPMode::ThreadSafe> WeakThis = AsShared();
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Event, SteamId]()
+		{
+			if (TSharedPtr<FSteamworksAvatarProvider, ESPMode::ThreadSafe> This = WeakThis.Pin())
+			{
+				(This.Get()->*Event).Broadcast(SteamId);
+			}
+		});
+	}
+
+	STEAM_CALLBACK(FSteamworksAvatarProvider, OnAvatarImageLoaded, AvatarImageLoaded_t)
+	{
+		BroadcastOnGameThread(&ISteamAvatarProvider::OnAvatarLoaded, pParam->m_steamID.ConvertToUint64());
+	}
+
+	STEAM_CALLBACK(FSteamworksAvatarProvider, OnPersonaStateChange, PersonaStateChange_t)
+	{
+		if (pParam->m_nChangeFlags & k_EPersonaChangeAvatar)
+		{
+			BroadcastOnGameThread(&ISteamAvatarProvider::OnAvatarChanged, pParam->m_ulSteamID);
+		}
+	}
+};
+
+#endif
+
+static FSteamAvatarCache* GSteamAvatarCache = nullptr;
+
+FSteamAvatarCache* FSteamAvatarCache::Get()
+{
+#if PLATFORM_WINDOWS || PLATFORM_MAC || PLATFORM_LINUX
+	if (!GSteamAvatarCache && SteamAPI_Init())
+	{
+		GSteamAvatarCache = new FSteamAvatarCache(MakeShared<FSteamworksAvatarProvider, ESPMode::ThreadSafe>());
+	}
+#endif
+	return GSteamAvatarCache;
+}
+
+void FSteamAvatarCache::Shutdown()
+{
+	delete GSteamAvatarCache;
+	GSteamAvatarCache = nullptr;
+}
+
+FSteamAvatarCache::FSteamAvatarCache(const TSharedRef<ISteamAvatarProvider, ESPMode::ThreadSafe>& InProvider, int32 MaxTextures)
+	: Provider(InProvider)
+	, Lookup(FMath::Max(1, MaxTextures))
+{
+	Slots.Reserve(Lookup.Max());
+	AvatarLoadedHandle = Provider->OnAvatarLoaded.AddRaw(this, &FSteamAvatarCache::OnAvatarLoaded);
+	AvatarChangedHandle = Provider->OnAvatarChanged.AddRaw(this, &FSteamAvatarCache::OnAvatarChanged);
+}
+
+FSteamAvatarCache::~FSteamAvatarCache()
+{
+	Provider->OnAvatarLoaded.Remove(AvatarLoadedHandle);
+	Provider->OnAvatarChanged.Remove(AvatarChangedHandle);
+}
+
+UTexture2D* FSteamAvatarCache::Find(uint64 SteamId, SteamAvatarSize Size, bool& bOutLoading)
+{
+	const FAvatarKey Key{ SteamId, Size };
+
+	UTexture2D* Texture = nullptr;
+	const ELoadResult Result = Load(Key, Texture);
+
+	// Remember the miss so the texture is made when the download finishes, even with nobody waiting on it
+	bOutLoading = Result == ELoadResult::Loading;
+	if (bOutLoading)
+	{
+		Pending.FindOrAdd(Key);
+	}
+	return Texture;
+}
+
+void FSteamAvatarCache::Request(uint64 SteamId, SteamAvatarSize Size, FOnSteamAvatarReady OnReady)
+{
+	const FAvatarKey Key{ SteamId, Size };
+
+	UTexture2D* Texture = nullptr;
+	if (Load(Key, Texture) == ELoadResult::Loading)
+	{
+		Pending.FindOrAdd(Key).Add(MoveTemp(OnReady));
+		return;
+	}
+
+	OnReady.ExecuteIfBound(Texture);
+}
+
+FSteamAvatarCache::ELoadResult FSteamAvatarCache::Load(const FAvatarKey& Key, UTexture2D*& OutTexture)
+{
+	OutTexture = nullptr;
+
+	if (const int32* Slot = Lookup.FindAndTouch(Key))
+	{
+		++Stats.Hits;
+		OutTexture = Slots[*Slot];
+		return ELoadResult::Loaded;
+	}
+
+	++Stats.Misses;
+
+	const int32 Image = Provider->GetAvatarImage(Key.SteamId, Key.Size);
+	if (Image == -1)
+	{
+		return ELoadResult::Loading;
+	}
+
+	OutTexture = Image > 0 ? CreateTexture(Image) : nullptr;
+	if (!OutTexture)
+	{
+		return ELoadResult::Failed;
+	}
+
+	Store(Key, OutTexture);
+	return ELoadResult::Loaded;
+}
+
+UTexture2D* FSteamAvatarCache::CreateTexture(int32 Image)
+{
+	uint32 Width = 0;
+	uint32 Height = 0;
+	if (!Provider->GetImageSize(Image, Width, Height) || Width == 0 || Height == 0)
+	{
+		UE_LOG(AdvancedSteamFriendsLog, Warning, TEXT("Bad Height / Width with steam avatar!"));
+		return nullptr;
+	}
+
+	UTexture2D* Avatar = UTexture2D::CreateTransient(Width, Height, PF_R8G8B8A8);
+	if (!Avatar)
+	{
+		return nullptr;
+	}
+
+	// Copy straight into the mip instead of going through a temporary buffer
+	FTexture2DMipMap& Mip = Avatar->PlatformData->Mips[0];
+	uint8* MipData = (uint8*)Mip.BulkData.Lock(LOCK_READ_WRITE);
+	const bool bCopied = Provider->CopyImageRGBA(Image, MipData, Width * Height * 4);
+	Mip.BulkData.Unlock();
+
+	if (!bCopied)
+	{
+		UE_LOG(AdvancedSteamFriendsLog, Warning, TEXT("Couldn't read the pixels of steam avatar image %d"), Image);
+		return nullptr;
+	}
+
+	Avatar->PlatformData->SetNumSlices(1);
+	Avatar->NeverStream = true;
+	Avatar->UpdateResource();
+
+	++Stats.TexturesCreated;
+	return Avatar;
+}
+
+void FSteamAvatarCache::Store(const FAvatarKey& Key, UTexture2D* Texture)
+{
+	int32 Slot = INDEX_NONE;
+	if (Lookup.Num() >= Lookup.Max())
+	{
+		// Reuse the slot of the least recently used avatar, anything still showing it keeps its own reference
+		Slot = Lookup.RemoveLeastRecent();
+		++Stats.TexturesEvicted;
+	}
+	else if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop(false);
+	}
+	else
+	{
+		Slot = Slots.Add(nullptr);
+	}
+
+	Slots[Slot] = Texture;
+	Lookup.Add(Key, Slot);
+}
+
+void FSteamAvatarCache::Empty()
+{
+	Lookup.Empty(Lookup.Max());
+	Slots.Reset();
+	FreeSlots.Reset();
+}
+
+void FSteamAvatarCache::OnAvatarLoaded(uint64 SteamId)
+{
+	// The event doesn't say which size arrived, so try every size someone is waiting on for this user
+	for (uint8 SizeIndex = (uint8)SteamAvatarSize::SteamAvatar_Small; SizeIndex <= (uint8)SteamAvatarSize::SteamAvatar_Large; ++SizeIndex)
+	{
+		const FAvatarKey Key{ SteamId, (SteamAvatarSize)SizeIndex };
+		if (!Pending.Contains(Key))
+		{
+			continue;
+		}
+
+		UTexture2D* Texture = nullptr;
+		if (Load(Key, Texture) == ELoadResult::Loading)
+		{
+			continue;
+		}
+
+		TArray<FOnSteamAvatarReady> Callbacks;
+		Pending.RemoveAndCopyValue(Key, Callbacks);
+		for (FOnSteamAvatarReady& Callback : Callbacks)
+		{
+			Callback.ExecuteIfBound(Texture);
+		}
+	}
+}
+
+void FSteamAvatarCache::OnAvatarChanged(uint64 SteamId)
+{
+	for (uint8 SizeIndex = (uint8)SteamAvatarSize::SteamAvatar_Small; SizeIndex <= (uint8)SteamAvatarSize::SteamAvatar_Large; ++SizeIndex)
+	{
+		const FAvatarKey Key{ SteamId, (SteamAvatarSize)SizeIndex };
+		if (const int32* Slot = Lookup.Find(Key))
+		{
+			const int32 FreedSlot = *Slot;
+			Slots[FreedSlot] = nullptr;
+			FreeSlots.Add(FreedSlot);
+			Lookup.Remove(Key);
+		}
+	}
+}
+
+void FSteamAvatarCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObjects(Slots);
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Serves solid colour images from memory, an id ending in 1 has no avatar and one ending in 2 arrives on Deliver()
+class FFakeSteamAvatarProvider : public ISteamAvatarProvider
+{
+public:
+
+	virtual int32 GetAvatarImage(uint64 SteamId, SteamAvatarSize Size) override
+	{
+		if (SteamId % 10 == 1)
+		{
+			return 0;
+		}
+
+		if (SteamId % 10 == 2 && !Delivered.Contains(SteamId))
+		{
+			return -1;
+		}
+
+		// Encode the id and size in the handle so the pixels can be made from it
+		return (int32)((SteamId % 100000) * 4 + (uint8)Size);
+	}
+
+	virtual bool GetImageSize(int32 Image, uint32& OutWidth, uint32& OutHeight) override
+	{
+		OutWidth = OutHeight = 8 << (Image % 4);
+		return true;
+	}
+
+	virtual bool CopyImageRGBA(int32 Image, uint8* Dest, int32 DestSize) override
+	{
+		FMemory::Memset(Dest, (uint8)Image, DestSize);
+		return true;
+	}
+
+	void Deliver(uint64 SteamId)
+	{
+		Delivered.Add(SteamId);
+		OnAvatarLoaded.Broadcast(SteamId);
+	}
+
+private:
+
+	TSet<uint64> Delivered;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSteamAvatarCacheTest, "AdvancedSteamSessions.AvatarCache", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Checks the cache's reuse, async completion and eviction against the fake provider
+bool FSteamAvatarCacheTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<FFakeSteamAvatarProvider, ESPMode::ThreadSafe> Provider = MakeShared<FFakeSteamAvatarProvider, ESPMode::ThreadSafe>();
+	FSteamAvatarCache Cache(Provider, 2);
+
+	bool bLoading = false;
+	UTexture2D* First = Cache.Find(100, SteamAvatarSize::SteamAvatar_Small, bLoading);
+	TestTrue(TEXT("Available avatar is returned"), First != nullptr && !bLoading);
+	TestEqual(TEXT("Second lookup returns the same texture"), Cache.Find(100, SteamAvatarSize::SteamAvatar_Small, bLoading), First);
+	TestNotEqual(TEXT("Sizes are cached separately"), Cache.Find(100, SteamAvatarSize::SteamAvatar_Medium, bLoading), First);
+
+	TestNull(TEXT("User without an avatar fails"), Cache.Find(101, SteamAvatarSize::SteamAvatar_Small, bLoading));
+	TestFalse(TEXT("User without an avatar isn't loading"), bLoading);
+
+	UTexture2D* Delivered = nullptr;
+	int32 NumCalls = 0;
+	Cache.Request(102, SteamAvatarSize::SteamAvatar_Small, FOnSteamAvatarReady::CreateLambda([&](UTexture2D* Avatar) { Delivered = Avatar; ++NumCalls; }));
+	TestEqual(TEXT("Downloading avatar waits"), NumCalls, 0);
+	TestEqual(TEXT("Downloading avatar is pending"), Cache.NumPending(), 1);
+	Provider->Deliver(102);
+	TestEqual(TEXT("Downloaded avatar completes the request once"), NumCalls, 1);
+	TestNotNull(TEXT("Downloaded avatar is delivered"), Delivered);
+	TestEqual(TEXT("Nothing is pending after delivery"), Cache.NumPending(), 0);
+
+	// Holds 2, small 100 was used least recently after medium 100 and 102 were added
+	TestEqual(TEXT("Cache is bounded"), Cache.Num(), 2);
+	TestEqual(TEXT("Least recently used avatar is evicted"), Cache.GetStats().TexturesEvicted, 1);
+	TestEqual(TEXT("Recent avatar survives eviction"), Cache.Find(102, SteamAvatarSize::SteamAvatar_Small, bLoading), Delivered);
+	TestNotEqual(TEXT("Evicted avatar is made again"), Cache.Find(100, SteamAvatarSize::SteamAvatar_Small, bLoading), First);
+
+	return true;
+}
+
+#endif
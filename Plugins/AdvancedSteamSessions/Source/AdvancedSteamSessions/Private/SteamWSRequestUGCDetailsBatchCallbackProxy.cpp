@@ -0,0 +1,54 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "SteamWSRequestUGCDetailsBatchCallbackProxy.h"
+#include "SteamWorkshopDetailsCache.h"
+
+//////////////////////////////////////////////////////////////////////////
+// USteamWSRequestUGCDetailsBatchCallbackProxy
+
+USteamWSRequestUGCDetailsBatchCallbackProxy::USteamWSRequestUGCDetailsBatchCallbackProxy(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, MaxCacheAgeSeconds(300.0f)
+{
+}
+
+USteamWSRequestUGCDetailsBatchCallbackProxy* USteamWSRequestUGCDetailsBatchCallbackProxy::GetWorkshopItemDetailsBatch(UObject* WorldContextObject, const TArray<FBPSteamWorkshopID>& WorkShopIDs, float MaxCacheAgeSeconds)
+{
+	USteamWSRequestUGCDetailsBatchCallbackProxy* Proxy = NewObject<USteamWSRequestUGCDetailsBatchCallbackProxy>();
+
+	Proxy->WorkShopIDs = WorkShopIDs;
+	Proxy->MaxCacheAgeSeconds = MaxCacheAgeSeconds;
+	return Proxy;
+}
+
+void USteamWSRequestUGCDetailsBatchCallbackProxy::Activate()
+{
+	FSteamWorkshopDetailsCache* DetailsCache = FSteamWorkshopDetailsCache::Get();
+	if (!DetailsCache)
+	{
+		UE_LOG(AdvancedSteamWorkshopLog, Warning, TEXT("GetWorkshopItemDetailsBatch Failed: Steam isn't running!"));
+		OnFailure.Broadcast(TArray<FBPSteamWorkshopItemDetails>());
+		return;
+	}
+
+	TArray<uint64> ItemIds;
+	ItemIds.Reserve(WorkShopIDs.Num());
+	for (const FBPSteamWorkshopID& WorkShopID : WorkShopIDs)
+	{
+		ItemIds.Add(WorkShopID.SteamWorkshopID);
+	}
+
+	DetailsCache->RequestDetails(ItemIds, MaxCacheAgeSeconds, FOnWorkshopDetailsReady::CreateUObject(this, &ThisClass::OnDetailsReady));
+}
+
+void USteamWSRequestUGCDetailsBatchCallbackProxy::OnDetailsReady(bool bAllFound, const TArray<FBPSteamWorkshopItemDetails>& Details)
+{
+	if (bAllFound)
+	{
+		OnSuccess.Broadcast(Details);
+	}
+	else
+	{
+		OnFailure.Broadcast(Details);
+	}
+}
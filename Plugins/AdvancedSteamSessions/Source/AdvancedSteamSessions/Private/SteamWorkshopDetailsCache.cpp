@@ -0,0 +1,362 @@
+#include "SteamWorkshopDetailsCache.h"
+#include "OnlineSubSystemHeader.h"
+#include "Misc/AutomationTest.h"
+#include "Async/Async.h"
+
+#if PLATFORM_WINDOWS || PLATFORM_MAC || PLATFORM_LINUX
+#include "OnlineSubsystemSteam.h"
+#include "steam/isteamugc.h"
+
+// Runs detail queries through ISteamUGC one at a time, the call result only tracks one query
+class FSteamworksUGCProvider : public IWorkshopUGCProvider, public TSharedFromThis<FSteamworksUGCProvider, ESPMode::ThreadSafe>
+{
+public:
+
+	virtual int32 GetMaxItemsPerQuery() const override
+	{
+		return kNumUGCResultsPerPage;
+	}
+
+	virtual void QueryDetails(const TArray<uint64>& ItemIds, FOnWorkshopDetailsQueried OnComplete) override
+	{
+		FQuery& Query = Queue.AddDefaulted_GetRef();
+		Query.ItemIds = ItemIds;
+		Query.OnComplete = MoveTemp(OnComplete);
+
+		if (!bQueryInFlight)
+		{
+			SendNextQuery();
+		}
+	}
+
+private:
+
+	struct FQuery
+	{
+		TArray<uint64> ItemIds;
+		FOnWorkshopDetailsQueried OnComplete;
+	};
+
+	void SendNextQuery()
+	{
+		while (Queue.Num() > 0)
+		{
+			// Steam has shut down, nothing queued can be sent
+			if (SteamUGC() == nullptr)
+			{
+				FQuery Query = MoveTemp(Queue[0]);
+				Queue.RemoveAt(0);
+				Query.OnComplete.ExecuteIfBound(false, FWorkshopDetailsMap());
+				continue;
+			}
+
+			TArray<uint64>& ItemIds = Queue[0].ItemIds;
+			UGCQueryHandle_t hQueryHandle = SteamUGC()->CreateQueryUGCDetailsRequest((PublishedFileId_t *)ItemIds.GetData(), ItemIds.Num());
+			SteamAPICall_t hSteamAPICall = SteamUGC()->SendQueryUGCRequest(hQueryHandle);
+
+			if (hSteamAPICall != k_uAPICallInvalid)
+			{
+				bQueryInFlight = true;
+				m_callResultUGCRequestDetails.Set(hSteamAPICall, this, &FSteamworksUGCProvider::OnUGCRequestUGCDetails);
+				return;
+			}
+
+			SteamUGC()->ReleaseQueryUGCRequest(hQueryHandle);
+
+			FQuery Query = MoveTemp(Queue[0]);
+			Queue.RemoveAt(0);
+			Query.OnComplete.ExecuteIfBound(false, FWorkshopDetailsMap());
+		}
+	}
+
+	// Runs on the online thread, reads the results there and finishes on the game thread
+	void OnUGCRequestUGCDetails(SteamUGCQueryCompleted_t *pResult, bool bIOFailure)
+	{
+		const bool bWasSuccessful = !bIOFailure && pResult && pResult->m_eResult == k_EResultOK;
+
+		FWorkshopDetailsMap DetailsById;
+		if (bWasSuccessful)
+		{
+			for (uint32 i = 0; i < pResult->m_unNumResultsReturned; ++i)
+			{
+				SteamUGCDetails_t Details;
+				if (SteamUGC()->GetQueryUGCResult(pResult->m_handle, i, &Details) && Details.m_eResult == k_EResultOK)
+				{
+					DetailsById.Add(Details.m_nPublishedFileId, FBPSteamWorkshopItemDetails(Details));
+				}
+			}
+		}
+
+		// The results have been read, the query can go now
+		if (pResult)
+		{
+			SteamUGC()->ReleaseQueryUGCRequest(pResult->m_handle);
+		}
+
+		TWeakPtr<FSteamworksUGCProvider, ESPMode::ThreadSafe> WeakThis = AsShared();
+		TFunction<void()> FinishQuery = [WeakThis, bWasSuccessful, DetailsById]()
+		{
+			TSharedPtr<FSteamworksUGCProvider, ESPMode::ThreadSafe> This = WeakThis.Pin();
+			if (!This.IsValid() || This->Queue.Num() == 0)
+			{
+				return;
+			}
+
+			This->bQueryInFlight = false;
+
+			FQuery Query = MoveTemp(This->Queue[0]);
+			This->Queue.RemoveAt(0);
+			Query.OnComplete.ExecuteIfBound(bWasSuccessful, DetailsById);
+
+			This->SendNextQuery();
+		};
+
+		FOnlineSubsystemSteam* SteamSubsystem = (FOnlineSubsystemSteam*)(IOnlineSubsystem::Get(STEAM_SUBSYSTEM));
+		if (SteamSubsystem != nullptr)
+		{
+			SteamSubsystem->ExecuteNextTick(MoveTemp(FinishQuery));
+		}
+		else
+		{
+			// The subsystem is going away, still finish the query so the queue doesn't stall behind it
+			AsyncTask(ENamedThreads::GameThread, MoveTemp(FinishQuery));
+		}
+	}
+
+	// Queries waiting to be sent, the first one is in flight while bQueryInFlight is set
+	TArray<FQuery> Queue;
+
+	bool bQueryInFlight = false;
+
+	CCallResult<FSteamworksUGCProvider, SteamUGCQueryCompleted_t> m_callResultUGCRequestDetails;
+};
+
+#endif
+
+static FSteamWorkshopDetailsCache* GSteamWorkshopDetailsCache = nullptr;
+
+FSteamWorkshopDetailsCache* FSteamWorkshopDetailsCache::Get()
+{
+#if PLATFORM_WINDOWS || PLATFORM_MAC || PLATFORM_LINUX
+	if (!GSteamWorkshopDetailsCache && SteamAPI_Init())
+	{
+		GSteamWorkshopDetailsCache = new FSteamWorkshopDetailsCache(MakeShared<FSteamworksUGCProvider, ESPMode::ThreadSafe>());
+	}
+#endif
+	return GSteamWorkshopDetailsCache;
+}
+
+void FSteamWorkshopDetailsCache::Shutdown()
+{
+	delete GSteamWorkshopDetailsCache;
+	GSteamWorkshopDetailsCache = nullptr;
+}
+
+FSteamWorkshopDetailsCache::FSteamWorkshopDetailsCache(const TSharedRef<IWorkshopUGCProvider, ESPMode::ThreadSafe>& InProvider)
+	: Provider(InProvider)
+{
+}
+
+const FBPSteamWorkshopItemDetails* FSteamWorkshopDetailsCache::FindCached(uint64 ItemId, double MaxAgeSeconds) const
+{
+	const FCachedDetails* Cached = Cache.Find(ItemId);
+	if (!Cached || (MaxAgeSeconds >= 0.0 && FPlatformTime::Seconds() - Cached->FetchedTime > MaxAgeSeconds))
+	{
+		return nullptr;
+	}
+	return &Cached->Details;
+}
+
+void FSteamWorkshopDetailsCache::RequestDetails(const TArray<uint64>& ItemIds, double MaxAgeSeconds, FOnWorkshopDetailsReady OnReady)
+{
+	TSharedRef<FBatch> Batch = MakeShared<FBatch>();
+	Batch->ItemIds = ItemIds;
+	Batch->OnReady = MoveTemp(OnReady);
+
+	// Only fetch what's missing or stale, and each item once even if it was asked for twice
+	TSet<uint64> Queued;
+	for (uint64 ItemId : ItemIds)
+	{
+		++Stats.ItemsRequested;
+		if (FindCached(ItemId, MaxAgeSeconds))
+		{
+			++Stats.CacheHits;
+		}
+		else if (!Queued.Contains(ItemId))
+		{
+			Queued.Add(ItemId);
+			Batch->ToFetch.Add(ItemId);
+		}
+	}
+
+	QueryNextPage(Batch);
+}
+
+void FSteamWorkshopDetailsCache::QueryNextPage(TSharedRef<FBatch> Batch)
+{
+	if (Batch->NextToFetch >= Batch->ToFetch.Num())
+	{
+		FinishBatch(*Batch);
+		return;
+	}
+
+	const int32 PageStart = Batch->NextToFetch;
+	const int32 PageSize = FMath::Min(FMath::Max(1, Provider->GetMaxItemsPerQuery()), Batch->ToFetch.Num() - PageStart);
+	Batch->NextToFetch += PageSize;
+
+	TArray<uint64> PageIds(Batch->ToFetch.GetData() + PageStart, PageSize);
+
+	++Stats.QueriesSent;
+	Provider->QueryDetails(PageIds, FOnWorkshopDetailsQueried::CreateRaw(this, &FSteamWorkshopDetailsCache::OnPageQueried, Batch, PageStart, PageSize));
+}
+
+void FSteamWorkshopDetailsCache::OnPageQueried(bool bWasSuccessful, const FWorkshopDetailsMap& DetailsById, TSharedRef<FBatch> Batch, int32 PageStart, int32 PageSize)
+{
+	if (!bWasSuccessful)
+	{
+		++Stats.QueriesFailed;
+		UE_LOG(AdvancedSteamWorkshopLog, Warning, TEXT("WorkshopDetailsCache - Query for %d items failed"), PageSize);
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	for (int32 Index = PageStart; Index < PageStart + PageSize; ++Index)
+	{
+		const uint64 ItemId = Batch->ToFetch[Index];
+		if (const FBPSteamWorkshopItemDetails* Details = DetailsById.Find(ItemId))
+		{
+			FCachedDetails& Cached = Cache.FindOrAdd(ItemId);
+			Cached.Details = *Details;
+			Cached.FetchedTime = Now;
+		}
+		else if (!bWasSuccessful)
+		{
+			Batch->Failed.Add(ItemId);
+		}
+		else
+		{
+			// Steam answered and the item wasn't there, drop anything stale about it
+			Cache.Remove(ItemId);
+		}
+	}
+
+	QueryNextPage(Batch);
+}
+
+void FSteamWorkshopDetailsCache::FinishBatch(const FBatch& Batch)
+{
+	bool bAllFound = true;
+
+	TArray<FBPSteamWorkshopItemDetails> Details;
+	Details.Reserve(Batch.ItemIds.Num());
+	for (uint64 ItemId : Batch.ItemIds)
+	{
+		// Stale details beat none when a refresh failed
+		if (const FBPSteamWorkshopItemDetails* Cached = FindCached(ItemId))
+		{
+			Details.Add(*Cached);
+			continue;
+		}
+
+		bAllFound = false;
+		FBPSteamWorkshopItemDetails& Missing = Details.AddDefaulted_GetRef();
+		Missing.ResultOfRequest = Batch.Failed.Contains(ItemId) ? FBPSteamResult::k_EResultFail : FBPSteamResult::k_EResultFileNotFound;
+	}
+
+	Batch.OnReady.ExecuteIfBound(bAllFound, Details);
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Answers queries from memory, ids divisible by 7 don't exist and a query containing an id divisible by 11 fails
+class FMockWorkshopUGCProvider : public IWorkshopUGCProvider
+{
+public:
+
+	virtual int32 GetMaxItemsPerQuery() const override
+	{
+		return 4;
+	}
+
+	virtual void QueryDetails(const TArray<uint64>& ItemIds, FOnWorkshopDetailsQueried OnComplete) override
+	{
+		++NumQueries;
+
+		FWorkshopDetailsMap DetailsById;
+		for (uint64 ItemId : ItemIds)
+		{
+			if (ItemId % 11 == 0)
+			{
+				OnComplete.ExecuteIfBound(false, FWorkshopDetailsMap());
+				return;
+			}
+
+			if (ItemId % 7 != 0)
+			{
+				FBPSteamWorkshopItemDetails& Details = DetailsById.Add(ItemId);
+				Details.Title = FString::Printf(TEXT("Item %llu"), ItemId);
+			}
+		}
+
+		OnComplete.ExecuteIfBound(true, DetailsById);
+	}
+
+	int32 NumQueries = 0;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSteamWorkshopDetailsCacheTest, "AdvancedSteamSessions.WorkshopDetailsCache", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Checks the cache's paging, caching and missing items against the mock provider
+bool FSteamWorkshopDetailsCacheTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<FMockWorkshopUGCProvider, ESPMode::ThreadSafe> Provider = MakeShared<FMockWorkshopUGCProvider, ESPMode::ThreadSafe>();
+	FSteamWorkshopDetailsCache Cache(Provider);
+
+	bool bAllFound = false;
+	TArray<FBPSteamWorkshopItemDetails> Results;
+	auto Capture = FOnWorkshopDetailsReady::CreateLambda([&](bool bInAllFound, const TArray<FBPSteamWorkshopItemDetails>& Details)
+	{
+		bAllFound = bInAllFound;
+		Results = Details;
+	});
+
+	// 10 items at 4 per query
+	Cache.RequestDetails({ 1, 2, 3, 4, 5, 6, 8, 9, 10, 12 }, 60.0, Capture);
+	TestEqual(TEXT("Items are paged into queries"), Provider->NumQueries, 3);
+	TestTrue(TEXT("Every item is found"), bAllFound);
+	if (TestEqual(TEXT("Every item is returned"), Results.Num(), 10))
+	{
+		TestEqual(TEXT("Details come back in request order"), Results[9].Title, FString(TEXT("Item 12")));
+	}
+
+	Cache.RequestDetails({ 12, 1, 1 }, 60.0, Capture);
+	TestEqual(TEXT("Cached items aren't queried again"), Provider->NumQueries, 3);
+	if (TestEqual(TEXT("Duplicate ids are returned per request"), Results.Num(), 3))
+	{
+		TestEqual(TEXT("Cached details come back in request order"), Results[0].Title, FString(TEXT("Item 12")));
+	}
+
+	Cache.RequestDetails({ 1 }, 0.0, Capture);
+	Cache.RequestDetails({ 1 }, -1.0, Capture);
+	TestEqual(TEXT("Stale items are refetched"), Provider->NumQueries, 4);
+
+	Cache.RequestDetails({ 7, 13 }, 60.0, Capture);
+	TestFalse(TEXT("Missing item is reported"), bAllFound);
+	if (TestEqual(TEXT("Missing item keeps its place"), Results.Num(), 2))
+	{
+		TestTrue(TEXT("Missing item gets a placeholder"), Results[0].ResultOfRequest == FBPSteamResult::k_EResultFileNotFound);
+		TestEqual(TEXT("Found item follows the placeholder"), Results[1].Title, FString(TEXT("Item 13")));
+	}
+
+	Cache.RequestDetails({ 22 }, 60.0, Capture);
+	TestFalse(TEXT("Failed query is reported"), bAllFound);
+	if (TestEqual(TEXT("Failed item keeps its place"), Results.Num(), 1))
+	{
+		TestTrue(TEXT("Failed item is marked as failed"), Results[0].ResultOfRequest == FBPSteamResult::k_EResultFail);
+	}
+
+	TestEqual(TEXT("Failed query is counted"), Cache.GetStats().QueriesFailed, 1);
+
+	return true;
+}
+
+#endif
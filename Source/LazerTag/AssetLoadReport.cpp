@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AssetLoadReport.h"
+#include "LazerTag.h"
+#include "Engine/AssetManager.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogAssetLoadReport, Log, All);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Async Asset Loads"), STAT_AsyncAssetLoads, STATGROUP_LazerTag);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Sync Asset Loads"), STAT_SyncAssetLoads, STATGROUP_LazerTag);
+
+namespace
+{
+	struct FAssetLoadRecord
+	{
+		FString Label;
+
+		// seconds since the engine started
+		double RequestTime = 0.0;
+		double LoadedTime = 0.0;
+
+		// time the game thread spent waiting on the load
+		double BlockedSeconds = 0.0;
+
+		int NumAssets = 0;
+		bool bAsync = true;
+		bool bLoaded = false;
+	};
+
+	// every load recorded since startup, in the order they were requested
+	TArray<FAssetLoadRecord> GAssetLoadRecords;
+
+	double SecondsSinceStart()
+	{
+		return FPlatformTime::Seconds() - GStartTime;
+	}
+}
+
+TSharedPtr<FStreamableHandle> FAssetLoadReport::RequestAsyncLoad(const TArray<FSoftObjectPath>& assets, const FString& label, FStreamableDelegate onLoaded)
+{
+	check(IsInGameThread());
+
+	TArray<FSoftObjectPath> toLoad;
+
+	for (const FSoftObjectPath& asset : assets)
+	{
+		if (!asset.IsNull())
+		{
+			toLoad.AddUnique(asset);
+		}
+	}
+
+	if (toLoad.Num() == 0)
+	{
+		onLoaded.ExecuteIfBound();
+		return nullptr;
+	}
+
+	int recordIndex = GAssetLoadRecords.AddDefaulted();
+	FAssetLoadRecord& record = GAssetLoadRecords[recordIndex];
+	record.Label = label;
+	record.RequestTime = SecondsSinceStart();
+	record.NumAssets = toLoad.Num();
+
+	INC_DWORD_STAT(STAT_AsyncAssetLoads);
+
+	FStreamableDelegate onComplete = FStreamableDelegate::CreateLambda([recordIndex, onLoaded]()
+	{
+		if (GAssetLoadRecords.IsValidIndex(recordIndex))
+		{
+			GAssetLoadRecords[recordIndex].LoadedTime = SecondsSinceStart();
+			GAssetLoadRecords[recordIndex].bLoaded = true;
+		}
+
+		onLoaded.ExecuteIfBound();
+	});
+
+	return UAssetManager::GetStreamableManager().RequestAsyncLoad(toLoad, onComplete, FStreamableManager::AsyncLoadHighPriority);
+}
+
+void FAssetLoadReport::RecordSyncLoad(const FString& label, double seconds)
+{
+	check(IsInGameThread());
+
+	FAssetLoadRecord& record = GAssetLoadRecords.AddDefaulted_GetRef();
+	record.Label = label;
+	record.LoadedTime = SecondsSinceStart();
+	record.RequestTime = record.LoadedTime - seconds;
+	record.BlockedSeconds = seconds;
+	record.NumAssets = 1;
+	record.bAsync = false;
+	record.bLoaded = true;
+
+	INC_DWORD_STAT(STAT_SyncAssetLoads);
+
+	UE_LOG(LogAssetLoadReport, Warning, TEXT("%s blocked the game thread for %.2f ms"), *label, seconds * 1000.0);
+}
+
+void FAssetLoadReport::Dump()
+{
+	double totalBlocked = 0.0;
+
+	UE_LOG(LogAssetLoadReport, Log, TEXT("%-40s %-6s %6s %12s %12s %12s"), TEXT("Label"), TEXT("Mode"), TEXT("Assets"), TEXT("Request(s)"), TEXT("Load(ms)"), TEXT("Blocked(ms)"));
+
+	for (const FAssetLoadRecord& record : GAssetLoadRecords)
+	{
+		if (record.bLoaded)
+		{
+			UE_LOG(LogAssetLoadReport, Log, TEXT("%-40s %-6s %6d %12.3f %12.2f %12.2f"), *record.Label, record.bAsync ? TEXT("async") : TEXT("sync"),
+				record.NumAssets, record.RequestTime, (record.LoadedTime - record.RequestTime) * 1000.0, record.BlockedSeconds * 1000.0);
+		}
+		else
+		{
+			UE_LOG(LogAssetLoadReport, Log, TEXT("%-40s %-6s %6d %12.3f %12s %12.2f"), *record.Label, TEXT("async"), record.NumAssets, record.RequestTime, TEXT("pending"), 0.0);
+		}
+
+		totalBlocked += record.BlockedSeconds;
+	}
+
+	UE_LOG(LogAssetLoadReport, Log, TEXT("%d loads, %.2f ms spent blocking the game thread"), GAssetLoadRecords.Num(), totalBlocked * 1000.0);
+}
+
+static FAutoConsoleCommand AssetLoadReportCommand(
+	TEXT("lt.AssetLoadReport"),
+	TEXT("Lists every soft reference load since startup, how long it took and how long it blocked the game thread."),
+	FConsoleCommandDelegate::CreateStatic(&FAssetLoadReport::Dump));
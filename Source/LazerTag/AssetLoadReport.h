@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+
+/**
+ * Starts soft reference loads through the asset manager's streamable manager and keeps a record of each one,
+ * so it's easy to see what still blocks the game thread during startup and map loads.
+ * Use lt.AssetLoadReport to print the record.
+ */
+struct LAZERTAG_API FAssetLoadReport
+{
+	/*
+	* Loads a set of assets in the background. Requests for assets that are already loaded complete straight away.
+	* @param assets - assets to load, null paths are skipped
+	* @param label - name the load is listed under in the report
+	* @param onLoaded - called on the game thread once everything is loaded
+	* @returns handle that keeps the assets loaded for as long as it is held, null if there was nothing to load
+	*/
+	static TSharedPtr<FStreamableHandle> RequestAsyncLoad(const TArray<FSoftObjectPath>& assets, const FString& label, FStreamableDelegate onLoaded = FStreamableDelegate());
+
+	/*
+	* Records a load that had to block the game thread.
+	* @param label - name the load is listed under in the report
+	* @param seconds - how long the game thread was blocked
+	*/
+	static void RecordSyncLoad(const FString& label, double seconds);
+
+	/* Logs every recorded load */
+	static void Dump();
+};
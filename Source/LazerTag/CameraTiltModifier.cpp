@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CameraTiltModifier.h"
+#include "LazerTagCharacter.h"
+#include "Camera/PlayerCameraManager.h"
+
+bool UCameraTiltModifier::ModifyCamera(float DeltaTime, FMinimalViewInfo& InOutPOV)
+{
+	Super::ModifyCamera(DeltaTime, InOutPOV);
+
+	const ALazerTagCharacter* character = Cast<ALazerTagCharacter>(GetViewTarget());
+
+	if (character != nullptr)
+	{
+		InOutPOV.Rotation.Roll += character->GetCamRoll();
+	}
+
+	// let any other modifiers run as well
+	return false;
+}
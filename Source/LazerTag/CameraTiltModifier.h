@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Camera/CameraModifier.h"
+#include "CameraTiltModifier.generated.h"
+
+/**
+ * Rolls the view by the wall run / slide tilt of the character being viewed.
+ * The roll is worked out by the owning client from its own predicted movement, so nothing about it is replicated
+ * and the controller rotation is never touched.
+ */
+UCLASS()
+class LAZERTAG_API UCameraTiltModifier : public UCameraModifier
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ModifyCamera(float DeltaTime, FMinimalViewInfo& InOutPOV) override;
+};
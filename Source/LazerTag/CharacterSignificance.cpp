@@ -0,0 +1,231 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CharacterSignificance.h"
+#include "LazerTag.h"
+#include "LazerTagCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_SignificanceUpdate, STATGROUP_LazerTag);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Characters Full Rate"), STAT_SignificanceFull, STATGROUP_LazerTag);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Characters Reduced"), STAT_SignificanceReduced, STATGROUP_LazerTag);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Characters Minimal"), STAT_SignificanceMinimal, STATGROUP_LazerTag);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Characters Over Budget"), STAT_SignificanceOverBudget, STATGROUP_LazerTag);
+
+static TAutoConsoleVariable<float> CVarSignificanceFullDistance(
+	TEXT("lt.Significance.FullDistance"),
+	2500.f,
+	TEXT("Characters closer than this to a local viewer can run at full rate."));
+
+static TAutoConsoleVariable<float> CVarSignificanceReducedDistance(
+	TEXT("lt.Significance.ReducedDistance"),
+	6000.f,
+	TEXT("Characters closer than this to a local viewer run at reduced rate, anything further is minimal."));
+
+static TAutoConsoleVariable<int32> CVarSignificanceMaxAnimated(
+	TEXT("lt.Significance.MaxAnimated"),
+	12,
+	TEXT("Maximum number of characters that can be full or reduced at once. The rest are minimal."));
+
+static TAutoConsoleVariable<float> CVarSignificanceUpdateInterval(
+	TEXT("lt.Significance.UpdateInterval"),
+	0.1f,
+	TEXT("Seconds between significance updates."));
+
+bool UCharacterSignificanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// nothing is rendered on a dedicated server so there is nothing to save
+	if (IsRunningDedicatedServer())
+		return false;
+
+	UWorld* world = Cast<UWorld>(Outer);
+
+	// a PIE or single process dedicated server world runs in a process that renders
+	return world != nullptr && world->IsGameWorld() && world->GetNetMode() != NM_DedicatedServer;
+}
+
+void UCharacterSignificanceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	b_initialized = true;
+}
+
+void UCharacterSignificanceSubsystem::Deinitialize()
+{
+	b_initialized = false;
+
+	m_characters.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UCharacterSignificanceSubsystem::IsTickable() const
+{
+	// the class default object is also a tickable object so it has to be filtered out.
+	// the net mode may not be known yet when the subsystem is created so check it again here
+	if (!b_initialized || IsTemplate())
+		return false;
+
+	UWorld* world = GetWorld();
+
+	return world != nullptr && world->GetNetMode() != NM_DedicatedServer;
+}
+
+TStatId UCharacterSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCharacterSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UCharacterSignificanceSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UCharacterSignificanceSubsystem::RegisterCharacter(ALazerTagCharacter* character)
+{
+	if (character != nullptr)
+	{
+		m_characters.AddUnique(character);
+	}
+}
+
+void UCharacterSignificanceSubsystem::UnregisterCharacter(ALazerTagCharacter* character)
+{
+	m_characters.RemoveSwap(character);
+}
+
+void UCharacterSignificanceSubsystem::Tick(float DeltaTime)
+{
+	// significance does not change quickly so there is no need to rank every frame
+	f_updateTimer -= DeltaTime;
+
+	if (f_updateTimer <= 0.f)
+	{
+		f_updateTimer = CVarSignificanceUpdateInterval.GetValueOnGameThread();
+
+		UpdateSignificance();
+	}
+}
+
+float UCharacterSignificanceSubsystem::ClosestViewDistanceSq(const FVector& location, const TArray<FVector>& viewLocations) const
+{
+	float closest = MAX_flt;
+
+	for (const FVector& viewLocation : viewLocations)
+	{
+		closest = FMath::Min(closest, FVector::DistSquared(location, viewLocation));
+	}
+
+	return closest;
+}
+
+void UCharacterSignificanceSubsystem::UpdateSignificance()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SignificanceUpdate);
+
+	UWorld* world = GetWorld();
+
+	if (world == nullptr)
+		return;
+
+	// there can be more than one local player in split screen
+	TArray<FVector> viewLocations;
+
+	for (FConstPlayerControllerIterator it = world->GetPlayerControllerIterator(); it; ++it)
+	{
+		APlayerController* controller = it->Get();
+
+		if (controller != nullptr && controller->IsLocalController())
+		{
+			FVector viewLocation;
+			FRotator viewRotation;
+			controller->GetPlayerViewPoint(viewLocation, viewRotation);
+			viewLocations.Add(viewLocation);
+		}
+	}
+
+	// characters that could be animated, closest first
+	struct FRankedCharacter
+	{
+		ALazerTagCharacter* Character;
+		float DistanceSq;
+	};
+
+	TArray<FRankedCharacter, TInlineAllocator<32>> visible;
+
+	uint32 numMinimal = 0;
+
+	for (ALazerTagCharacter* character : m_characters)
+	{
+		if (character == nullptr)
+			continue;
+
+		// whoever is being played always gets everything
+		if (character->IsLocallyControlled())
+		{
+			character->SetSignificance(ECharacterSignificance::FULL);
+			continue;
+		}
+
+		float distanceSq = ClosestViewDistanceSq(character->GetActorLocation(), viewLocations);
+
+		// occluded or off screen characters only need enough to keep their state correct
+		if (viewLocations.Num() == 0 || !character->WasRecentlyRendered(0.2f))
+		{
+			character->SetSignificance(ECharacterSignificance::MINIMAL);
+			numMinimal++;
+			continue;
+		}
+
+		visible.Add({ character, distanceSq });
+	}
+
+	visible.Sort([](const FRankedCharacter& a, const FRankedCharacter& b)
+	{
+		return a.DistanceSq < b.DistanceSq;
+	});
+
+	const float fullDistanceSq = FMath::Square(CVarSignificanceFullDistance.GetValueOnGameThread());
+	const float reducedDistanceSq = FMath::Square(CVarSignificanceReducedDistance.GetValueOnGameThread());
+	const int32 maxAnimated = CVarSignificanceMaxAnimated.GetValueOnGameThread();
+
+	uint32 numFull = 0;
+	uint32 numReduced = 0;
+	uint32 numOverBudget = 0;
+
+	for (int i = 0; i < visible.Num(); i++)
+	{
+		const FRankedCharacter& ranked = visible[i];
+
+		if (ranked.DistanceSq > reducedDistanceSq)
+		{
+			ranked.Character->SetSignificance(ECharacterSignificance::MINIMAL);
+			numMinimal++;
+		}
+		else if (i >= maxAnimated)
+		{
+			// close enough to matter but the budget is already used up by closer characters
+			ranked.Character->SetSignificance(ECharacterSignificance::MINIMAL);
+			numMinimal++;
+			numOverBudget++;
+		}
+		else if (ranked.DistanceSq <= fullDistanceSq)
+		{
+			ranked.Character->SetSignificance(ECharacterSignificance::FULL);
+			numFull++;
+		}
+		else
+		{
+			ranked.Character->SetSignificance(ECharacterSignificance::REDUCED);
+			numReduced++;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SignificanceFull, numFull);
+	SET_DWORD_STAT(STAT_SignificanceReduced, numReduced);
+	SET_DWORD_STAT(STAT_SignificanceMinimal, numMinimal);
+	SET_DWORD_STAT(STAT_SignificanceOverBudget, numOverBudget);
+}
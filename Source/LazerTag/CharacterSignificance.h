@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CharacterSignificance.generated.h"
+
+class ALazerTagCharacter;
+
+// how much work a character is allowed to do based on how much the local viewer can see of it
+UENUM(blueprinttype)
+enum class ECharacterSignificance : uint8
+{
+	FULL = 0		UMETA(DisplayName = "FULL"),
+	REDUCED			UMETA(DisplayName = "REDUCED"),
+	MINIMAL			UMETA(DisplayName = "MINIMAL"),
+};
+
+/**
+ * Ranks every remote character by distance and visibility to the local players and
+ * tells each one how much ticking, animation and cosmetic timeline work it should do.
+ * Only the closest visible characters up to the animation budget run at full rate.
+ * Not created on dedicated servers since nothing is rendered there.
+ */
+UCLASS()
+class LAZERTAG_API UCharacterSignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	// End of FTickableGameObject interface
+
+	/* Adds a character to be ranked every update */
+	void RegisterCharacter(ALazerTagCharacter* character);
+
+	/* Removes a character, it will no longer be throttled */
+	void UnregisterCharacter(ALazerTagCharacter* character);
+
+private:
+
+	/* Ranks all registered characters and applies the new significance to each */
+	void UpdateSignificance();
+
+	/*
+	* Finds the closest local viewpoint to a location.
+	* @returns float - squared distance to the closest local viewer
+	*/
+	float ClosestViewDistanceSq(const FVector& location, const TArray<FVector>& viewLocations) const;
+
+	UPROPERTY()
+	TArray<ALazerTagCharacter*> m_characters;
+
+	// time until the next significance update
+	float f_updateTimer = 0.f;
+
+	bool b_initialized = false;
+};
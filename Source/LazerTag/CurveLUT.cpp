@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CurveLUT.h"
+#include "LazerTag.h"
+#include "LazerTagCharacter.h"
+#include "Curves/CurveFloat.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectGlobals.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCurveLUT, Log, All);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Baked Curve Tables"), STAT_BakedCurveTables, STATGROUP_LazerTag);
+
+// every table that has been baked, keyed by the curve it came from
+static TMap<TWeakObjectPtr<const UCurveFloat>, TSharedPtr<const FCurveLUT>> GBakedCurves;
+
+#if WITH_EDITOR
+// drops the table of a curve that is being edited or reimported so the next Get bakes it again
+static void ForgetBakedCurve(UObject* object)
+{
+	if (const UCurveFloat* curve = Cast<UCurveFloat>(object))
+	{
+		if (GBakedCurves.Remove(curve) > 0)
+		{
+			SET_DWORD_STAT(STAT_BakedCurveTables, GBakedCurves.Num());
+		}
+	}
+}
+#endif
+
+TSharedPtr<const FCurveLUT> FCurveLUT::Get(const UCurveFloat* curve)
+{
+	check(IsInGameThread());
+
+#if WITH_EDITOR
+	static bool bWatchingEdits = false;
+
+	if (!bWatchingEdits)
+	{
+		bWatchingEdits = true;
+
+		// curve editor changes go through Modify, details panel changes and reimports end in PostEditChange
+		FCoreUObjectDelegates::OnObjectModified.AddStatic(&ForgetBakedCurve);
+		FCoreUObjectDelegates::OnObjectPropertyChanged.AddLambda([](UObject* object, FPropertyChangedEvent&)
+		{
+			ForgetBakedCurve(object);
+		});
+	}
+#endif
+
+	if (curve == nullptr)
+		return nullptr;
+
+	if (const TSharedPtr<const FCurveLUT>* found = GBakedCurves.Find(curve))
+	{
+		return *found;
+	}
+
+	TSharedPtr<FCurveLUT> table = MakeShared<FCurveLUT>();
+	table->Bake(curve);
+
+	GBakedCurves.Add(curve, table);
+
+	SET_DWORD_STAT(STAT_BakedCurveTables, GBakedCurves.Num());
+
+	return table;
+}
+
+void FCurveLUT::Bake(const UCurveFloat* curve)
+{
+	curve->GetTimeRange(MinTime, MaxTime);
+
+	float step = (MaxTime - MinTime) / (NumSamples - 1);
+
+	InvStep = (step > 0.f) ? 1.f / step : 0.f;
+
+	for (int i = 0; i < NumSamples; i++)
+	{
+		Samples[i] = curve->GetFloatValue(MinTime + step * i);
+	}
+}
+
+// times evaluating a character's camera tilt curve for 64 characters both ways
+static FAutoConsoleCommandWithWorld BenchCurveLUTCommand(
+	TEXT("lt.BenchCurveLUT"),
+	TEXT("Compares evaluating the camera tilt curve directly against the baked table for 64 characters."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* world)
+	{
+		const UCurveFloat* curve = nullptr;
+
+		for (TActorIterator<ALazerTagCharacter> it(world); it && curve == nullptr; ++it)
+		{
+			curve = it->fCrouchCurve;
+		}
+
+		if (curve == nullptr)
+		{
+			UE_LOG(LogCurveLUT, Warning, TEXT("No character with a camera tilt curve found"));
+			return;
+		}
+
+		TSharedPtr<const FCurveLUT> table = FCurveLUT::Get(curve);
+
+		const int numCharacters = 64;
+		const int numFrames = 1000;
+		const float range = table->GetMaxTime() - table->GetMinTime();
+
+		// the sum is logged so the loops can't be optimized away
+		float curveSum = 0.f;
+		double curveStart = FPlatformTime::Seconds();
+
+		for (int frame = 0; frame < numFrames; frame++)
+		{
+			for (int character = 0; character < numCharacters; character++)
+			{
+				curveSum += curve->GetFloatValue(table->GetMinTime() + range * ((frame + character) % 100) / 100.f);
+			}
+		}
+
+		double curveSeconds = FPlatformTime::Seconds() - curveStart;
+
+		float tableSum = 0.f;
+		double tableStart = FPlatformTime::Seconds();
+
+		for (int frame = 0; frame < numFrames; frame++)
+		{
+			for (int character = 0; character < numCharacters; character++)
+			{
+				tableSum += table->Evaluate(table->GetMinTime() + range * ((frame + character) % 100) / 100.f);
+			}
+		}
+
+		double tableSeconds = FPlatformTime::Seconds() - tableStart;
+
+		UE_LOG(LogCurveLUT, Log, TEXT("%d characters x %d frames: curve %.3f ms (%f), table %.3f ms (%f)"),
+			numCharacters, numFrames, curveSeconds * 1000.0, curveSum, tableSeconds * 1000.0, tableSum);
+	}));
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCurveFloat;
+
+/**
+ * A float curve sampled into a small fixed size table and read back with linear interpolation.
+ * Tables are baked once per curve asset and shared by every character that uses the curve,
+ * so evaluating one is a couple of loads and a lerp instead of a key search through the rich curve.
+ */
+struct LAZERTAG_API FCurveLUT
+{
+	// samples spread evenly across the curve's time range
+	static constexpr int NumSamples = 64;
+
+	/*
+	* Gets the shared table for a curve, baking it the first time it is asked for. Game thread only.
+	* @param curve - curve asset to sample
+	* @returns the baked table, or null if there is no curve
+	*/
+	static TSharedPtr<const FCurveLUT> Get(const UCurveFloat* curve);
+
+	/* Samples a curve into this table */
+	void Bake(const UCurveFloat* curve);
+
+	/*
+	* Reads the table at a time. Times outside the curve's range are clamped.
+	* @param time - time on the curve
+	*/
+	float Evaluate(float time) const
+	{
+		float position = FMath::Clamp((time - MinTime) * InvStep, 0.f, (float)(NumSamples - 1));
+		int index = FMath::Min((int)position, NumSamples - 2);
+
+		return FMath::Lerp(Samples[index], Samples[index + 1], position - index);
+	}
+
+	float GetMinTime() const { return MinTime; }
+	float GetMaxTime() const { return MaxTime; }
+
+private:
+
+	float MinTime = 0.f;
+	float MaxTime = 0.f;
+
+	// 1 / time between samples
+	float InvStep = 0.f;
+
+	float Samples[NumSamples];
+};
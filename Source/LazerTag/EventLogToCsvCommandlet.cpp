@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EventLogToCsvCommandlet.h"
+#include "GameplayEventLog.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogEventLogToCsv, Log, All);
+
+static const TCHAR* GetEventTypeName(EGameplayEventType type)
+{
+	switch (type)
+	{
+		case EGameplayEventType::FIRE:				return TEXT("Fire");
+		case EGameplayEventType::TAG:				return TEXT("Tag");
+		case EGameplayEventType::SHIELD_HIT:		return TEXT("ShieldHit");
+		case EGameplayEventType::PROJECTILE_IMPACT:	return TEXT("ProjectileImpact");
+		case EGameplayEventType::PICKUP:			return TEXT("Pickup");
+		case EGameplayEventType::MOVE_STATE:		return TEXT("MoveState");
+		case EGameplayEventType::WALL_RUN_START:	return TEXT("WallRunStart");
+		case EGameplayEventType::WALL_RUN_END:		return TEXT("WallRunEnd");
+	}
+
+	return TEXT("Unknown");
+}
+
+UEventLogToCsvCommandlet::UEventLogToCsvCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UEventLogToCsvCommandlet::Main(const FString& Params)
+{
+	FString inPath;
+	FString outPath;
+
+	if (!FParse::Value(*Params, TEXT("In="), inPath))
+	{
+		UE_LOG(LogEventLogToCsv, Error, TEXT("Usage: -run=EventLogToCsv -In=<file.ltev> [-Out=<file.csv>]"));
+		return 1;
+	}
+
+	if (!FParse::Value(*Params, TEXT("Out="), outPath))
+	{
+		outPath = FPaths::ChangeExtension(inPath, TEXT("csv"));
+	}
+
+	TArray<uint8> data;
+
+	if (!FFileHelper::LoadFileToArray(data, *inPath))
+	{
+		UE_LOG(LogEventLogToCsv, Error, TEXT("Could not read %s"), *inPath);
+		return 1;
+	}
+
+	FGameplayEventLogHeader header;
+
+	if (data.Num() < (int32)sizeof(header))
+	{
+		UE_LOG(LogEventLogToCsv, Error, TEXT("%s is too small to be an event log"), *inPath);
+		return 1;
+	}
+
+	FMemory::Memcpy(&header, data.GetData(), sizeof(header));
+
+	if (header.Magic != GameplayEventLogMagic)
+	{
+		UE_LOG(LogEventLogToCsv, Error, TEXT("%s is not an event log"), *inPath);
+		return 1;
+	}
+
+	if (header.Version != GameplayEventLogVersion || header.EventSize != sizeof(FGameplayEvent))
+	{
+		UE_LOG(LogEventLogToCsv, Error, TEXT("%s is version %d with %d byte events, this reader only understands version %d"),
+			*inPath, header.Version, header.EventSize, GameplayEventLogVersion);
+		return 1;
+	}
+
+	const int32 numEvents = (data.Num() - sizeof(header)) / sizeof(FGameplayEvent);
+	const FGameplayEvent* events = reinterpret_cast<const FGameplayEvent*>(data.GetData() + sizeof(header));
+
+	FString csv = FString::Printf(TEXT("# started %s\nTime,Type,PlayerId,OtherPlayerId,Value,X,Y,Z\n"), *FDateTime(header.StartTicks).ToIso8601());
+	csv.Reserve(csv.Len() + numEvents * 64);
+
+	for (int32 i = 0; i < numEvents; i++)
+	{
+		// the buffer isn't guaranteed to be aligned for the struct
+		FGameplayEvent event;
+		FMemory::Memcpy(&event, &events[i], sizeof(event));
+
+		csv += FString::Printf(TEXT("%.3f,%s,%d,%d,%d,%.1f,%.1f,%.1f\n"), event.Time, GetEventTypeName(event.Type),
+			event.PlayerId, event.OtherPlayerId, event.Value, event.X, event.Y, event.Z);
+	}
+
+	if (!FFileHelper::SaveStringToFile(csv, *outPath))
+	{
+		UE_LOG(LogEventLogToCsv, Error, TEXT("Could not write %s"), *outPath);
+		return 1;
+	}
+
+	UE_LOG(LogEventLogToCsv, Display, TEXT("Wrote %d events to %s"), numEvents, *outPath);
+
+	return 0;
+}
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "EventLogToCsvCommandlet.generated.h"
+
+/**
+ * Converts a gameplay event log written by UGameplayEventLogSubsystem to CSV.
+ * Usage: UE4Editor-Cmd LazerTag -run=EventLogToCsv -In=<file.ltev> [-Out=<file.csv>]
+ */
+UCLASS()
+class UEventLogToCsvCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UEventLogToCsvCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayEventLog.h"
+#include "LazerTag.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGameplayEventLog, Log, All);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gameplay Events Recorded"), STAT_GameplayEventsRecorded, STATGROUP_LazerTag);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gameplay Events Dropped"), STAT_GameplayEventsDropped, STATGROUP_LazerTag);
+
+static TAutoConsoleVariable<int32> CVarEventLogEnable(
+	TEXT("lt.EventLog.Enable"),
+	1,
+	TEXT("Record fires, hits, pickups and movement changes to Saved/EventLogs. Takes effect on the next map."));
+
+static TAutoConsoleVariable<float> CVarEventLogFlushInterval(
+	TEXT("lt.EventLog.FlushInterval"),
+	0.25f,
+	TEXT("Seconds between the writer thread draining the event ring to disk."));
+
+bool FGameplayEventRing::Push(const FGameplayEvent& event)
+{
+	const uint32 write = i_writeIndex.load(std::memory_order_relaxed);
+	const uint32 read = i_readIndex.load(std::memory_order_acquire);
+
+	if (write - read >= Capacity)
+	{
+		i_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	m_events[write & (Capacity - 1)] = event;
+
+	// the event has to be in place before the reader can see it
+	i_writeIndex.store(write + 1, std::memory_order_release);
+
+	return true;
+}
+
+int32 FGameplayEventRing::Pop(FGameplayEvent* outEvents, int32 maxEvents)
+{
+	const uint32 read = i_readIndex.load(std::memory_order_relaxed);
+	const uint32 write = i_writeIndex.load(std::memory_order_acquire);
+
+	const int32 count = FMath::Min((int32)(write - read), maxEvents);
+
+	for (int32 i = 0; i < count; i++)
+	{
+		outEvents[i] = m_events[(read + i) & (Capacity - 1)];
+	}
+
+	// the slots can be reused once they've been copied out
+	i_readIndex.store(read + count, std::memory_order_release);
+
+	return count;
+}
+
+/**
+ * Drains the ring to disk every flush interval until told to stop, then drains whatever is left.
+ */
+class FGameplayEventWriter : public FRunnable
+{
+public:
+
+	FGameplayEventWriter(FGameplayEventRing& ring, FArchive* file)
+		: m_ring(ring)
+		, m_file(file)
+	{
+		m_wakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	}
+
+	virtual ~FGameplayEventWriter()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(m_wakeEvent);
+		delete m_file;
+	}
+
+	virtual uint32 Run() override
+	{
+		while (!b_stopping.load(std::memory_order_acquire))
+		{
+			m_wakeEvent->Wait(FTimespan::FromSeconds(CVarEventLogFlushInterval.GetValueOnAnyThread()));
+
+			Drain();
+		}
+
+		// anything recorded before the stop
+		Drain();
+
+		m_file->Close();
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		b_stopping.store(true, std::memory_order_release);
+		m_wakeEvent->Trigger();
+	}
+
+private:
+
+	void Drain()
+	{
+		int32 count;
+
+		while ((count = m_ring.Pop(m_batch, UE_ARRAY_COUNT(m_batch))) > 0)
+		{
+			m_file->Serialize(m_batch, count * sizeof(FGameplayEvent));
+		}
+
+		m_file->Flush();
+	}
+
+	FGameplayEventRing& m_ring;
+
+	FArchive* m_file;
+
+	FEvent* m_wakeEvent;
+
+	std::atomic<bool> b_stopping{ false };
+
+	// events are copied here and written in one go
+	FGameplayEvent m_batch[256];
+};
+
+// player ID of a pawn, or of whoever fired a projectile
+static int32 GetEventPlayerId(const AActor* actor)
+{
+	const APawn* pawn = Cast<APawn>(actor);
+
+	if (pawn == nullptr && actor != nullptr)
+	{
+		pawn = actor->GetInstigator();
+	}
+
+	const APlayerState* playerState = (pawn != nullptr) ? pawn->GetPlayerState() : nullptr;
+
+	return (playerState != nullptr) ? playerState->GetPlayerId() : -1;
+}
+
+bool UGameplayEventLogSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* world = Cast<UWorld>(Outer);
+
+	// a client only build never has authority over anything worth recording
+	return !IsRunningClientOnly() && world != nullptr && world->IsGameWorld() && CVarEventLogEnable.GetValueOnGameThread() != 0;
+}
+
+void UGameplayEventLogSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// the net mode isn't known yet, StartWriter is left to the first event
+}
+
+void UGameplayEventLogSubsystem::StartWriter()
+{
+	b_writerStartAttempted = true;
+
+	const FString mapName = GetWorld()->GetMapName();
+	const FDateTime now = FDateTime::UtcNow();
+	const FString path = FPaths::ProjectSavedDir() / TEXT("EventLogs") / FString::Printf(TEXT("%s_%s.ltev"), *mapName, *now.ToString());
+
+	FArchive* file = IFileManager::Get().CreateFileWriter(*path);
+
+	if (file == nullptr)
+	{
+		UE_LOG(LogGameplayEventLog, Warning, TEXT("Could not open %s, gameplay events won't be recorded"), *path);
+		return;
+	}
+
+	FGameplayEventLogHeader header;
+	header.Magic = GameplayEventLogMagic;
+	header.Version = GameplayEventLogVersion;
+	header.EventSize = sizeof(FGameplayEvent);
+	// event times are world seconds so the log starts when the world did, not when the first event came in
+	header.StartTicks = (now - FTimespan::FromSeconds(GetWorld()->GetTimeSeconds())).GetTicks();
+
+	file->Serialize(&header, sizeof(header));
+
+	m_ring = MakeUnique<FGameplayEventRing>();
+	m_writer = new FGameplayEventWriter(*m_ring, file);
+	m_writerThread = FRunnableThread::Create(m_writer, TEXT("GameplayEventWriter"), 0, TPri_BelowNormal);
+}
+
+void UGameplayEventLogSubsystem::Deinitialize()
+{
+	if (m_writerThread != nullptr)
+	{
+		m_writer->Stop();
+		m_writerThread->WaitForCompletion();
+
+		delete m_writerThread;
+		m_writerThread = nullptr;
+	}
+
+	if (m_ring.IsValid() && m_ring->GetNumDropped() > 0)
+	{
+		UE_LOG(LogGameplayEventLog, Warning, TEXT("%u gameplay events were dropped because the ring was full"), m_ring->GetNumDropped());
+	}
+
+	delete m_writer;
+	m_writer = nullptr;
+
+	m_ring.Reset();
+
+	Super::Deinitialize();
+}
+
+void UGameplayEventLogSubsystem::Record(const AActor* actor, EGameplayEventType type, const AActor* other, int32 value)
+{
+	if (actor == nullptr || !actor->HasAuthority())
+		return;
+
+	UWorld* world = actor->GetWorld();
+
+	if (UGameplayEventLogSubsystem* eventLog = (world != nullptr) ? world->GetSubsystem<UGameplayEventLogSubsystem>() : nullptr)
+	{
+		eventLog->Push(actor, type, other, value);
+	}
+}
+
+void UGameplayEventLogSubsystem::Push(const AActor* actor, EGameplayEventType type, const AActor* other, int32 value)
+{
+	if (!m_ring.IsValid())
+	{
+		// clients have authority over their own locally spawned actors but their events aren't the match's
+		if (b_writerStartAttempted || GetWorld()->GetNetMode() == NM_Client)
+			return;
+
+		StartWriter();
+
+		if (!m_ring.IsValid())
+			return;
+	}
+
+	const FVector location = actor->GetActorLocation();
+
+	FGameplayEvent event;
+	event.Time = GetWorld()->GetTimeSeconds();
+	event.Type = type;
+	event.Padding[0] = event.Padding[1] = event.Padding[2] = 0;
+	event.PlayerId = GetEventPlayerId(actor);
+	event.OtherPlayerId = GetEventPlayerId(other);
+	event.Value = value;
+	event.X = location.X;
+	event.Y = location.Y;
+	event.Z = location.Z;
+
+	if (m_ring->Push(event))
+	{
+		INC_DWORD_STAT(STAT_GameplayEventsRecorded);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_GameplayEventsDropped);
+	}
+}
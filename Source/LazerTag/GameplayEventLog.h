@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include <atomic>
+#include "GameplayEventLog.generated.h"
+
+class FRunnableThread;
+class FGameplayEventWriter;
+
+// what happened, stored as one byte in the log so only ever add to the end
+enum class EGameplayEventType : uint8
+{
+	FIRE = 0,
+	TAG,
+	SHIELD_HIT,
+	PROJECTILE_IMPACT,
+	PICKUP,
+	MOVE_STATE,
+	WALL_RUN_START,
+	WALL_RUN_END,
+};
+
+/**
+ * One entry in the gameplay event log. Plain data so it can be copied into the ring buffer and straight to disk.
+ */
+struct FGameplayEvent
+{
+	// world time in seconds
+	float Time;
+
+	EGameplayEventType Type;
+	uint8 Padding[3];
+
+	// player the event is about, for hits this is the player that was hit. -1 if there wasn't a player
+	int32 PlayerId;
+
+	// other player involved, for hits this is the shooter. -1 if nobody
+	int32 OtherPlayerId;
+
+	// meaning depends on the type: score for tags, charges left for shield hits, new state for movement changes
+	int32 Value;
+
+	float X;
+	float Y;
+	float Z;
+};
+
+static_assert(sizeof(FGameplayEvent) == 32, "FGameplayEvent is written to disk as is, bump GameplayEventLogVersion if it changes");
+
+// header at the start of every event log file
+struct FGameplayEventLogHeader
+{
+	// 'LTEV'
+	uint32 Magic;
+	uint16 Version;
+	uint16 EventSize;
+
+	// UTC ticks when the log was started
+	int64 StartTicks;
+};
+
+static constexpr uint32 GameplayEventLogMagic = 0x5645544C;
+static constexpr uint16 GameplayEventLogVersion = 1;
+
+/**
+ * Fixed size single producer, single consumer ring of events. The game thread pushes and the writer thread pops,
+ * neither ever waits on the other or allocates. Events pushed while the ring is full are dropped and counted.
+ */
+class FGameplayEventRing
+{
+public:
+
+	// must be a power of two
+	static constexpr uint32 Capacity = 8192;
+
+	/* Adds an event, game thread only. @returns false if the ring was full */
+	bool Push(const FGameplayEvent& event);
+
+	/*
+	* Takes events out in the order they were pushed, writer thread only.
+	* @param outEvents - somewhere to put up to maxEvents events
+	* @returns how many were taken
+	*/
+	int32 Pop(FGameplayEvent* outEvents, int32 maxEvents);
+
+	uint32 GetNumDropped() const { return i_dropped.load(std::memory_order_relaxed); }
+
+private:
+
+	FGameplayEvent m_events[Capacity];
+
+	// only ever increase, wrapped with the capacity mask when used
+	std::atomic<uint32> i_writeIndex{ 0 };
+	std::atomic<uint32> i_readIndex{ 0 };
+
+	std::atomic<uint32> i_dropped{ 0 };
+};
+
+/**
+ * Keeps a timeline of fires, hits, pickups and movement changes for post match analysis. Server only.
+ * Recording an event is a copy into a ring buffer, a background thread drains it to Saved/EventLogs in a versioned binary format.
+ * The file and thread are only started by the first event, so worlds that never record anything, such as menus, never make a log.
+ * Use the EventLogToCsv commandlet to read a log.
+ */
+UCLASS()
+class LAZERTAG_API UGameplayEventLogSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	/*
+	* Records an event if the actor has authority and logging is enabled.
+	* @param actor - actor the event happened to, used for the world and the player ID
+	* @param type - what happened
+	* @param other - the other actor involved, can be null
+	* @param value - extra information, see FGameplayEvent::Value
+	*/
+	static void Record(const AActor* actor, EGameplayEventType type, const AActor* other = nullptr, int32 value = 0);
+
+private:
+
+	void Push(const AActor* actor, EGameplayEventType type, const AActor* other, int32 value);
+
+	/* Opens the log file and starts the writer thread, only tried once per world */
+	void StartWriter();
+
+	bool b_writerStartAttempted = false;
+
+	TUniquePtr<FGameplayEventRing> m_ring;
+
+	// owned, deleted once the thread has finished
+	FGameplayEventWriter* m_writer = nullptr;
+
+	FRunnableThread* m_writerThread = nullptr;
+};
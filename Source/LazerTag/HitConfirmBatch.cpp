@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitConfirmBatch.h"
+
+bool FHitConfirmBatch::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	// one bit per field that is non zero
+	uint8 flags = 0;
+
+	if (Ar.IsSaving())
+	{
+		flags |= (NumTags != 0) ? 1 << 0 : 0;
+		flags |= (NumShieldHits != 0) ? 1 << 1 : 0;
+		flags |= (ScoreDelta != 0) ? 1 << 2 : 0;
+		flags |= (ShieldChargeDelta != 0) ? 1 << 3 : 0;
+	}
+
+	Ar << Sequence;
+	Ar.SerializeBits(&flags, 4);
+
+	if (Ar.IsLoading())
+	{
+		Reset();
+	}
+
+	if (flags & (1 << 0))
+		Ar << NumTags;
+
+	if (flags & (1 << 1))
+		Ar << NumShieldHits;
+
+	if (flags & (1 << 2))
+		Ar << ScoreDelta;
+
+	if (flags & (1 << 3))
+		Ar << ShieldChargeDelta;
+
+	bOutSuccess = true;
+	return true;
+}
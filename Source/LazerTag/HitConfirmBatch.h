@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HitConfirmBatch.generated.h"
+
+/**
+ * Everything the server has to tell a shooter about in one frame.
+ * Tags, shield hits, score and the owner's shield charge changes are accumulated here
+ * and sent to the owning client as a single unreliable message instead of one reliable RPC each.
+ */
+USTRUCT()
+struct FHitConfirmBatch
+{
+	GENERATED_BODY()
+
+	// increases by one every time a batch is sent so the client can drop stale or duplicate batches
+	UPROPERTY()
+	uint16 Sequence = 0;
+
+	// players tagged out this frame
+	UPROPERTY()
+	uint8 NumTags = 0;
+
+	// hits that were absorbed by the target's shield this frame
+	UPROPERTY()
+	uint8 NumShieldHits = 0;
+
+	// score gained this frame
+	UPROPERTY()
+	int16 ScoreDelta = 0;
+
+	// change to the owner's own shield charges this frame, they don't replicate to the owner
+	UPROPERTY()
+	int8 ShieldChargeDelta = 0;
+
+	bool IsEmpty() const
+	{
+		return NumTags == 0 && NumShieldHits == 0 && ScoreDelta == 0 && ShieldChargeDelta == 0;
+	}
+
+	// clears the accumulated values but keeps the sequence number
+	void Reset()
+	{
+		NumTags = 0;
+		NumShieldHits = 0;
+		ScoreDelta = 0;
+		ShieldChargeDelta = 0;
+	}
+
+	/*
+	* Checks if a received sequence number is newer than the last one that was handled. Handles wrap around.
+	* @returns bool - true: the batch has not been seen yet and should be applied
+	*				  false: the batch is a duplicate or arrived out of order
+	*/
+	static bool IsNewer(uint16 sequence, uint16 lastSequence)
+	{
+		return (int16)(sequence - lastSequence) > 0;
+	}
+
+	/* Only writes the fields that are set, most batches are a single tag so this keeps them to a few bytes */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FHitConfirmBatch> : public TStructOpsTypeTraitsBase2<FHitConfirmBatch>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
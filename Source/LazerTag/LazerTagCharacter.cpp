@@ -1,13 +1,24 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "LazerTagCharacter.h"
+#include "LazerTag.h"
 #include "LazerTagProjectile.h"
+#include "MovementSimulation.h"
+#include "WallRunSubsystem.h"
+#include "CameraTiltModifier.h"
+#include "AssetLoadReport.h"
+#include "WeaponArchetype.h"
+#include "MatchStatsSubsystem.h"
+#include "GameplayEventLog.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "Components/SphereComponent.h"
 #include "Components/InputComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
 #include "GameFramework/InputSettings.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
@@ -22,7 +33,11 @@
 
 DEFINE_LOG_CATEGORY_STATIC(LogFPChar, Warning, All);
 
-#define __VR__ 0
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ceiling Traces"), STAT_CeilingTraces, STATGROUP_LazerTag);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ceiling Traces Avoided"), STAT_CeilingTracesAvoided, STATGROUP_LazerTag);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cosmetic Components Stripped"), STAT_CosmeticComponentsStripped, STATGROUP_LazerTag);
+DECLARE_MEMORY_STAT(TEXT("Cosmetic Component Memory Stripped"), STAT_CosmeticComponentMemoryStripped, STATGROUP_LazerTag);
+
 #define __SERVER__ (ALazerTagCharacter::GetLocalRole() == ROLE_Authority)
 
 //////////////////////////////////////////////////////////////////////////
@@ -33,15 +48,7 @@ ALazerTagCharacter::ALazerTagCharacter()
 	m_characterMovement = GetCharacterMovement();
 	m_characterMovement->MaxWalkSpeed = f_walkSpeed;
 
-	// timelines are used for certain state transitions
-	m_camTiltTimeline = CreateDefaultSubobject<UTimelineComponent>(TEXT("CamTiltTimeline"));
-	m_slideTimeline = CreateDefaultSubobject<UTimelineComponent>(TEXT("SlideTimeline"));
-	m_wallRunTimeline = CreateDefaultSubobject<UTimelineComponent>(TEXT("WallRunTimeline"));
-
-	// bind delegates to the timeline update functions
-	CamInterp.BindUFunction(this, FName("CamTiltTimelineUpdate"));
-	SlideInterp.BindUFunction(this, FName("SlideTimelineUpdate"));
-	WallRunInterp.BindUFunction(this, FName("WallRunUpdate"));
+	// camera tilt, sliding and wall running are all updated in Tick
 
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(55.f, f_standingCapsuleHalfHeight);
@@ -83,6 +90,7 @@ ALazerTagCharacter::ALazerTagCharacter()
 	
 	// Mesh is the multiplayer mesh that other players can see
 	GetMesh()->SetOwnerNoSee(true);
+	GetMesh()->bEnableUpdateRateOptimizations = true;
 	_standCollisionParams.AddIgnoredComponent(GetMesh());
 
 	// Gun that can be seen in multiplayer
@@ -90,7 +98,6 @@ ALazerTagCharacter::ALazerTagCharacter()
 	MP_Gun->SetOwnerNoSee(true);
 	MP_Gun->SetupAttachment(RootComponent);
 
-#if __VR__ == 0
 	// Create a gun mesh component
 	FP_Gun = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("FP_Gun"));
 	FP_Gun->SetOnlyOwnerSee(true);			// otherwise won't be visible in the multiplayer
@@ -103,39 +110,10 @@ ALazerTagCharacter::ALazerTagCharacter()
 	FP_MuzzleLocation = CreateDefaultSubobject<USceneComponent>(TEXT("MuzzleLocation"));
 	FP_MuzzleLocation->SetupAttachment(FP_Gun);
 
-	// Default offset from the character location for projectiles to spawn
-	GunOffset = FVector(100.0f, 0.0f, 10.0f);
-
-	// Note: The ProjectileClass and the skeletal mesh/anim blueprints for Mesh1P, FP_Gun, and VR_Gun 
-	// are set in the derived blueprint asset named MyCharacter to avoid direct content references in C++.
-
-#else
-	// Create VR Controllers.
-	R_MotionController = CreateDefaultSubobject<UMotionControllerComponent>(TEXT("R_MotionController"));
-	R_MotionController->MotionSource = FXRMotionControllerBase::RightHandSourceId;
-	R_MotionController->SetupAttachment(RootComponent);
-	L_MotionController = CreateDefaultSubobject<UMotionControllerComponent>(TEXT("L_MotionController"));
-	L_MotionController->SetupAttachment(RootComponent);
-
-	// Create a gun and attach it to the right-hand VR controller.
-	// Create a gun mesh component
-	VR_Gun = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("VR_Gun"));
-	VR_Gun->SetOnlyOwnerSee(false);			// otherwise won't be visible in the multiplayer
-	VR_Gun->bCastDynamicShadow = false;
-	VR_Gun->CastShadow = false;
-	VR_Gun->SetupAttachment(R_MotionController);
-	VR_Gun->SetRelativeRotation(FRotator(0.0f, -90.0f, 0.0f));
-
-	_standCollisionParams.AddIgnoredComponent(VR_Gun);
-
-	VR_MuzzleLocation = CreateDefaultSubobject<USceneComponent>(TEXT("VR_MuzzleLocation"));
-	VR_MuzzleLocation->SetupAttachment(VR_Gun);
-	VR_MuzzleLocation->SetRelativeLocation(FVector(0.000004, 53.999992, 10.000000));
-	VR_MuzzleLocation->SetRelativeRotation(FRotator(0.0f, 90.0f, 0.0f));		// Counteract the rotation of the VR gun model.
+	// Note: The skeletal mesh/anim blueprints for Mesh1P and FP_Gun are set in the derived blueprint asset named MyCharacter
+	// to avoid direct content references in C++. Everything about the gun itself comes from the weapon archetype, see WeaponId.
 
-	// Uncomment the following line to turn motion controllers on by default:
-	bUsingMotionControllers = true;
-#endif
+	// VR controllers and the VR gun are only created once motion controllers are enabled, see CreateMotionControllerComponents
 
 }
 
@@ -145,14 +123,14 @@ void ALazerTagCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& O
 
 	// replicate variables that are marked
 	DOREPLIFETIME(ALazerTagCharacter, pickupSphere);
-	DOREPLIFETIME(ALazerTagCharacter, i_shieldCharges);
+	DOREPLIFETIME_CONDITION(ALazerTagCharacter, i_shieldCharges, COND_SkipOwner);
 	DOREPLIFETIME(ALazerTagCharacter, CurrentMoveState);
+	DOREPLIFETIME(ALazerTagCharacter, WeaponId);
 	DOREPLIFETIME(ALazerTagCharacter, i_jumpsLeft);
 	DOREPLIFETIME(ALazerTagCharacter, b_isWallRunning);
 	DOREPLIFETIME(ALazerTagCharacter, b_crouchKeyDown);
 	DOREPLIFETIME(ALazerTagCharacter, b_sprintKeyDown);
 	DOREPLIFETIME_CONDITION(ALazerTagCharacter, f_camStartZ, COND_InitialOnly);
-	DOREPLIFETIME_CONDITION(ALazerTagCharacter, f_camRollRotation, COND_OwnerOnly);
 	DOREPLIFETIME(ALazerTagCharacter, CurrentSide);
 	DOREPLIFETIME(ALazerTagCharacter, f_meshPitchRotation);
 }
@@ -167,50 +145,378 @@ void ALazerTagCharacter::BeginPlay()
 		f_camStartZ = springArm->GetRelativeLocation().Z;
 	}
 
+	// nobody will ever look through this camera or see these meshes
+	if (ShouldStripCosmeticComponents())
+	{
+		StripCosmeticComponents();
+	}
+
 	// check if curve asset is valid
 	if (fCrouchCurve)
 	{
-		/* set up crouch timeline */
+		// every character shares the same baked table
+		m_camTiltCurve = FCurveLUT::Get(fCrouchCurve);
+		f_camTiltTime = m_camTiltCurve->GetMinTime();
+	}
+
+	// most players are not in VR so these are only made when needed
+	if (bUsingMotionControllers && !ShouldStripCosmeticComponents())
+	{
+		CreateMotionControllerComponents();
+	}
+
+	if (!ShouldStripCosmeticComponents())
+	{
+		LoadCosmeticAssets();
+	}
 
-		m_camTiltTimeline->AddInterpFloat(fCrouchCurve, CamInterp, FName("TiltPro"));
+	//Attach gun mesh component to Skeleton, doing it here because the skeleton is not yet created in the constructor
+	if (FP_Gun != nullptr && Mesh1P != nullptr)
+	{
+		FP_Gun->AttachToComponent(Mesh1P, FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), TEXT("GripPoint"));
+	}
 
-		// general settings for timeline
-		m_camTiltTimeline->SetLooping(false);
-		m_camTiltTimeline->SetIgnoreTimeDilation(true);
+	if (MP_Gun != nullptr)
+	{
+		MP_Gun->AttachToComponent(GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), TEXT("gunSocket"));
 	}
 
-	if (fTickCurve)
+	// Show or hide the two versions of the gun based on whether or not we're using motion controllers.
+	UpdateGunVisibility();
+
+	// let the significance subsystem throttle us when we're far away or hidden
+	if (UCharacterSignificanceSubsystem* significance = GetWorld()->GetSubsystem<UCharacterSignificanceSubsystem>())
 	{
-		/* set up slide timeline */
-		m_slideTimeline->AddInterpFloat(fTickCurve, SlideInterp, FName("SlideTick"));
+		significance->RegisterCharacter(this);
+	}
+}
 
-		// general settings for timeline
-		m_slideTimeline->SetLooping(true);
-		m_slideTimeline->SetIgnoreTimeDilation(true);
+void ALazerTagCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (i_strippedComponentBytes > 0)
+	{
+		DEC_MEMORY_STAT_BY(STAT_CosmeticComponentMemoryStripped, i_strippedComponentBytes);
+		i_strippedComponentBytes = 0;
+	}
 
-		m_wallRunTimeline->AddInterpFloat(fTickCurve, WallRunInterp, FName("WallRunTick"));
+	if (UCharacterSignificanceSubsystem* significance = GetWorld()->GetSubsystem<UCharacterSignificanceSubsystem>())
+	{
+		significance->UnregisterCharacter(this);
+	}
 
-		m_wallRunTimeline->SetLooping(true);
-		m_wallRunTimeline->SetIgnoreTimeDilation(true);
+	if (m_cosmeticAssetsHandle.IsValid())
+	{
+		m_cosmeticAssetsHandle->ReleaseHandle();
+		m_cosmeticAssetsHandle.Reset();
 	}
 
-	//Attach gun mesh component to Skeleton, doing it here because the skeleton is not yet created in the constructor
-	FP_Gun->AttachToComponent(Mesh1P, FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), TEXT("GripPoint"));
-	MP_Gun->AttachToComponent(GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), TEXT("gunSocket"));
+	Super::EndPlay(EndPlayReason);
+}
 
-	// Show or hide the two versions of the gun based on whether or not we're using motion controllers.
-	if (bUsingMotionControllers)
+void ALazerTagCharacter::GetCosmeticAssets(TArray<FSoftObjectPath>& outAssets) const
+{
+	outAssets.Add(hitAnimation.ToSoftObjectPath());
+
+	// the class default object isn't in a world so it can't find the registry, the registry's weapons are loaded separately
+	// and only the legacy gun is added here
+	if (!IsTemplate())
 	{
-		//VR_Gun->SetHiddenInGame(false, true);
-		Mesh1P->SetHiddenInGame(true, true);
+		GetWeaponArchetype()->GetCosmeticAssets(outAssets);
 	}
 	else
 	{
-		//VR_Gun->SetHiddenInGame(true, true);
-		Mesh1P->SetHiddenInGame(false, true);
+		outAssets.Add(FireSound_DEPRECATED.ToSoftObjectPath());
+		outAssets.Add(FireAnimation_DEPRECATED.ToSoftObjectPath());
+	}
+}
+
+void ALazerTagCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// Blueprints made before weapon archetypes keep their gun until they get a registry entry
+	if (ProjectileClass_DEPRECATED != nullptr || !FireSound_DEPRECATED.IsNull() || !FireAnimation_DEPRECATED.IsNull())
+	{
+		m_legacyWeapon = NewObject<UWeaponArchetype>(this, TEXT("LegacyWeapon"), RF_Transient);
+		m_legacyWeapon->GunOffset = GunOffset_DEPRECATED;
+		m_legacyWeapon->FireSound = FireSound_DEPRECATED;
+		m_legacyWeapon->FireAnimation = FireAnimation_DEPRECATED;
+
+		// the projectile Blueprint's own movement settings are the legacy weapon's, so applying it changes nothing
+		const TSubclassOf<ALazerTagProjectile> projectileClass = (ProjectileClass_DEPRECATED != nullptr) ? ProjectileClass_DEPRECATED : m_legacyWeapon->ProjectileClass;
+		const ALazerTagProjectile* projectile = projectileClass->GetDefaultObject<ALazerTagProjectile>();
+
+		m_legacyWeapon->ProjectileClass = projectileClass;
+		m_legacyWeapon->ProjectileSpeed = projectile->GetProjectileMovement()->InitialSpeed;
+		m_legacyWeapon->ProjectileMaxSpeed = projectile->GetProjectileMovement()->MaxSpeed;
+		m_legacyWeapon->bProjectileBounces = projectile->GetProjectileMovement()->bShouldBounce;
+		m_legacyWeapon->ProjectileLifeSpan = projectile->InitialLifeSpan;
+	}
+
+	// URO creates its params on the mesh's first tick, the tier may already be set by then
+	GetMesh()->OnAnimUpdateRateParamsCreated.BindUObject(this, &ALazerTagCharacter::ApplyAnimUpdateRate);
+}
+
+void ALazerTagCharacter::SetWeaponId(uint8 weaponId)
+{
+	WeaponId = weaponId;
+
+	// the server doesn't get rep notifies
+	OnRep_WeaponId();
+}
+
+void ALazerTagCharacter::OnRep_WeaponId()
+{
+	// the new weapon's sounds and montages
+	if (m_cosmeticAssetsHandle.IsValid())
+	{
+		m_cosmeticAssetsHandle->ReleaseHandle();
+		m_cosmeticAssetsHandle.Reset();
+	}
+
+	if (HasActorBegunPlay() && !ShouldStripCosmeticComponents())
+	{
+		LoadCosmeticAssets();
+	}
+}
+
+const UWeaponArchetype* ALazerTagCharacter::GetWeaponArchetype() const
+{
+	const UWeaponArchetype* weapon = GetAssignedWeaponArchetype(WeaponId);
+
+	return (weapon != nullptr) ? weapon : GetDefault<UWeaponArchetype>();
+}
+
+const UWeaponArchetype* ALazerTagCharacter::GetAssignedWeaponArchetype(uint8 weaponId) const
+{
+	if (const UWeaponArchetype* weapon = UWeaponRegistry::FindRegistered(this, weaponId))
+	{
+		return weapon;
+	}
+
+	return m_legacyWeapon;
+}
+
+void ALazerTagCharacter::LoadCosmeticAssets()
+{
+	if (m_cosmeticAssetsHandle.IsValid())
+		return;
+
+	TArray<FSoftObjectPath> assets;
+	GetCosmeticAssets(assets);
+
+	m_cosmeticAssetsHandle = FAssetLoadReport::RequestAsyncLoad(assets, GetClass()->GetName() + TEXT(" cosmetics"));
+}
+
+void ALazerTagCharacter::SetUsingMotionControllers(bool bEnable)
+{
+	bUsingMotionControllers = bEnable;
+
+	if (bUsingMotionControllers && R_MotionController == nullptr && HasActorBegunPlay() && !ShouldStripCosmeticComponents())
+	{
+		CreateMotionControllerComponents();
+	}
+
+	UpdateGunVisibility();
+}
+
+void ALazerTagCharacter::CreateMotionControllerComponents()
+{
+	if (R_MotionController != nullptr)
+		return;
+
+	// Create VR Controllers.
+	R_MotionController = NewObject<UMotionControllerComponent>(this, TEXT("R_MotionController"));
+	R_MotionController->MotionSource = FXRMotionControllerBase::RightHandSourceId;
+	R_MotionController->SetupAttachment(RootComponent);
+	R_MotionController->RegisterComponent();
+
+	L_MotionController = NewObject<UMotionControllerComponent>(this, TEXT("L_MotionController"));
+	L_MotionController->MotionSource = FXRMotionControllerBase::LeftHandSourceId;
+	L_MotionController->SetupAttachment(RootComponent);
+	L_MotionController->RegisterComponent();
+
+	// Create a gun and attach it to the right-hand VR controller.
+	// uses the same mesh as the first person gun so there is nothing extra to set up in the blueprint
+	VR_Gun = NewObject<USkeletalMeshComponent>(this, TEXT("VR_Gun"));
+	VR_Gun->SetOnlyOwnerSee(false);			// otherwise won't be visible in the multiplayer
+	VR_Gun->bCastDynamicShadow = false;
+	VR_Gun->CastShadow = false;
+	VR_Gun->SetupAttachment(R_MotionController);
+	VR_Gun->SetRelativeRotation(FRotator(0.0f, -90.0f, 0.0f));
+
+	if (FP_Gun != nullptr)
+	{
+		VR_Gun->SetSkeletalMesh(FP_Gun->SkeletalMesh);
+	}
+
+	VR_Gun->RegisterComponent();
+
+	_standCollisionParams.AddIgnoredComponent(VR_Gun);
+
+	VR_MuzzleLocation = NewObject<USceneComponent>(this, TEXT("VR_MuzzleLocation"));
+	VR_MuzzleLocation->SetupAttachment(VR_Gun);
+	VR_MuzzleLocation->SetRelativeLocation(FVector(0.000004, 53.999992, 10.000000));
+	VR_MuzzleLocation->SetRelativeRotation(FRotator(0.0f, 90.0f, 0.0f));		// Counteract the rotation of the VR gun model.
+	VR_MuzzleLocation->RegisterComponent();
+
+	// show up in the details panel like the components made in the constructor
+	AddInstanceComponent(R_MotionController);
+	AddInstanceComponent(L_MotionController);
+	AddInstanceComponent(VR_Gun);
+	AddInstanceComponent(VR_MuzzleLocation);
+}
+
+void ALazerTagCharacter::UpdateGunVisibility()
+{
+	bool bShowVR = bUsingMotionControllers && VR_Gun != nullptr;
+
+	if (VR_Gun != nullptr)
+	{
+		VR_Gun->SetHiddenInGame(!bShowVR, true);
+	}
+
+	if (Mesh1P != nullptr)
+	{
+		Mesh1P->SetHiddenInGame(bShowVR, true);
+	}
+}
+
+bool ALazerTagCharacter::ShouldStripCosmeticComponents() const
+{
+	// a listen server still renders other players so only dedicated servers qualify
+	return b_stripCosmeticComponentsOnServer && __SERVER__ && GetNetMode() == NM_DedicatedServer;
+}
+
+void ALazerTagCharacter::StripCosmeticComponents()
+{
+	// shots are fired from the muzzle, so it stays where a listen server would have it: the gun is put in its grip
+	// first, then the muzzle hangs off the spring arm that aims it instead of the meshes below it
+	if (FP_MuzzleLocation != nullptr && springArm != nullptr)
+	{
+		if (FP_Gun != nullptr && Mesh1P != nullptr)
+		{
+			FP_Gun->AttachToComponent(Mesh1P, FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), TEXT("GripPoint"));
+		}
+
+		FP_MuzzleLocation->AttachToComponent(springArm, FAttachmentTransformRules::KeepWorldTransform);
+
+		// nothing can get between the arm and the camera in first person
+		springArm->bDoCollisionTest = false;
+	}
+
+	// children first so nothing gets reattached to a component that is about to be destroyed
+	UActorComponent* cosmetics[] =
+	{
+		FP_Gun, Mesh1P, FirstPersonCameraComponent, MP_Gun,
+		VR_MuzzleLocation, VR_Gun, R_MotionController, L_MotionController
+	};
+
+	int numStripped = 0;
+
+	for (UActorComponent* component : cosmetics)
+	{
+		if (component == nullptr)
+			continue;
+
+		i_strippedComponentBytes += component->GetClass()->GetStructureSize() + component->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+		numStripped++;
+
+		component->DestroyComponent();
+	}
+
+	FP_Gun = nullptr;
+	Mesh1P = nullptr;
+	FirstPersonCameraComponent = nullptr;
+	MP_Gun = nullptr;
+	VR_MuzzleLocation = nullptr;
+	VR_Gun = nullptr;
+	R_MotionController = nullptr;
+	L_MotionController = nullptr;
+
+	INC_DWORD_STAT_BY(STAT_CosmeticComponentsStripped, numStripped);
+	INC_MEMORY_STAT_BY(STAT_CosmeticComponentMemoryStripped, i_strippedComponentBytes);
+
+	UE_LOG(LogFPChar, Log, TEXT("%s stripped %d cosmetic components (%lld bytes)"), *GetName(), numStripped, i_strippedComponentBytes);
+}
+
+void ALazerTagCharacter::SetSignificance(ECharacterSignificance significance)
+{
+	if (significance == CurrentSignificance)
+		return;
+
+	CurrentSignificance = significance;
+
+	// seconds between updates, 0 is every frame
+	float tickInterval = 0.f;
+	float cosmeticInterval = 0.f;
+
+	switch (CurrentSignificance)
+	{
+		case ECharacterSignificance::FULL:
+			break;
+		case ECharacterSignificance::REDUCED:
+			tickInterval = 1.f / 30.f;
+			cosmeticInterval = 1.f / 15.f;
+			break;
+		case ECharacterSignificance::MINIMAL:
+			tickInterval = 1.f / 10.f;
+			cosmeticInterval = 1.f / 5.f;
+			break;
+	}
+
+	// the server runs the slide and wall run simulation in Tick so it always needs the full rate
+	SetActorTickInterval(__SERVER__ ? 0.f : tickInterval);
+
+	// third person animation is what other players see so it is where most of the savings are.
+	// URO skips evaluations and interpolates between them, a tick interval would just stutter
+	if (GetMesh()->AnimUpdateRateParams)
+	{
+		ApplyAnimUpdateRate(GetMesh()->AnimUpdateRateParams);
+	}
+	GetMesh()->VisibilityBasedAnimTickOption = (CurrentSignificance == ECharacterSignificance::MINIMAL)
+		? EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered
+		: EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+	// camera lag is only ever seen by the owner, camera tilt follows the actor tick
+	if (springArm != nullptr)
+	{
+		springArm->SetComponentTickInterval(cosmeticInterval);
 	}
 }
 
+void ALazerTagCharacter::ApplyAnimUpdateRate(FAnimUpdateRateParameters* params) const
+{
+	// frames skipped between evaluations at LOD 0, lower LODs skip one more each
+	int32 frameSkip = 0;
+	// rate while the mesh isn't rendered, in frames
+	int32 nonRenderedRate = 4;
+
+	switch (CurrentSignificance)
+	{
+		case ECharacterSignificance::FULL:
+			break;
+		case ECharacterSignificance::REDUCED:
+			frameSkip = 1;
+			nonRenderedRate = 8;
+			break;
+		case ECharacterSignificance::MINIMAL:
+			frameSkip = 3;
+			nonRenderedRate = 16;
+			break;
+	}
+
+	// at full significance URO keeps picking the rate from screen size
+	params->bShouldUseLodMap = frameSkip > 0;
+	params->LODToFrameSkipMap.Reset();
+	if (params->bShouldUseLodMap)
+	{
+		for (int32 lod = 0; lod < MAX_SKELETAL_MESH_LODS; ++lod)
+			params->LODToFrameSkipMap.Add(lod, frameSkip + lod);
+	}
+	params->BaseNonRenderedUpdateRate = nonRenderedRate;
+}
+
 void ALazerTagCharacter::CollectPickup()
 {
 	// ask server to collect pickups
@@ -246,6 +552,11 @@ void ALazerTagCharacter::Server_CollectPickup_Implementation()
 				// collect pickup and deactivate
 				obj->Server_PickedUpBy(this);
 				obj->SetActive(false);
+
+				if (UMatchStatsSubsystem* matchStats = UMatchStatsSubsystem::Get(this))
+				{
+					matchStats->RecordPickup(this);
+				}
 			}
 		}
 	}
@@ -253,61 +564,117 @@ void ALazerTagCharacter::Server_CollectPickup_Implementation()
 
 /******************************TIMELINE FUNCTIONS******************************/
 
-void ALazerTagCharacter::CamTiltTimelineUpdate(float value)
+void ALazerTagCharacter::UpdateCamTilt(float DeltaSeconds)
 {
-	AController* controller = GetController();
-
-	FRotator currentCamRot = controller->GetControlRotation();
+	// nobody else looks through this camera
+	if (!m_camTiltCurve.IsValid() || !IsLocallyControlled())
+		return;
 
-	currentCamRot = FRotator(currentCamRot.Pitch, currentCamRot.Yaw, FMath::Lerp(0.f, f_camRollRotation, value));
+	// wall running is predicted locally, sliding comes from the replicated movement state
+	bool bWantsTilt = b_wallRunSimActive || CurrentMoveState == EMovementStates::SLIDING;
 
-	if (b_isWallRunning)
+	if (b_wallRunSimActive)
+	{
+		f_camRollRotation = (CurrentSide == EWallSide::LEFT) ? f_camRollRotationOffLeft : f_camRollRotationOffRight;
+	}
+	else if (bWantsTilt)
 	{
-		FRotator currentMeshRot = GetMesh()->GetRelativeRotation();
-		currentMeshRot = FRotator(FMath::Lerp(0.f, f_meshPitchRotation, value), currentMeshRot.Yaw, currentMeshRot.Roll);
-		GetMesh()->SetRelativeRotation(currentMeshRot);
+		f_camRollRotation = f_camRollRotationOffRight;
 	}
 
-	controller->SetControlRotation(currentCamRot);
+	const float minTime = m_camTiltCurve->GetMinTime();
+	const float maxTime = m_camTiltCurve->GetMaxTime();
+
+	// already level or fully tilted, nothing changes this frame
+	if ((!bWantsTilt && f_camTiltTime <= minTime) || (bWantsTilt && f_camTiltTime >= maxTime && f_camRoll == f_camRollRotation))
+		return;
+
+	// tilt runs in real time regardless of time dilation
+	float dilation = GetActorTimeDilation();
+	float realDelta = (dilation > 0.f) ? DeltaSeconds / dilation : DeltaSeconds;
+
+	f_camTiltTime = FMath::Clamp(f_camTiltTime + (bWantsTilt ? realDelta : -realDelta), minTime, maxTime);
+
+	f_camRoll = FMath::Lerp(0.f, f_camRollRotation, m_camTiltCurve->Evaluate(f_camTiltTime));
+}
+
+void ALazerTagCharacter::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	APlayerController* playerController = Cast<APlayerController>(GetController());
+
+	if (playerController == nullptr || playerController->PlayerCameraManager == nullptr)
+		return;
+
+	// the camera manager outlives this character across respawns so only add the modifier once
+	if (playerController->PlayerCameraManager->FindCameraModifierByClass(UCameraTiltModifier::StaticClass()) == nullptr)
+	{
+		playerController->PlayerCameraManager->AddNewCameraModifier(UCameraTiltModifier::StaticClass());
+	}
 }
 
-void ALazerTagCharacter::WallRunUpdate(float value)
+/******************************TIMELINE FUNCTIONS END******************************/
+
+/******************************FIXED STEP SIMULATION******************************/
+
+void ALazerTagCharacter::Tick(float DeltaSeconds)
 {
+	Super::Tick(DeltaSeconds);
+
+	UpdateCamTilt(DeltaSeconds);
+
+	if (!b_slideSimActive && !b_wallRunSimActive)
+	{
+		f_simAccumulator = 0.f;
+		return;
+	}
 
+	int steps = FMovementSimulation::ConsumeFixedSteps(f_simAccumulator, DeltaSeconds);
+
+	for (int i = 0; i < steps; i++)
+	{
+		if (b_slideSimActive)
+		{
+			StepSlide();
+		}
+
+		if (b_wallRunSimActive)
+		{
+			StepWallRun();
+		}
+	}
+
+	// the server only needs the direction the steps ended on, not one reliable RPC per step
+	if (steps > 0 && b_wallRunSimActive)
+	{
+		Server_UpdateVelocity(m_wallRunDir);
+	}
+}
+
+void ALazerTagCharacter::StepWallRun()
+{
 	FHitResult hit;
 
 	// while the player can still wall run
-  	if (CanWallRun())
+	if (CanWallRun())
 	{
 		FVector start = GetActorLocation();
 
-		FVector intoWall;
-
-		// check what side of the player the wall is on to get a vector that goes into the wall
-		if (CurrentSide == EWallSide::LEFT)
-			intoWall = FVector::CrossProduct(m_wallRunDir, FVector::UpVector);
-		else
-			intoWall = FVector::CrossProduct(m_wallRunDir, -FVector::UpVector);
-
 		// scale vector so it is large enough to actually reach the wall
-		intoWall *= 100;
-
-		FVector end = start + intoWall;
+		FVector end = start + FMovementSimulation::IntoWall(m_wallRunDir, CurrentSide == EWallSide::LEFT, 100.f);
 
 		// if there is no hit then the player is no longer on a wall 
 		if(!GetWorld()->LineTraceSingleByChannel(hit, start, end, ECC_WorldStatic, _standCollisionParams))
- 			EndWallRun();
+			EndWallRun();
 		else
 		{
 			EWallSide prevWallSide = CurrentSide;
 
-  			m_wallRunDir = FindWallRunDir(hit.ImpactNormal);
+			m_wallRunDir = FindWallRunDir(hit.ImpactNormal);
 
-			if (prevWallSide == CurrentSide)
-			{
-				Server_UpdateVelocity(m_wallRunDir);
-			}
-			else
+			// Tick sends the new direction once the frame's steps are done
+			if (prevWallSide != CurrentSide)
 			{
 				EndWallRun();
 			}
@@ -319,31 +686,26 @@ void ALazerTagCharacter::WallRunUpdate(float value)
 	}
 }
 
-void ALazerTagCharacter::SlideTimelineUpdate(float value)
+void ALazerTagCharacter::StepSlide()
 {
-	FVector force = CalculateFloorInfluence();
+	FSlideStepParams params;
+	params.SlopeAcceleration = 150000.f / m_characterMovement->Mass;
+	params.MaxSpeed = f_sprintSpeed;
+	params.MinSpeed = f_crouchSpeed;
 
-	m_characterMovement->AddForce(force * 150000);
+	FVector vel = m_characterMovement->Velocity;
 
-	FVector vel = GetVelocity();
+	bool bStillSliding = FMovementSimulation::StepSlide(vel, m_characterMovement->CurrentFloor.HitResult.Normal, params);
 
-	float debug = vel.Size();
+	m_characterMovement->Velocity = vel;
 
-	if (vel.Size() > f_sprintSpeed)
+	if (!bStillSliding)
 	{
-		vel.Normalize();
-
-		m_characterMovement->Velocity = (vel * f_sprintSpeed);
-	}
-	else if (vel.Size() < f_crouchSpeed)
-	{
-		m_characterMovement->Velocity = FVector(0, 0, 0);
-
 		SetMovementState(EMovementStates::WALKING);
 	}
 }
 
-/******************************TIMELINE FUNCTIONS END******************************/
+/******************************FIXED STEP SIMULATION END******************************/
 
 int ALazerTagCharacter::GetRemainingCharges() const
 {
@@ -354,6 +716,7 @@ void ALazerTagCharacter::UpdateCharges(int delta)
 {
 	if (__SERVER__)
 	{
+		const int prevCharges = i_shieldCharges;
 		int res = i_shieldCharges + delta;
 
 		// increase or decrease shield charges
@@ -369,8 +732,108 @@ void ALazerTagCharacter::UpdateCharges(int delta)
 		{
 			i_shieldCharges += delta;
 		}
-		
+
+		// the owner hears about it in this frame's hit confirm batch
+		if (i_shieldCharges != prevCharges)
+		{
+			m_pendingHitConfirm.ShieldChargeDelta += i_shieldCharges - prevCharges;
+			QueueHitConfirmFlush();
+		}
+	}
+}
+
+void ALazerTagCharacter::ConfirmHit(bool bShieldHit, int scoreDelta)
+{
+	if (__SERVER__)
+	{
+		if (bShieldHit)
+		{
+			m_pendingHitConfirm.NumShieldHits++;
+		}
+		else
+		{
+			m_pendingHitConfirm.NumTags++;
+		}
+
+		m_pendingHitConfirm.ScoreDelta += scoreDelta;
+
+		QueueHitConfirmFlush();
+	}
+}
+
+void ALazerTagCharacter::QueueHitConfirmFlush()
+{
+	// only one flush per frame no matter how many hits come in, it goes out at the start of the next frame
+	if (!b_hitConfirmFlushQueued)
+	{
+		b_hitConfirmFlushQueued = true;
+		GetWorldTimerManager().SetTimerForNextTick(this, &ALazerTagCharacter::FlushHitConfirms);
+	}
+}
+
+void ALazerTagCharacter::FlushHitConfirms()
+{
+	b_hitConfirmFlushQueued = false;
+
+	if (m_pendingHitConfirm.IsEmpty())
+		return;
+
+	m_pendingHitConfirm.Sequence++;
+
+	Client_HitConfirm(m_pendingHitConfirm);
+
+	m_pendingHitConfirm.Reset();
+}
+
+void ALazerTagCharacter::Client_HitConfirm_Implementation(const FHitConfirmBatch& batch)
+{
+	// unreliable so batches can arrive late or more than once
+	if (!FHitConfirmBatch::IsNewer(batch.Sequence, i_lastHitConfirmSequence))
+		return;
+
+	const bool bBatchLost = batch.Sequence != (uint16)(i_lastHitConfirmSequence + 1);
+
+	i_lastHitConfirmSequence = batch.Sequence;
+
+	// the server already changed its own charges, a listen server host only needs the feedback
+	if (!__SERVER__)
+	{
+		if (bBatchLost)
+		{
+			// a missing batch may have carried a charge change, so the total can't be trusted any more
+			Server_ResyncShieldCharges();
+		}
+		else
+		{
+			i_shieldCharges = FMath::Clamp(i_shieldCharges + batch.ShieldChargeDelta, 0, i_maxShieldCharges);
+		}
+	}
+
+	if (batch.NumTags > 0 || batch.NumShieldHits > 0)
+	{
+		ShowHitMarker();
+
+		// try and play the sound if specified
+		if (hitMarkerSound != nullptr)
+		{
+			UGameplayStatics::PlaySoundAtLocation(this, hitMarkerSound, GetActorLocation());
+		}
 	}
+
+	if (batch.ScoreDelta != 0)
+	{
+		ShowScoreDelta(batch.ScoreDelta);
+	}
+}
+
+void ALazerTagCharacter::Server_ResyncShieldCharges_Implementation()
+{
+	Client_SetShieldCharges(i_shieldCharges);
+}
+
+void ALazerTagCharacter::Client_SetShieldCharges_Implementation(int charges)
+{
+	i_shieldCharges = charges;
 }
 
 bool ALazerTagCharacter::OnWall()
@@ -398,13 +861,18 @@ bool ALazerTagCharacter::UseJump()
 
 void ALazerTagCharacter::CapsuleHit(FVector impactNormal)
 {
-	if (!OnWall())
+	if (!OnWall() && m_characterMovement->IsFalling())
 	{
-		if (m_characterMovement->IsFalling() && WallRunnable(impactNormal))
+		// every character's hits are tested together at the end of the frame
+		if (UWallRunSubsystem* wallRun = GetWorld()->GetSubsystem<UWallRunSubsystem>())
+		{
+			wallRun->QueueWallHit(this, impactNormal);
+		}
+		else if (WallRunnable(impactNormal))
 		{
- 			m_wallRunDir = FindWallRunDir(impactNormal);
+			m_wallRunDir = FindWallRunDir(impactNormal);
 
-   			if (CanWallRun())
+			if (CanWallRun())
 			{
 				BeginWallRun();
 			}
@@ -412,6 +880,21 @@ void ALazerTagCharacter::CapsuleHit(FVector impactNormal)
 	}
 }
 
+void ALazerTagCharacter::ApplyWallHit(const FWallHitResult& result)
+{
+	// things may have changed since the hit was queued
+	if (!result.bRunnable || OnWall() || !m_characterMovement->IsFalling())
+		return;
+
+	CurrentSide = result.bWallOnLeft ? EWallSide::LEFT : EWallSide::RIGHT;
+	m_wallRunDir = result.RunDir;
+
+	if (CanWallRun())
+	{
+		BeginWallRun();
+	}
+}
+
 void ALazerTagCharacter::ResetJump()
 {
 	i_jumpsLeft = i_maxJumps;
@@ -419,53 +902,18 @@ void ALazerTagCharacter::ResetJump()
 
 bool ALazerTagCharacter::WallRunnable(FVector surfaceNormal)
 {
-
-	/*if(surfaceNormal.Z < 0)
-		return false;*/
-
-	surfaceNormal.Normalize();
-
-   	FVector newVec = FVector(surfaceNormal.X, surfaceNormal.Y, 0);
-
-	newVec.Normalize();
-
-    float res = FVector::DotProduct(surfaceNormal, newVec);
-
-	float angle = FMath::RadiansToDegrees( FMath::Acos(res) );
-
- 	if (angle < m_characterMovement->GetWalkableFloorAngle())
-	{
-		return true;
-	}
-
-	return false;
+	return FWallGeometry::IsRunnable(surfaceNormal, m_characterMovement->GetWalkableFloorZ());
 }
 
 FVector ALazerTagCharacter::FindWallRunDir(FVector wallNormal)
 {
+	bool bWallOnLeft;
 
-	wallNormal.Normalize();
-	
-	FVector2D normal = FVector2D(wallNormal);
-	FVector2D right = FVector2D(GetActorRightVector());
+	FVector runDir = FWallGeometry::RunDirection(wallNormal, GetActorRightVector(), bWallOnLeft);
 
-	FVector test = GetActorLocation() + wallNormal;
-
-	float res = FVector2D::DotProduct(normal, right);
-
-	if (res < 0)
-	{
-		CurrentSide = EWallSide::RIGHT;
-	}
-	else
-	{
-		CurrentSide = EWallSide::LEFT;
-	}
+	CurrentSide = bWallOnLeft ? EWallSide::LEFT : EWallSide::RIGHT;
 
-	if(CurrentSide == EWallSide::RIGHT)
-		return FVector::CrossProduct(FVector::UpVector, wallNormal);
-	else
-		return FVector::CrossProduct(-FVector::UpVector, wallNormal);
+	return runDir;
 }
 
 // this find the direction the player should jump off the wall depending on the slope
@@ -561,73 +1009,251 @@ void ALazerTagCharacter::SetupPlayerInputComponent(class UInputComponent* Player
 
 void ALazerTagCharacter::OnFire_Implementation()
 {
-	// try and fire a projectile
-	if (ProjectileClass != nullptr)
+	const UWeaponArchetype* weapon = GetWeaponArchetype();
+
+	FRotator SpawnRotation;
+	FVector SpawnLocation;
+
+	if (bUsingMotionControllers && VR_MuzzleLocation != nullptr)
+	{
+		SpawnRotation = VR_MuzzleLocation->GetComponentRotation();
+		SpawnLocation = VR_MuzzleLocation->GetComponentLocation();
+	}
+	else
 	{
-		UWorld* const World = GetWorld();
-		if (World != nullptr)
+		SpawnRotation = GetControlRotation();
+		// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
+		SpawnLocation = ((FP_MuzzleLocation != nullptr) ? FP_MuzzleLocation->GetComponentLocation() : GetActorLocation()) + SpawnRotation.RotateVector(weapon->GunOffset);
+	}
+
+	const float spreadRadians = FMath::DegreesToRadians(weapon->SpreadDegrees);
+
+	for (int i = 0; i < weapon->ShotsPerFire; i++)
+	{
+		FRotator shotRotation = SpawnRotation;
+
+		if (spreadRadians > 0.f)
 		{
-			if (bUsingMotionControllers)
+			shotRotation = FMath::VRandCone(SpawnRotation.Vector(), spreadRadians).Rotation();
+		}
+
+		FireShot(weapon, SpawnLocation, shotRotation);
+	}
+
+	if (UMatchStatsSubsystem* matchStats = UMatchStatsSubsystem::Get(this))
+	{
+		matchStats->RecordShots(this, weapon->ShotsPerFire);
+	}
+
+	UGameplayEventLogSubsystem::Record(this, EGameplayEventType::FIRE, nullptr, WeaponId);
+
+	Client_OnFire();
+}
+
+void ALazerTagCharacter::FireShot(const UWeaponArchetype* weapon, const FVector& muzzleLocation, const FRotator& direction)
+{
+	UWorld* const World = GetWorld();
+
+	if (World == nullptr)
+		return;
+
+	if (weapon->FireMode == EWeaponFireMode::HITSCAN)
+	{
+		FHitResult hit;
+		FCollisionQueryParams params(SCENE_QUERY_STAT(WeaponHitscan), true, this);
+
+		const FVector end = muzzleLocation + direction.Vector() * weapon->HitscanRange;
+
+		if (World->LineTraceSingleByChannel(hit, muzzleLocation, end, ECC_Visibility, params))
+		{
+			if (ALazerTagCharacter* const target = Cast<ALazerTagCharacter>(hit.GetActor()))
 			{
-				const FRotator SpawnRotation = VR_MuzzleLocation->GetComponentRotation();
-				const FVector SpawnLocation = VR_MuzzleLocation->GetComponentLocation();
-				World->SpawnActor<ALazerTagProjectile>(ProjectileClass, SpawnLocation, SpawnRotation);
+				target->ReceiveWeaponHit(this, weapon);
 			}
-			else
-			{
-				const FRotator SpawnRotation = GetControlRotation();
-				// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
-				const FVector SpawnLocation = ((FP_MuzzleLocation != nullptr) ? FP_MuzzleLocation->GetComponentLocation() : GetActorLocation()) + SpawnRotation.RotateVector(GunOffset);
+		}
 
-				//Set Spawn Collision Handling Override
-				FActorSpawnParameters ActorSpawnParams;
-				ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+		return;
+	}
 
-				// spawn the projectile at the muzzle
-				ALazerTagProjectile* newProjectile = World->SpawnActor<ALazerTagProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
+	if (weapon->ProjectileClass == nullptr)
+		return;
 
-				if (newProjectile != nullptr)
-				{
-					newProjectile->SetShooter(this);
-				}
+	const FTransform spawnTransform(direction, muzzleLocation);
 
-			}
+	// spawning is deferred because the weapon has to be known before the projectile's movement component starts
+	ALazerTagProjectile* newProjectile = World->SpawnActorDeferred<ALazerTagProjectile>(weapon->ProjectileClass, spawnTransform, this, this,
+		ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding);
+
+	if (newProjectile != nullptr)
+	{
+		newProjectile->SetWeaponId(WeaponId);
+		newProjectile->SetShooter(this);
+		newProjectile->FinishSpawning(spawnTransform);
+	}
+}
+
+void ALazerTagCharacter::ReceiveWeaponHit(ALazerTagCharacter* shooter, const UWeaponArchetype* weapon)
+{
+	OnHit();
+
+	UMatchStatsSubsystem* matchStats = UMatchStatsSubsystem::Get(this);
+
+	if (GetRemainingCharges() > 0)
+	{
+		UpdateCharges(-1);
+
+		if (shooter != nullptr)
+		{
+			shooter->ConfirmHit(true, 0);
+		}
+
+		if (matchStats != nullptr)
+		{
+			matchStats->RecordHit(shooter, this, true, GetRemainingCharges() == 0);
 		}
+
+		UGameplayEventLogSubsystem::Record(this, EGameplayEventType::SHIELD_HIT, shooter, GetRemainingCharges());
 	}
+	else if (shooter != nullptr)
+	{
+		if (matchStats != nullptr)
+		{
+			matchStats->RecordHit(shooter, this, false, false);
+		}
 
-	Client_OnFire();
+		UGameplayEventLogSubsystem::Record(this, EGameplayEventType::TAG, shooter, weapon->ScorePerHit);
+
+		shooter->ConfirmHit(false, weapon->ScorePerHit);
+
+		if (APState* const pState = Cast<APState>(shooter->GetPlayerState()))
+		{
+			pState->UpdateScore(weapon->ScorePerHit);
+		}
+	}
 }
 
 // plays the hurt animation
 void ALazerTagCharacter::OnHit()
 {
-	if (hitAnimation != nullptr)
+	// null until the background load has finished
+	UAnimMontage* montage = hitAnimation.Get();
+
+	if (montage != nullptr)
 	{
 		// Get the animation object for the arms mesh
 		UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 		if (AnimInstance != nullptr)
 		{
-			AnimInstance->Montage_Play(hitAnimation, 1.f);
+			AnimInstance->Montage_Play(montage, 1.f);
 		}
 	}
 }
 
+void ALazerTagCharacter::ResetForRespawn()
+{
+	if (!__SERVER__)
+		return;
+
+	const ALazerTagCharacter* defaults = GetClass()->GetDefaultObject<ALazerTagCharacter>();
+
+	// stop anything that is still driving movement
+	b_slideSimActive = false;
+	b_wallRunSimActive = false;
+
+
+	if (b_isWallRunning)
+	{
+		Server_DisableWallRun_Implementation();
+	}
+
+	// undo anything sliding changed
+	m_characterMovement->GroundFriction = 8.f;
+	m_characterMovement->BrakingDecelerationWalking = 2048.f;
+
+	m_characterMovement->StopMovementImmediately();
+	m_characterMovement->bWantsToCrouch = false;
+	m_characterMovement->SetMovementMode(MOVE_Walking);
+
+	b_crouchKeyDown = false;
+	b_sprintKeyDown = false;
+	f_forwardMovement = 0.f;
+	f_sideMovement = 0.f;
+
+	CurrentMoveState = EMovementStates::WALKING;
+	SetMaxWalkSpeed();
+
+	// through UpdateCharges so the owner's copy follows
+	UpdateCharges(defaults->i_shieldCharges - i_shieldCharges);
+	ResetJump();
+
+	f_meshPitchRotation = 0.f;
+	GetMesh()->SetRelativeRotation(defaults->GetMesh()->GetRelativeRotation());
+
+	// a pooled character has no owner yet so a client RPC would just run here on the server
+	if (GetController() != nullptr)
+	{
+		SendClientReset();
+	}
+	else
+	{
+		b_clientResetPending = true;
+	}
+}
+
+void ALazerTagCharacter::SendClientReset()
+{
+	b_clientResetPending = false;
+
+	EndCrouch();
+	Client_ResetForRespawn();
+}
+
+void ALazerTagCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	if (b_clientResetPending)
+	{
+		SendClientReset();
+	}
+}
+
+void ALazerTagCharacter::Client_ResetForRespawn_Implementation()
+{
+	MeshTiltReverse();
+
+	// the owner simulates its own slide and wall run, stop it so the reused pawn starts out standing
+	b_slideSimActive = false;
+	b_wallRunSimActive = false;
+	f_simAccumulator = 0.f;
+
+	// make sure the camera is level even if the tilt was halfway through
+	f_camTiltTime = m_camTiltCurve.IsValid() ? m_camTiltCurve->GetMinTime() : 0.f;
+	f_camRoll = 0.f;
+}
+
 void ALazerTagCharacter::Client_OnFire_Implementation()
 {
+	const UWeaponArchetype* weapon = GetWeaponArchetype();
+
+	// both are null until the background load has finished
+	USoundBase* sound = weapon->FireSound.Get();
+	UAnimMontage* montage = weapon->FireAnimation.Get();
+
 	// try and play the sound if specified
-	if (FireSound != nullptr)
+	if (sound != nullptr)
 	{
-		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
+		UGameplayStatics::PlaySoundAtLocation(this, sound, GetActorLocation());
 	}
 
 	// try and play a firing animation if specified
-	if (FireAnimation != nullptr)
+	if (montage != nullptr && Mesh1P != nullptr)
 	{
 		// Get the animation object for the arms mesh
 		UAnimInstance* AnimInstance = Mesh1P->GetAnimInstance();
 		if (AnimInstance != nullptr)
 		{
-			AnimInstance->Montage_Play(FireAnimation, 1.f);
+			AnimInstance->Montage_Play(montage, 1.f);
 		}
 	}
 }
@@ -793,6 +1419,8 @@ void ALazerTagCharacter::Server_SetMovementState_Implementation(EMovementStates
 {
 	if (GetLocalRole() == ROLE_Authority)
 	{
+		const EMovementStates prevState = CurrentMoveState;
+
 		switch (CurrentMoveState)
 		{
 			case EMovementStates::WALKING:
@@ -865,6 +1493,11 @@ void ALazerTagCharacter::Server_SetMovementState_Implementation(EMovementStates
 			}
 		}
 
+		if (CurrentMoveState != prevState)
+		{
+			UGameplayEventLogSubsystem::Record(this, EGameplayEventType::MOVE_STATE, nullptr, (int32)CurrentMoveState);
+		}
+
 		SetMaxWalkSpeed();
 	}
 }
@@ -885,13 +1518,9 @@ void ALazerTagCharacter::BeginSlide()
 
 	m_characterMovement->BrakingDecelerationWalking = 1000.f;
 
-	f_camRollRotation = f_camRollRotationOffRight;
-
 	m_slideDir = GetActorForwardVector();
 
-	OnCamTilt();
-
-	m_slideTimeline->Play();
+	b_slideSimActive = true;
 }
 
 void ALazerTagCharacter::EndSlide()
@@ -900,42 +1529,17 @@ void ALazerTagCharacter::EndSlide()
 
 	m_characterMovement->BrakingDecelerationWalking = 2048.f;
 
-	OnCamUnTilt();
-
-	m_slideTimeline->Stop();
-}
-
-void ALazerTagCharacter::OnCamTilt_Implementation()
-{
-	CamTiltStart();
-}
-
-void ALazerTagCharacter::OnCamUnTilt_Implementation()
-{
-	CamTiltReverse();
-}
-
-void ALazerTagCharacter::HitPlayer_Implementation()
-{
-	ShowHitMarker();
-
-	// try and play the sound if specified
-	if (hitMarkerSound != nullptr)
-	{
-		UGameplayStatics::PlaySoundAtLocation(this, hitMarkerSound, GetActorLocation());
-	}
+	b_slideSimActive = false;
 }
 
 void ALazerTagCharacter::BeginWallRun()
 {
 	if (CurrentSide == EWallSide::LEFT)
 	{
-		f_camRollRotation = f_camRollRotationOffLeft;
 		f_meshPitchRotation = f_meshPitchRotationOffLeft;
 	}
 	else
 	{
-		f_camRollRotation = f_camRollRotationOffRight;
 		f_meshPitchRotation = f_meshPitchRotationOffRight;
 	}
 
@@ -943,13 +1547,11 @@ void ALazerTagCharacter::BeginWallRun()
 
 	SetMovementState(EMovementStates::SPRINTING);
 
-	CamTiltStart();
-
 	MeshTilt();
 
 	ResetJump();
 
-	m_wallRunTimeline->Play();
+	b_wallRunSimActive = true;
 }
 
 void ALazerTagCharacter::Server_EnableWallRun_Implementation()
@@ -960,28 +1562,33 @@ void ALazerTagCharacter::Server_EnableWallRun_Implementation()
 
 	m_characterMovement->SetPlaneConstraintNormal(FVector(0, 0, 1.f));
 
+	if (!b_isWallRunning)
+	{
+		f_wallRunStartTime = GetWorld()->GetTimeSeconds();
+
+		UGameplayEventLogSubsystem::Record(this, EGameplayEventType::WALL_RUN_START);
+	}
+
 	b_isWallRunning = true;
 }
 
 void ALazerTagCharacter::Server_UpdateVelocity_Implementation(FVector dir)
 {
-	m_characterMovement->Velocity = FVector(dir.X, dir.Y, 0) * m_characterMovement->GetModifiedMaxSpeed();
+	m_characterMovement->Velocity = FMovementSimulation::WallRunVelocity(dir, m_characterMovement->GetModifiedMaxSpeed());
 }
 
 void ALazerTagCharacter::EndWallRun()
 {
 	Server_DisableWallRun();
 
-	CamTiltReverse();
-
 	MeshTiltReverse();
 
 	if(!b_sprintKeyDown)
 	{
 		SetMovementState(EMovementStates::WALKING);
 	}
-	
-	m_wallRunTimeline->Stop();
+
+	b_wallRunSimActive = false;
 }
 
 void ALazerTagCharacter::Server_DisableWallRun_Implementation()
@@ -992,6 +1599,16 @@ void ALazerTagCharacter::Server_DisableWallRun_Implementation()
 
 	m_characterMovement->SetPlaneConstraintNormal(FVector(0, 0, 0));
 
+	if (b_isWallRunning)
+	{
+		if (UMatchStatsSubsystem* matchStats = UMatchStatsSubsystem::Get(this))
+		{
+			matchStats->RecordWallRun(this, GetWorld()->GetTimeSeconds() - f_wallRunStartTime);
+		}
+
+		UGameplayEventLogSubsystem::Record(this, EGameplayEventType::WALL_RUN_END);
+	}
+
 	b_isWallRunning = false;
 
 }
@@ -999,6 +1616,9 @@ void ALazerTagCharacter::Server_DisableWallRun_Implementation()
 // test to see if another player is in line of sight
 void ALazerTagCharacter::PlayerNameVisible_Implementation()
 {
+	if (FP_MuzzleLocation == nullptr)
+		return;
+
 	FHitResult hit;
 
 	FRotator rot = GetControlRotation();
@@ -1066,25 +1686,7 @@ void ALazerTagCharacter::SetMaxWalkSpeed()
 
 FVector ALazerTagCharacter::CalculateFloorInfluence()
 {
-
-	FVector normal = m_characterMovement->CurrentFloor.HitResult.Normal;
-
-	if (normal.Z == FVector::UpVector.Z)
-	{
-		return FVector(0, 0, 0);
-	}
-
-	FVector rightInfluence = FVector::CrossProduct(normal, FVector::UpVector);
-
-	FVector slopeInfluence = FVector::CrossProduct(normal, rightInfluence);
-
-	slopeInfluence.Normalize();
-
-	float slidyness = FVector::DotProduct(normal, FVector::UpVector);
-
-	slopeInfluence *= slidyness;
-
-	return slopeInfluence;
+	return FMovementSimulation::FloorInfluence(m_characterMovement->CurrentFloor.HitResult.Normal);
 }
 
 bool ALazerTagCharacter::CanSprint()
@@ -1101,14 +1703,45 @@ bool ALazerTagCharacter::CanStand()
 	if (b_crouchKeyDown)
 		return false;
 
-	FVector start = GetActorLocation();
+	return HasCeilingClearance();
+}
+
+bool ALazerTagCharacter::HasCeilingClearance()
+{
+	FVector location = GetActorLocation();
 	float halfHeight = GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	float time = GetWorld()->GetTimeSeconds();
+
+	// CanStand gets asked a lot from input and movement state changes so only trace when something could have changed
+	if (i_clearanceFrame != 0 && halfHeight == f_clearanceHalfHeight)
+	{
+		bool bSameFrame = i_clearanceFrame == GFrameCounter;
+		bool bBarelyMoved = FVector::DistSquared(location, m_clearanceLocation) < FMath::Square(f_clearanceMoveThreshold)
+			&& time - f_clearanceTime < f_clearanceMaxAge;
+
+		if (bSameFrame || bBarelyMoved)
+		{
+			INC_DWORD_STAT(STAT_CeilingTracesAvoided);
+			return b_cachedCeilingClearance;
+		}
+	}
+
+	INC_DWORD_STAT(STAT_CeilingTraces);
+
+	FVector start = location;
 	start.Z -= halfHeight;
 	FVector end = start;
 	end.Z += f_standingCapsuleHalfHeight * 2;
 	FHitResult hit;
 
-	return !GetWorld()->LineTraceSingleByChannel(hit, start, end, ECC_WorldStatic, _standCollisionParams);
+	b_cachedCeilingClearance = !GetWorld()->LineTraceSingleByChannel(hit, start, end, ECC_WorldStatic, _standCollisionParams);
+
+	i_clearanceFrame = GFrameCounter;
+	f_clearanceTime = time;
+	m_clearanceLocation = location;
+	f_clearanceHalfHeight = halfHeight;
+
+	return b_cachedCeilingClearance;
 }
 
 /******************************INPUT END******************************/
\ No newline at end of file
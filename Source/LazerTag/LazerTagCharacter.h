@@ -4,8 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
-#include "Runtime/Engine/Classes/Components/TimelineComponent.h"
 #include "UObject/WeakObjectPtr.h"
+#include "HitConfirmBatch.h"
+#include "CharacterSignificance.h"
+#include "WallGeometry.h"
+#include "CurveLUT.h"
+#include "Engine/StreamableManager.h"
 #include "LazerTagCharacter.generated.h"
 
 class UInputComponent;
@@ -15,10 +19,11 @@ class UCameraComponent;
 class UMotionControllerComponent;
 class UAnimMontage;
 class USoundBase;
-class UTimelineComponent;
 class UCurveFloat;
 class USphereComponent;
 class USpringArmComponent;
+struct FAnimUpdateRateParameters;
+class UWeaponArchetype;
 
 UENUM(blueprinttype)
 enum class EMovementStates : uint8
@@ -58,12 +63,12 @@ class ALazerTagCharacter : public ACharacter
 	UPROPERTY(VisibleDefaultsOnly, Category = Mesh)
 	USceneComponent* FP_MuzzleLocation;
 
-	/** Gun mesh: VR view (attached to the VR controller directly, no arm, just the actual gun) */
-	UPROPERTY(VisibleDefaultsOnly, Category = Mesh)
+	/** Gun mesh: VR view (attached to the VR controller directly, no arm, just the actual gun). Only exists once motion controllers are enabled. */
+	UPROPERTY(Transient, VisibleInstanceOnly, Category = Mesh)
 	USkeletalMeshComponent* VR_Gun;
 
-	/** Location on VR gun mesh where projectiles should spawn. */
-	UPROPERTY(VisibleDefaultsOnly, Category = Mesh)
+	/** Location on VR gun mesh where projectiles should spawn. Only exists once motion controllers are enabled. */
+	UPROPERTY(Transient, VisibleInstanceOnly, Category = Mesh)
 	USceneComponent* VR_MuzzleLocation;
 
 	/** First person camera */
@@ -77,12 +82,12 @@ class ALazerTagCharacter : public ACharacter
 	UPROPERTY(visibleAnywhere, blueprintReadWrite, category = Camera, meta = (allowPrivateAccess = "true"))
 	USpringArmComponent* springArm;
 
-	/** Motion controller (right hand) */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	/** Motion controller (right hand). Only exists once motion controllers are enabled. */
+	UPROPERTY(Transient, VisibleInstanceOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	UMotionControllerComponent* R_MotionController;
 
-	/** Motion controller (left hand) */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	/** Motion controller (left hand). Only exists once motion controllers are enabled. */
+	UPROPERTY(Transient, VisibleInstanceOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	UMotionControllerComponent* L_MotionController;
 
 public:
@@ -91,9 +96,55 @@ public:
 	// required network setup
 	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	/*
+	* Scales down ticking, animation and cosmetic updates for characters the local player can't see well.
+	* Called by UCharacterSignificanceSubsystem.
+	* @param significance - how much work this character should be doing
+	*/
+	void SetSignificance(ECharacterSignificance significance);
+
+	FORCEINLINE ECharacterSignificance GetSignificance() const { return CurrentSignificance; }
+
+	/* Camera roll to add to the view, zero unless this is the owning client */
+	FORCEINLINE float GetCamRoll() const { return f_camRoll; }
+
 protected:
 	virtual void BeginPlay();
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/*
+	* Builds the legacy weapon from the deprecated gun properties if the Blueprint still sets them
+	* and hooks the third person mesh's update rate to the significance tier.
+	*/
+	virtual void PostInitializeComponents() override;
+
+	/*
+	* Starts loading the fire and hit sounds and montages. Until they arrive firing and getting hit just play nothing.
+	* Every character of a class shares the same loaded assets so this only really loads anything once.
+	*/
+	void LoadCosmeticAssets();
+
+	/*
+	* Checks if this character is on a server that will never render it, in which case anything cosmetic can be removed.
+	* @returns bool - true: running on a dedicated server with stripping enabled
+	*				  false: something on this machine may view the character
+	*/
+	bool ShouldStripCosmeticComponents() const;
+
+	/* Creates the motion controllers, VR gun and VR muzzle. Does nothing if they already exist. */
+	void CreateMotionControllerComponents();
+
+	/* Shows either the first person arms or the VR gun depending on bUsingMotionControllers */
+	void UpdateGunVisibility();
+
+	/* Destroys the cameras, first person meshes and guns, keeping the muzzle and the spring arm that aims it. Only called on dedicated servers. */
+	void StripCosmeticComponents();
+
+	// remove purely cosmetic components when running on a dedicated server
+	UPROPERTY(config, editAnywhere, category = "Server")
+	bool b_stripCosmeticComponentsOnServer = true;
+
 	// entry to pickup logic
 	UFUNCTION(blueprintcallable, category = "Pickup")
 	void CollectPickup();
@@ -113,33 +164,64 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
 	float BaseLookUpRate;
 
-	/** Gun muzzle's offset from the characters location */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
-	FVector GunOffset;
+	/*
+	* Switches to another weapon from the weapon registry.
+	* @param weaponId - index of the weapon in the registry
+	*/
+	UFUNCTION(blueprintCallable, blueprintAuthorityOnly, category = Gameplay)
+	void SetWeaponId(uint8 weaponId);
+
+	/* Gets the archetype of the weapon this character is holding, the legacy weapon is used when the registry doesn't have it */
+	const UWeaponArchetype* GetWeaponArchetype() const;
+
+	/*
+	* Gets the archetype actually assigned for a weapon of this character, from the registry or the legacy weapon.
+	* @param weaponId - index of the weapon in the registry
+	* @return null when neither has one, so callers can keep their own defaults
+	*/
+	const UWeaponArchetype* GetAssignedWeaponArchetype(uint8 weaponId) const;
+
+	/** Deprecated, set in a weapon archetype instead. Still used when WeaponId isn't in the weapon registry. */
+	UPROPERTY()
+	FVector GunOffset_DEPRECATED = FVector(100.0f, 0.0f, 10.0f);
+
+	/** Deprecated, set in a weapon archetype instead. Still used when WeaponId isn't in the weapon registry. */
+	UPROPERTY()
+	TSubclassOf<class ALazerTagProjectile> ProjectileClass_DEPRECATED;
 
-	/** Projectile class to spawn */
-	UPROPERTY(EditDefaultsOnly, Category=Projectile)
-	TSubclassOf<class ALazerTagProjectile> ProjectileClass;
+	/** Deprecated, set in a weapon archetype instead. Still used when WeaponId isn't in the weapon registry. */
+	UPROPERTY()
+	TSoftObjectPtr<USoundBase> FireSound_DEPRECATED;
 
-	/** Sound to play each time we fire */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
-	USoundBase* FireSound;
+	/** Deprecated, set in a weapon archetype instead. Still used when WeaponId isn't in the weapon registry. */
+	UPROPERTY()
+	TSoftObjectPtr<UAnimMontage> FireAnimation_DEPRECATED;
 
 	/* sound to play when hit marker appears */
 	UPROPERTY(editAnywhere, blueprintReadWrite, category = Gameplay)
 	USoundBase* hitMarkerSound;
 
-	/** AnimMontage to play each time we fire */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
-	UAnimMontage* FireAnimation;
-	
+	/** AnimMontage to play when hit. Loaded in the background, see LoadCosmeticAssets */
 	UPROPERTY(editAnywhere, blueprintReadWrite, category = Gameplay)
-	UAnimMontage* hitAnimation;
+	TSoftObjectPtr<UAnimMontage> hitAnimation;
+
+	/*
+	* Gets the sounds and montages this character plays, so they can be loaded before any character is spawned.
+	* @param outAssets - the soft references are added to this
+	*/
+	void GetCosmeticAssets(TArray<FSoftObjectPath>& outAssets) const;
 
 	/** Whether to use motion controller location for aiming. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	uint8 bUsingMotionControllers : 1;
 
+	/*
+	* Turns motion controller aiming on or off. The VR components are created the first time this is enabled.
+	* @param bEnable - true to aim with the right hand motion controller
+	*/
+	UFUNCTION(blueprintCallable, category = Gameplay)
+	void SetUsingMotionControllers(bool bEnable);
+
 	UPROPERTY(replicated, editAnywhere, blueprintReadonly, category = Gameplay)
 	EMovementStates CurrentMoveState = EMovementStates::WALKING;
 
@@ -157,27 +239,28 @@ public:
 
 	void EndSlide();
 
-	UFUNCTION(reliable, client)
-	void OnCamTilt();
-	void OnCamTilt_Implementation();
-
+	/* no longer called, the camera roll is applied by UCameraTiltModifier. Kept so existing blueprints still compile. */
 	UFUNCTION(blueprintImplementableEvent)
 	void CamTiltStart();
 
-	UFUNCTION(reliable, client)
-	void OnCamUnTilt();
-	void OnCamUnTilt_Implementation();
-
+	/* no longer called, the camera roll is applied by UCameraTiltModifier. Kept so existing blueprints still compile. */
 	UFUNCTION(blueprintImplementableEvent)
 	void CamTiltReverse();
 
-	UFUNCTION(reliable, client)
-	void HitPlayer();
-	void HitPlayer_Implementation();
+	/*
+	* Records a successful hit by this player. Everything recorded in the same server frame is sent to the owning client together.
+	* @param bShieldHit - true if the hit was absorbed by the target's shield rather than tagging them out
+	* @param scoreDelta - score awarded for the hit
+	*/
+	void ConfirmHit(bool bShieldHit, int scoreDelta);
 
 	UFUNCTION(blueprintImplementableEvent)
 	void ShowHitMarker();
 
+	/* called on the owning client when a hit confirm arrives that awarded score */
+	UFUNCTION(blueprintImplementableEvent)
+	void ShowScoreDelta(int delta);
+
 	UFUNCTION()
 	void BeginWallRun();
 
@@ -202,37 +285,37 @@ public:
 	void Server_DisableWallRun();
 	void Server_DisableWallRun_Implementation();
 
-	// delegate that is used to tilt the camera
-	FOnTimelineFloat CamInterp;
-
-	// delegate that is binded with SlideTimelineUpdate
-	FOnTimelineFloat SlideInterp;
-
-	// delegate that is binded with WallRunUpdate
-	FOnTimelineFloat WallRunInterp;
-	
-	/* event triggers everytime player comes into contact with a surface*/
+	/* event triggers everytime player comes into contact with a surface. The hit is tested for wall running at the end of the frame. */
 	UFUNCTION(blueprintCallable, category = "Capsule")
 	void CapsuleHit(FVector impactNormal);
 
-	/* event that gradually tilts camera while wall running or sliding */
-	UFUNCTION()
-	void CamTiltTimelineUpdate(float value);
+	/*
+	* Starts a wall run if a queued surface hit turned out to be runnable. Called by UWallRunSubsystem.
+	* @param result - what the batch worked out about the surface
+	*/
+	void ApplyWallHit(const FWallHitResult& result);
 
-	/* slide events */
-	UFUNCTION()
-	void SlideTimelineUpdate(float value);
+	/*
+	* Moves the camera tilt playhead towards tilted while the locally predicted state is wall running or sliding, and back to level otherwise.
+	* Only does anything on the owning client and stops as soon as the camera is level.
+	*/
+	void UpdateCamTilt(float DeltaSeconds);
 
-	/* wall running events */
-	UFUNCTION()
-	void WallRunUpdate(float value);
+	/* Adds the camera tilt modifier to the controlling player's camera manager */
+	virtual void PawnClientRestart() override;
 
-	// curves used for the timelines
-	UPROPERTY(editAnywhere, category = "Timeline")
-	UCurveFloat* fCrouchCurve;
+	/* Runs the slide and wall run simulation at a fixed rate */
+	virtual void Tick(float DeltaSeconds) override;
 
+	/* Advances the slide by one fixed step */
+	void StepSlide();
+
+	/* Checks the player is still on the wall and follows it for one fixed step, Tick sends the direction to the server */
+	void StepWallRun();
+
+	// curve used for the camera tilt, baked into a table shared by every character at BeginPlay
 	UPROPERTY(editAnywhere, category = "Timeline")
-	UCurveFloat* fTickCurve;
+	UCurveFloat* fCrouchCurve;
 
 	UFUNCTION(blueprintPure, category = "Shield")
 	int GetRemainingCharges() const;
@@ -248,6 +331,28 @@ public:
 	/* Plays hit animation when player is hit with projectile*/
 	void OnHit();
 
+	/*
+	* Handles being hit by a weapon. The shield takes the hit if there are charges left, otherwise the shooter scores.
+	* @param shooter - player who fired the shot, can be null
+	* @param weapon - archetype of the weapon the shot came from
+	*/
+	void ReceiveWeaponHit(ALazerTagCharacter* shooter, const UWeaponArchetype* weapon);
+
+	/*
+	* Puts the character back to how it was when it first spawned so it can be reused instead of spawning a new one.
+	* Clears movement state, shield charges, jumps, slide/wall run simulation and camera tilt. Server only.
+	*/
+	UFUNCTION(blueprintCallable, blueprintAuthorityOnly, category = "Respawn")
+	void ResetForRespawn();
+
+	/* Clears the camera and mesh tilt on the owning client after a respawn */
+	UFUNCTION(reliable, client)
+	void Client_ResetForRespawn();
+	void Client_ResetForRespawn_Implementation();
+
+	/* Sends the owning client's half of a respawn reset once there is an owning client */
+	virtual void PossessedBy(AController* NewController) override;
+
 	UFUNCTION(blueprintNativeEvent, blueprintCallable)
 	void PlayerNameVisible();
 	virtual void PlayerNameVisible_Implementation();
@@ -263,7 +368,7 @@ public:
 	
 protected:
 
-	// initial shield charges
+	// initial shield charges. the owner is kept up to date by hit confirm batches instead of replication
 	UPROPERTY(replicated, editAnywhere, blueprintReadWrite, category = "Shield")
 	int i_shieldCharges = 0;
 
@@ -305,8 +410,13 @@ protected:
 	float f_camRollRotationOffLeft = 10.f;
 	float f_camRollRotationOffRight = -10.f;
 
-	UPROPERTY(replicated, visibleAnywhere, blueprintReadOnly, category = Camera, meta = (allowPrivateAccess = "true"))
-	float f_camRollRotation;
+	// roll the camera is tilting towards, only set on the owning client
+	UPROPERTY(visibleAnywhere, blueprintReadOnly, category = Camera, meta = (allowPrivateAccess = "true"))
+	float f_camRollRotation = 0.f;
+
+	// roll currently applied to the view by UCameraTiltModifier
+	UPROPERTY(visibleAnywhere, blueprintReadOnly, category = Camera, meta = (allowPrivateAccess = "true"))
+	float f_camRoll = 0.f;
 
 	float f_meshPitchRotationOffLeft = 35.f;
 	float f_meshPitchRotationOffRight = -35.f;
@@ -320,6 +430,9 @@ protected:
 	UPROPERTY(replicated, visibleAnywhere, blueprintReadOnly)
 	bool b_isWallRunning = false;
 
+	// server time the current wall run started, for the match stats
+	float f_wallRunStartTime = 0.f;
+
 	const int i_maxJumps = 2;
 
 	UPROPERTY(replicated)
@@ -340,23 +453,118 @@ protected:
 	UPROPERTY(editAnywhere, category = "Mesh")
 	float f_meshCrouchZOff = 50.f;
 
-	/* Timelines */
-	UTimelineComponent* m_slideTimeline;
-	UTimelineComponent* m_camTiltTimeline;
-	UTimelineComponent* m_wallRunTimeline;
+	// reset on the server while nobody controlled this character, the owner's half is sent on possession
+	bool b_clientResetPending = false;
+
+	/* Tells the owning client to stop crouching and level its camera and mesh */
+	void SendClientReset();
+
+	// index of the held weapon in the weapon registry
+	UPROPERTY(replicatedUsing = OnRep_WeaponId, editAnywhere, blueprintReadOnly, category = Gameplay, meta = (allowPrivateAccess = "true"))
+	uint8 WeaponId = 0;
+
+	// swaps the loaded sounds and montages for the new weapon's
+	UFUNCTION()
+	void OnRep_WeaponId();
+
+	// archetype made from the deprecated gun properties, null if the Blueprint doesn't set any
+	UPROPERTY(transient)
+	UWeaponArchetype* m_legacyWeapon;
+
+	// keeps the sounds and montages loaded while this character is alive
+	TSharedPtr<FStreamableHandle> m_cosmeticAssetsHandle;
+
+	/* Camera Tilt */
+
+	// baked fCrouchCurve
+	TSharedPtr<const FCurveLUT> m_camTiltCurve;
+
+	// current time on the tilt curve
+	float f_camTiltTime = 0.f;
+
+	/* Fixed Step Simulation */
+
+	// true while this machine is simulating a slide
+	bool b_slideSimActive = false;
+
+	// true while this machine is simulating a wall run
+	bool b_wallRunSimActive = false;
+
+	// frame time that has not been used up by a fixed step yet
+	float f_simAccumulator = 0.f;
 
 	UCharacterMovementComponent* m_characterMovement;
 
 	FCollisionQueryParams _standCollisionParams;
 
+	/* Ceiling Clearance Cache */
+
+	// result of the last ceiling trace
+	bool b_cachedCeilingClearance = false;
+
+	// frame the last ceiling trace was done on, 0 means there is no cached result
+	uint64 i_clearanceFrame = 0;
+
+	// world time of the last ceiling trace
+	float f_clearanceTime = 0.f;
+
+	// capsule location and half height of the last ceiling trace
+	FVector m_clearanceLocation;
+	float f_clearanceHalfHeight = 0.f;
+
+	// the cached trace is reused as long as the capsule has moved less than this
+	const float f_clearanceMoveThreshold = 5.f;
+
+	// the cached trace is never reused for longer than this in case something moved overhead
+	const float f_clearanceMaxAge = 0.25f;
+
 	UPROPERTY(replicated, visibleAnywhere, blueprintReadonly, category = "Pickup", meta = ( allowPrivateAccess = "true" ) )
 	float f_pickupSphereRadius;
+
+	/* Hit Confirms */
+
+	// confirms gathered this server frame that have not been sent yet
+	FHitConfirmBatch m_pendingHitConfirm;
+
+	// true once a flush has been scheduled for the next frame
+	bool b_hitConfirmFlushQueued = false;
+
+	// last sequence number handled on the owning client, used to drop duplicates
+	uint16 i_lastHitConfirmSequence = 0;
+
+	/* Queues the pending batch to be sent next frame, so everything confirmed this frame goes together */
+	void QueueHitConfirmFlush();
+
+	/* Sends the pending batch to the owning client */
+	void FlushHitConfirms();
+
+	/* Applies a batch of hit confirms on the owning client */
+	UFUNCTION(unreliable, client)
+	void Client_HitConfirm(const FHitConfirmBatch& batch);
+	void Client_HitConfirm_Implementation(const FHitConfirmBatch& batch);
+
+	/* Asks for the shield charges again after a hit confirm batch was lost, its charge delta went with it */
+	UFUNCTION(reliable, server)
+	void Server_ResyncShieldCharges();
+	void Server_ResyncShieldCharges_Implementation();
+
+	UFUNCTION(reliable, client)
+	void Client_SetShieldCharges(int charges);
+	void Client_SetShieldCharges_Implementation(int charges);
 	
-	/** Fires a projectile. */
+	/** Fires the current weapon. */
 	UFUNCTION(reliable, server)
 	void OnFire();
 	void OnFire_Implementation();
 
+	/*
+	* Fires a single shot of the current weapon.
+	* @param weapon - the current weapon
+	* @param muzzleLocation - where the shot starts
+	* @param direction - which way the shot travels, spread already applied
+	*/
+	void FireShot(const UWeaponArchetype* weapon, const FVector& muzzleLocation, const FRotator& direction);
+
 	/* handles client side event such as  first person shooting animation */
 	UFUNCTION(reliable, client)
 	void Client_OnFire();
@@ -454,6 +662,14 @@ protected:
 	*/
 	bool CanStand();
 
+	/*
+	* Checks if there is room above the player to stand up. The trace result is reused until the next frame,
+	* or longer if the capsule hasn't moved or changed height.
+	* @returns bool	- true: nothing is above the player
+	*				  false: something is blocking the player from standing
+	*/
+	bool HasCeilingClearance();
+
 	/*
 	* Checks if the player currently is wall running.
 	* @returns bool	- true: if the player is wall running
@@ -518,5 +734,13 @@ private:
 
 	ALazerTagCharacter* prevTarget;
 
+	ECharacterSignificance CurrentSignificance = ECharacterSignificance::FULL;
+
+	/* Sets the frames the third person mesh skips between anim evaluations from the significance tier */
+	void ApplyAnimUpdateRate(FAnimUpdateRateParameters* params) const;
+
+	// memory released by StripCosmeticComponents, tracked so the stat can be lowered again when we go away
+	int64 i_strippedComponentBytes = 0;
+
 };
 
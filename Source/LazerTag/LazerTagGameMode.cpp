@@ -1,17 +1,219 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "LazerTagGameMode.h"
+#include "LazerTag.h"
 #include "LazerTagHUD.h"
 #include "LazerTagCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "AssetLoadReport.h"
+#include "LazerTag_GI.h"
+#include "GameFramework/PlayerStart.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLazerTagGameMode, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Respawn Pooled"), STAT_RespawnPooled, STATGROUP_LazerTag);
+DECLARE_CYCLE_STAT(TEXT("Respawn Full"), STAT_RespawnFull, STATGROUP_LazerTag);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Characters"), STAT_PooledCharacters, STATGROUP_LazerTag);
 
 ALazerTagGameMode::ALazerTagGameMode()
 	: Super()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnClassFinder(TEXT("/Game/FirstPersonCPP/Blueprints/FirstPersonCharacter"));
-	DefaultPawnClass = PlayerPawnClassFinder.Class;
+	// set default pawn class to our Blueprinted character, it is loaded in InitGame instead of when the class default object is made
+	DefaultPawnClassAsset = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/FirstPersonCPP/Blueprints/FirstPersonCharacter.FirstPersonCharacter_C")));
+	DefaultPawnClass = nullptr;
 
 	// use our custom HUD class
 	HUDClass = ALazerTagHUD::StaticClass();
 }
+
+void ALazerTagGameMode::RespawnPlayer(AController* controller)
+{
+	if (controller == nullptr)
+		return;
+
+	double startTime = FPlatformTime::Seconds();
+
+	ALazerTagCharacter* character = Cast<ALazerTagCharacter>(controller->GetPawn());
+
+	if (b_usePooledRespawn && character != nullptr && character->GetClass() == GetDefaultPawnClassForController(controller))
+	{
+		SCOPE_CYCLE_COUNTER(STAT_RespawnPooled);
+
+		AActor* start = ChoosePlayerStart(controller);
+		FTransform spawnTransform = (start != nullptr) ? start->GetActorTransform() : character->GetActorTransform();
+
+		// the pitch and roll of a player start should never be applied to a character
+		FRotator spawnRotation = spawnTransform.Rotator();
+		spawnRotation = FRotator(0.f, spawnRotation.Yaw, 0.f);
+		spawnTransform.SetRotation(spawnRotation.Quaternion());
+
+		ReuseCharacter(character, spawnTransform);
+
+		controller->SetControlRotation(spawnRotation);
+		controller->ClientSetRotation(spawnRotation, true);
+
+		RecordRespawnTime(true, FPlatformTime::Seconds() - startTime);
+	}
+	else
+	{
+		SCOPE_CYCLE_COUNTER(STAT_RespawnFull);
+
+		if (APawn* pawn = controller->GetPawn())
+		{
+			controller->UnPossess();
+			pawn->Destroy();
+		}
+
+		RestartPlayer(controller);
+
+		RecordRespawnTime(false, FPlatformTime::Seconds() - startTime);
+	}
+}
+
+void ALazerTagGameMode::ReleaseCharacter(ALazerTagCharacter* character)
+{
+	if (character == nullptr || character->IsPendingKill())
+		return;
+
+	if (AController* controller = character->GetController())
+	{
+		controller->UnPossess();
+	}
+
+	if (m_characterPool.Num() >= i_maxPooledCharacters)
+	{
+		character->Destroy();
+		return;
+	}
+
+	// keep it out of the way until it is needed again
+	character->SetActorHiddenInGame(true);
+	character->SetActorEnableCollision(false);
+	character->SetActorTickEnabled(false);
+
+	m_characterPool.Add(character);
+
+	SET_DWORD_STAT(STAT_PooledCharacters, m_characterPool.Num());
+}
+
+void ALazerTagGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	LoadDefaultPawnClass();
+}
+
+void ALazerTagGameMode::LoadDefaultPawnClass()
+{
+	// a blueprint game mode that picked its own pawn class doesn't need the default one
+	if (DefaultPawnClass != nullptr || DefaultPawnClassAsset.IsNull())
+		return;
+
+	// every machine keeps the character's sounds and montages loaded through the game instance
+	if (ULazerTag_GI* gameInstance = GetGameInstance<ULazerTag_GI>())
+	{
+		gameInstance->PreloadCharacter(DefaultPawnClassAsset);
+	}
+
+	// a listen server or standalone player spawns inside this map load, straight after InitGame,
+	// so a background load can never finish in time. Block now while the loading screen is still up.
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		double startTime = FPlatformTime::Seconds();
+
+		DefaultPawnClass = DefaultPawnClassAsset.LoadSynchronous();
+
+		FAssetLoadReport::RecordSyncLoad(TEXT("Default pawn class (map load)"), FPlatformTime::Seconds() - startTime);
+		return;
+	}
+
+	TArray<FSoftObjectPath> assets;
+	assets.Add(DefaultPawnClassAsset.ToSoftObjectPath());
+
+	m_pawnClassHandle = FAssetLoadReport::RequestAsyncLoad(assets, TEXT("Default pawn class"),
+		FStreamableDelegate::CreateUObject(this, &ALazerTagGameMode::OnDefaultPawnClassLoaded));
+}
+
+void ALazerTagGameMode::OnDefaultPawnClassLoaded()
+{
+	// DefaultPawnClass holds it from here on
+	if (DefaultPawnClass == nullptr)
+	{
+		DefaultPawnClass = DefaultPawnClassAsset.Get();
+	}
+
+	m_pawnClassHandle.Reset();
+}
+
+UClass* ALazerTagGameMode::GetDefaultPawnClassForController_Implementation(AController* InController)
+{
+	// a player joined before the background load finished, nothing for it but to wait
+	if (DefaultPawnClass == nullptr && !DefaultPawnClassAsset.IsNull())
+	{
+		double startTime = FPlatformTime::Seconds();
+
+		DefaultPawnClass = DefaultPawnClassAsset.LoadSynchronous();
+
+		if (DefaultPawnClass != nullptr)
+		{
+			FAssetLoadReport::RecordSyncLoad(TEXT("Default pawn class"), FPlatformTime::Seconds() - startTime);
+		}
+	}
+
+	return Super::GetDefaultPawnClassForController_Implementation(InController);
+}
+
+APawn* ALazerTagGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	UClass* pawnClass = GetDefaultPawnClassForController(NewPlayer);
+
+	// take the first pooled character that is the right class
+	for (int i = 0; i < m_characterPool.Num(); i++)
+	{
+		ALazerTagCharacter* character = m_characterPool[i];
+
+		if (character != nullptr && !character->IsPendingKill() && character->GetClass() == pawnClass)
+		{
+			m_characterPool.RemoveAtSwap(i);
+
+			SET_DWORD_STAT(STAT_PooledCharacters, m_characterPool.Num());
+
+			character->SetActorHiddenInGame(false);
+			character->SetActorEnableCollision(true);
+			character->SetActorTickEnabled(true);
+
+			ReuseCharacter(character, SpawnTransform);
+
+			return character;
+		}
+	}
+
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+}
+
+void ALazerTagGameMode::ReuseCharacter(ALazerTagCharacter* character, const FTransform& spawnTransform)
+{
+	character->ResetForRespawn();
+
+	character->TeleportTo(spawnTransform.GetLocation(), spawnTransform.Rotator(), false, true);
+}
+
+void ALazerTagGameMode::RecordRespawnTime(bool bPooled, double seconds)
+{
+	double average;
+
+	if (bPooled)
+	{
+		f_pooledRespawnSeconds += seconds;
+		i_pooledRespawns++;
+		average = f_pooledRespawnSeconds / i_pooledRespawns;
+	}
+	else
+	{
+		f_fullRespawnSeconds += seconds;
+		i_fullRespawns++;
+		average = f_fullRespawnSeconds / i_fullRespawns;
+	}
+
+	UE_LOG(LogLazerTagGameMode, Log, TEXT("%s respawn took %.3f ms (average %.3f ms over %d)"),
+		bPooled ? TEXT("Pooled") : TEXT("Full"), seconds * 1000.0, average * 1000.0, bPooled ? i_pooledRespawns : i_fullRespawns);
+}
@@ -4,8 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "Engine/StreamableManager.h"
 #include "LazerTagGameMode.generated.h"
 
+class ALazerTagCharacter;
+
 UCLASS(minimalapi)
 class ALazerTagGameMode : public AGameModeBase
 {
@@ -13,6 +16,77 @@ class ALazerTagGameMode : public AGameModeBase
 
 public:
 	ALazerTagGameMode();
+
+	/*
+	* Respawns a tagged out player at a new player start.
+	* When pooled respawns are enabled the player's current character is reset and teleported instead of being destroyed and spawned again.
+	* @param controller - the controller of the player to respawn
+	*/
+	UFUNCTION(blueprintCallable, blueprintAuthorityOnly, category = "Respawn")
+	void RespawnPlayer(AController* controller);
+
+	/*
+	* Hides a character that is no longer needed and keeps it around so the next spawn can reuse it.
+	* Destroys the character instead if the pool is full.
+	*/
+	UFUNCTION(blueprintCallable, blueprintAuthorityOnly, category = "Respawn")
+	void ReleaseCharacter(ALazerTagCharacter* character);
+
+	// AGameModeBase interface
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual UClass* GetDefaultPawnClassForController_Implementation(AController* InController) override;
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+	// End of AGameModeBase interface
+
+	const TSoftClassPtr<APawn>& GetDefaultPawnClassAsset() const { return DefaultPawnClassAsset; }
+
+protected:
+
+	// pawn class loaded while the map loads, only used if DefaultPawnClass isn't set
+	UPROPERTY(editDefaultsOnly, category = "Classes")
+	TSoftClassPtr<APawn> DefaultPawnClassAsset;
+
+	// reuse characters when respawning instead of destroying and spawning them
+	UPROPERTY(editAnywhere, blueprintReadWrite, category = "Respawn")
+	bool b_usePooledRespawn = true;
+
+	// most characters that can sit in the pool at once
+	UPROPERTY(editAnywhere, category = "Respawn")
+	int i_maxPooledCharacters = 8;
+
+private:
+
+	/*
+	* Loads the pawn class, blocking if a local player is about to spawn with this map, and has the game instance preload its
+	* sounds and montages.
+	*/
+	void LoadDefaultPawnClass();
+
+	/* Called once the pawn class has loaded in the background */
+	void OnDefaultPawnClassLoaded();
+
+	// keeps the pawn class loaded until it is stored in DefaultPawnClass
+	TSharedPtr<FStreamableHandle> m_pawnClassHandle;
+
+	/*
+	* Resets a character and moves it to a new transform.
+	* @param character - character to reuse
+	* @param spawnTransform - where the character should end up
+	*/
+	void ReuseCharacter(ALazerTagCharacter* character, const FTransform& spawnTransform);
+
+	/* Logs how long a respawn took and keeps a running average for each path */
+	void RecordRespawnTime(bool bPooled, double seconds);
+
+	// released characters waiting to be reused
+	UPROPERTY()
+	TArray<ALazerTagCharacter*> m_characterPool;
+
+	// running totals used to compare the two respawn paths
+	double f_pooledRespawnSeconds = 0.0;
+	int i_pooledRespawns = 0;
+	double f_fullRespawnSeconds = 0.0;
+	int i_fullRespawns = 0;
 };
 
 
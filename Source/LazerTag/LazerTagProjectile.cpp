@@ -4,7 +4,9 @@
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
 #include "LazerTagCharacter.h"
-#include "PState.h"
+#include "WeaponArchetype.h"
+#include "GameplayEventLog.h"
+#include "Net/UnrealNetwork.h"
 
 ALazerTagProjectile::ALazerTagProjectile() 
 {
@@ -24,13 +26,73 @@ ALazerTagProjectile::ALazerTagProjectile()
 	// Use a ProjectileMovementComponent to govern this projectile's movement
 	ProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileComp"));
 	ProjectileMovement->UpdatedComponent = CollisionComp;
-	ProjectileMovement->InitialSpeed = 3000.f;
-	ProjectileMovement->MaxSpeed = 3000.f;
 	ProjectileMovement->bRotationFollowsVelocity = true;
-	ProjectileMovement->bShouldBounce = true;
 
-	// Die after 3 seconds by default
-	InitialLifeSpan = 3.0f;
+	// speed, bounce and life span come from the weapon archetype when one is assigned, see ApplyWeaponArchetype
+}
+
+void ALazerTagProjectile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(ALazerTagProjectile, WeaponId, COND_InitialOnly);
+}
+
+void ALazerTagProjectile::PreInitializeComponents()
+{
+	Super::PreInitializeComponents();
+
+	ApplyWeaponArchetype();
+}
+
+void ALazerTagProjectile::PostNetInit()
+{
+	// the movement component already started with the default speed, keep the direction but fix the speed
+	if (ApplyWeaponArchetype() && !IsReplicatingMovement() && !ProjectileMovement->Velocity.IsNearlyZero())
+	{
+		ProjectileMovement->Velocity = ProjectileMovement->Velocity.GetSafeNormal() * ProjectileMovement->InitialSpeed;
+	}
+
+	Super::PostNetInit();
+}
+
+bool ALazerTagProjectile::ApplyWeaponArchetype()
+{
+	const UWeaponArchetype* weapon = GetAssignedWeaponArchetype();
+
+	if (weapon == nullptr)
+		return false;
+
+	ProjectileMovement->InitialSpeed = weapon->ProjectileSpeed;
+	ProjectileMovement->MaxSpeed = weapon->ProjectileMaxSpeed;
+	ProjectileMovement->bShouldBounce = weapon->bProjectileBounces;
+
+	InitialLifeSpan = weapon->ProjectileLifeSpan;
+
+	return true;
+}
+
+const UWeaponArchetype* ALazerTagProjectile::GetWeaponArchetype() const
+{
+	const UWeaponArchetype* weapon = GetAssignedWeaponArchetype();
+
+	return (weapon != nullptr) ? weapon : GetDefault<UWeaponArchetype>();
+}
+
+const UWeaponArchetype* ALazerTagProjectile::GetAssignedWeaponArchetype() const
+{
+	// the instigator knows about its legacy weapon, the registry alone would skip it
+	if (const ALazerTagCharacter* character = Cast<ALazerTagCharacter>(GetInstigator()))
+	{
+		return character->GetAssignedWeaponArchetype(WeaponId);
+	}
+
+	return UWeaponRegistry::FindRegistered(this, WeaponId);
+}
+
+void ALazerTagProjectile::SetWeaponId(uint8 weaponId)
+{
+	WeaponId = weaponId;
 }
 
 void ALazerTagProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
@@ -38,25 +100,11 @@ void ALazerTagProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor
 	// Only add impulse and destroy projectile if we hit a physics
 	if ((OtherActor != nullptr) && (OtherActor != this) && (OtherActor != shooter))
 	{
+		UGameplayEventLogSubsystem::Record(this, EGameplayEventType::PROJECTILE_IMPACT, OtherActor);
+
 		if ( ALazerTagCharacter* const target = Cast<ALazerTagCharacter>(OtherActor) )
 		{
-			target->OnHit();
-
-			if (target->GetRemainingCharges() > 0)
-			{
-				target->UpdateCharges(-1);
-			}
-			else
-			{
-				if (shooter != nullptr)
-				{
-					shooter->HitPlayer();
-					if (APState* const pState = Cast<APState>(shooter->GetPlayerState()) )
-					{
-						pState->UpdateScore(5);
-					}
-				}				
-			}
+			target->ReceiveWeaponHit(shooter, GetWeaponArchetype());
 		}
 
 		if ((OtherComp != nullptr) && OtherComp->IsSimulatingPhysics())
@@ -9,6 +9,7 @@
 class USphereComponent;
 class UProjectileMovementComponent;
 class ALazerTagCharacter;
+class UWeaponArchetype;
 
 UCLASS(config=Game)
 class ALazerTagProjectile : public AActor
@@ -35,14 +36,47 @@ public:
 	/** Returns ProjectileMovement subobject **/
 	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
 
+	// required network setup
+	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	/* Sets the reference of who shot the projectile */
 	void SetShooter(ALazerTagCharacter* _shooter);
 
-	UPROPERTY(editAnywhere, category = "Score")
-	int scorePerHit = 5;
+	/*
+	* Sets which weapon fired the projectile. Must be called before the projectile finishes spawning.
+	* @param weaponId - index of the weapon in the weapon registry
+	*/
+	void SetWeaponId(uint8 weaponId);
+
+	/* Gets the archetype of the weapon that fired this projectile */
+	const UWeaponArchetype* GetWeaponArchetype() const;
+
+protected:
+
+	/*
+	* Applies the weapon's speed, bounce and life span before the movement component uses them.
+	* Projectiles without an assigned weapon keep the values set in their Blueprint.
+	*/
+	virtual void PreInitializeComponents() override;
+
+	/* Applies the weapon again on clients once the replicated weapon ID has arrived */
+	virtual void PostNetInit() override;
 
 private:
 
+	/*
+	* Copies the weapon's movement settings onto this projectile.
+	* @return false if no weapon is assigned and nothing was changed
+	*/
+	bool ApplyWeaponArchetype();
+
+	/* Gets the weapon from the registry or the instigator's legacy weapon, null if neither has one */
+	const UWeaponArchetype* GetAssignedWeaponArchetype() const;
+
+	// weapon that fired this projectile, only sent when the projectile is first replicated
+	UPROPERTY(replicated)
+	uint8 WeaponId = 0;
+
 	/* Keep a reference of who shot the projectile */
 	ALazerTagCharacter* shooter;
 };
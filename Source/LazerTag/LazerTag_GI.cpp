@@ -1,5 +1,9 @@
 
 #include "LazerTag_GI.h"
+#include "LazerTagGameMode.h"
+#include "LazerTagCharacter.h"
+#include "AssetLoadReport.h"
+#include "WeaponArchetype.h"
 
 void ULazerTag_GI::SetTimeLimit(int limit)
 {
@@ -32,3 +36,59 @@ void ULazerTag_GI::Travel(FString mapPath, FString gmPath, FString options)
 
 	GetWorld()->ServerTravel(URL);
 }
+
+void ULazerTag_GI::Init()
+{
+	Super::Init();
+
+	// clients never run the game mode, so start on the standard character here where every machine will see it
+	PreloadCharacter(GetDefault<ALazerTagGameMode>()->GetDefaultPawnClassAsset());
+}
+
+void ULazerTag_GI::PreloadCharacter(const TSoftClassPtr<APawn>& pawnClass)
+{
+	if (pawnClass.IsNull() || m_preloadedCharacters.Contains(pawnClass.ToSoftObjectPath()))
+		return;
+
+	m_preloadedCharacters.Add(pawnClass.ToSoftObjectPath());
+
+	TArray<FSoftObjectPath> assets;
+	assets.Add(pawnClass.ToSoftObjectPath());
+
+	TSharedPtr<FStreamableHandle> handle = FAssetLoadReport::RequestAsyncLoad(assets, TEXT("Character class (preload)"),
+		FStreamableDelegate::CreateUObject(this, &ULazerTag_GI::OnPreloadedCharacterLoaded, TSoftClassPtr<APawn>(pawnClass)));
+
+	if (handle.IsValid())
+	{
+		m_preloadHandles.Add(handle);
+	}
+}
+
+void ULazerTag_GI::OnPreloadedCharacterLoaded(TSoftClassPtr<APawn> pawnClass)
+{
+	// a dedicated server never plays any of the cosmetics
+	if (IsDedicatedServerInstance())
+		return;
+
+	const UClass* loadedClass = pawnClass.Get();
+	const ALazerTagCharacter* defaults = (loadedClass != nullptr) ? Cast<ALazerTagCharacter>(loadedClass->GetDefaultObject()) : nullptr;
+
+	if (defaults == nullptr)
+		return;
+
+	TArray<FSoftObjectPath> assets;
+	defaults->GetCosmeticAssets(assets);
+
+	// the class defaults can't see the registry so add every weapon here
+	if (WeaponRegistry != nullptr)
+	{
+		WeaponRegistry->GetCosmeticAssets(assets);
+	}
+
+	TSharedPtr<FStreamableHandle> handle = FAssetLoadReport::RequestAsyncLoad(assets, loadedClass->GetName() + TEXT(" cosmetics (preload)"));
+
+	if (handle.IsValid())
+	{
+		m_preloadHandles.Add(handle);
+	}
+}
@@ -6,6 +6,7 @@
 #include "Engine/GameInstance.h"
 #include "GameFramework/GameMode.h"
 #include "GameFramework/PlayerController.h"
+#include "Engine/StreamableManager.h"
 #include "LazerTag_GI.generated.h"
 
 
@@ -25,6 +26,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Game Modes")
 	TArray<TSubclassOf<class AGameMode>> GameModes;
 
+	// every weapon in the game, loaded once with the game instance
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weapons")
+	class UWeaponRegistry* WeaponRegistry;
+
 	UFUNCTION(blueprintCallable, Category = "Time")
 	void SetTimeLimit(int limit);
 
@@ -40,6 +45,16 @@ public:
 	UFUNCTION(blueprintCallable)
 	void Travel(FString mapPath, FString gmPath, FString options);
 
+	virtual void Init() override;
+
+	/*
+	* Starts loading a character class and the sounds and montages it and every weapon play, so the first character to spawn
+	* doesn't have to wait for them. Runs on every machine, servers and clients alike, and each class is only loaded once.
+	* The assets stay loaded for the whole session so map travel doesn't load them again.
+	* @param pawnClass - character class to load
+	*/
+	void PreloadCharacter(const TSoftClassPtr<APawn>& pawnClass);
+
 protected:
 
 	UPROPERTY(visibleAnywhere, blueprintReadOnly)
@@ -47,5 +62,16 @@ protected:
 
 	UPROPERTY(visibleAnywhere, blueprintReadOnly)
 	int insTimeLimit;
+
+private:
+
+	/* Called once a preloaded character class has loaded, starts on its cosmetics */
+	void OnPreloadedCharacterLoaded(TSoftClassPtr<APawn> pawnClass);
+
+	// character classes PreloadCharacter has been asked for
+	TSet<FSoftObjectPath> m_preloadedCharacters;
+
+	// keeps the preloaded classes and cosmetics loaded
+	TArray<TSharedPtr<FStreamableHandle>> m_preloadHandles;
 	
 };
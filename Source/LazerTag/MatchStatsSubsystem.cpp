@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MatchStatsSubsystem.h"
+#include "LazerTag.h"
+#include "LazerTagCharacter.h"
+#include "Async/Async.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMatchStats, Log, All);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Match Stat Players"), STAT_MatchStatPlayers, STATGROUP_LazerTag);
+
+bool UMatchStatsSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* world = Cast<UWorld>(Outer);
+
+	return world != nullptr && world->IsGameWorld();
+}
+
+void UMatchStatsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	m_slots = static_cast<FPlayerStatSlot*>(FMemory::Malloc(MaxPlayers * sizeof(FPlayerStatSlot), alignof(FPlayerStatSlot)));
+
+	for (int32 i = 0; i < MaxPlayers; i++)
+	{
+		new (&m_slots[i]) FPlayerStatSlot();
+	}
+}
+
+void UMatchStatsSubsystem::Deinitialize()
+{
+	// the map is going away without anyone ending the match, don't lose what was counted
+	if (b_dirty)
+	{
+		WriteMatchSummary();
+	}
+
+	m_slotLookup.Empty();
+
+	Super::Deinitialize();
+}
+
+void UMatchStatsSubsystem::BeginDestroy()
+{
+	if (m_slots != nullptr)
+	{
+		i_numSlots.store(0, std::memory_order_release);
+
+		for (int32 i = 0; i < MaxPlayers; i++)
+		{
+			m_slots[i].~FPlayerStatSlot();
+		}
+
+		FMemory::Free(m_slots);
+		m_slots = nullptr;
+	}
+
+	Super::BeginDestroy();
+}
+
+UMatchStatsSubsystem* UMatchStatsSubsystem::Get(const AActor* actor)
+{
+	if (actor == nullptr || !actor->HasAuthority())
+		return nullptr;
+
+	UWorld* world = actor->GetWorld();
+
+	return (world != nullptr) ? world->GetSubsystem<UMatchStatsSubsystem>() : nullptr;
+}
+
+UMatchStatsSubsystem::FPlayerStatSlot* UMatchStatsSubsystem::FindSlot(const ALazerTagCharacter* character)
+{
+	check(IsInGameThread());
+
+	APlayerState* playerState = (character != nullptr) ? character->GetPlayerState() : nullptr;
+
+	if (playerState == nullptr)
+		return nullptr;
+
+	if (const int32* found = m_slotLookup.Find(playerState))
+	{
+		return &m_slots[*found];
+	}
+
+	int32 index = i_numSlots.load(std::memory_order_relaxed);
+
+	if (index >= MaxPlayers)
+		return nullptr;
+
+	m_slotNames[index] = playerState->GetPlayerName();
+	m_slotLookup.Add(playerState, index);
+
+	// the name has to be visible before a snapshot can see the slot
+	i_numSlots.store(index + 1, std::memory_order_release);
+
+	SET_DWORD_STAT(STAT_MatchStatPlayers, index + 1);
+
+	return &m_slots[index];
+}
+
+void UMatchStatsSubsystem::RecordShots(const ALazerTagCharacter* shooter, int count)
+{
+	if (FPlayerStatSlot* slot = FindSlot(shooter))
+	{
+		slot->ShotsFired.fetch_add(count, std::memory_order_relaxed);
+		b_dirty = true;
+	}
+}
+
+void UMatchStatsSubsystem::RecordHit(const ALazerTagCharacter* shooter, const ALazerTagCharacter* target, bool bShieldHit, bool bShieldBroken)
+{
+	if (FPlayerStatSlot* slot = FindSlot(shooter))
+	{
+		if (bShieldHit)
+		{
+			slot->ShieldHits.fetch_add(1, std::memory_order_relaxed);
+
+			if (bShieldBroken)
+			{
+				slot->ShieldBreaks.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		else
+		{
+			slot->Tags.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		b_dirty = true;
+	}
+
+	if (!bShieldHit)
+	{
+		if (FPlayerStatSlot* slot = FindSlot(target))
+		{
+			slot->TimesTagged.fetch_add(1, std::memory_order_relaxed);
+			b_dirty = true;
+		}
+	}
+}
+
+void UMatchStatsSubsystem::RecordPickup(const ALazerTagCharacter* collector)
+{
+	if (FPlayerStatSlot* slot = FindSlot(collector))
+	{
+		slot->Pickups.fetch_add(1, std::memory_order_relaxed);
+		b_dirty = true;
+	}
+}
+
+void UMatchStatsSubsystem::RecordWallRun(const ALazerTagCharacter* runner, float seconds)
+{
+	if (seconds <= 0.f)
+		return;
+
+	if (FPlayerStatSlot* slot = FindSlot(runner))
+	{
+		slot->WallRunMilliseconds.fetch_add(FMath::RoundToInt(seconds * 1000.f), std::memory_order_relaxed);
+		b_dirty = true;
+	}
+}
+
+void UMatchStatsSubsystem::Snapshot(TArray<FPlayerMatchStats>& outStats) const
+{
+	const int32 numSlots = i_numSlots.load(std::memory_order_acquire);
+
+	outStats.SetNum(numSlots);
+
+	for (int32 i = 0; i < numSlots; i++)
+	{
+		const FPlayerStatSlot& slot = m_slots[i];
+		FPlayerMatchStats& stats = outStats[i];
+
+		stats.PlayerName = m_slotNames[i];
+		stats.ShotsFired = slot.ShotsFired.load(std::memory_order_relaxed);
+		stats.Tags = slot.Tags.load(std::memory_order_relaxed);
+		stats.ShieldHits = slot.ShieldHits.load(std::memory_order_relaxed);
+		stats.ShieldBreaks = slot.ShieldBreaks.load(std::memory_order_relaxed);
+		stats.TimesTagged = slot.TimesTagged.load(std::memory_order_relaxed);
+		stats.Pickups = slot.Pickups.load(std::memory_order_relaxed);
+		stats.WallRunSeconds = slot.WallRunMilliseconds.load(std::memory_order_relaxed) / 1000.f;
+	}
+}
+
+TArray<FPlayerMatchStats> UMatchStatsSubsystem::GetMatchStats() const
+{
+	TArray<FPlayerMatchStats> stats;
+	Snapshot(stats);
+
+	return stats;
+}
+
+void UMatchStatsSubsystem::WriteMatchSummary()
+{
+	TArray<FPlayerMatchStats> stats;
+	Snapshot(stats);
+
+	b_dirty = false;
+
+	if (stats.Num() == 0)
+		return;
+
+	const FString mapName = GetWorld() != nullptr ? GetWorld()->GetMapName() : FString(TEXT("Unknown"));
+	const FDateTime now = FDateTime::UtcNow();
+	const FString path = FPaths::ProjectSavedDir() / TEXT("MatchStats") / FString::Printf(TEXT("%s_%s.json"), *mapName, *now.ToString());
+
+	// nothing below touches the subsystem so it can finish after the world is gone
+	Async(EAsyncExecution::ThreadPool, [stats = MoveTemp(stats), mapName, now, path]()
+	{
+		TSharedRef<FJsonObject> root = MakeShared<FJsonObject>();
+		root->SetNumberField(TEXT("version"), 1);
+		root->SetStringField(TEXT("map"), mapName);
+		root->SetStringField(TEXT("endTime"), now.ToIso8601());
+
+		TArray<TSharedPtr<FJsonValue>> players;
+
+		for (const FPlayerMatchStats& player : stats)
+		{
+			TSharedRef<FJsonObject> entry = MakeShared<FJsonObject>();
+			entry->SetStringField(TEXT("name"), player.PlayerName);
+			entry->SetNumberField(TEXT("shotsFired"), player.ShotsFired);
+			entry->SetNumberField(TEXT("tags"), player.Tags);
+			entry->SetNumberField(TEXT("shieldHits"), player.ShieldHits);
+			entry->SetNumberField(TEXT("shieldBreaks"), player.ShieldBreaks);
+			entry->SetNumberField(TEXT("timesTagged"), player.TimesTagged);
+			entry->SetNumberField(TEXT("pickups"), player.Pickups);
+			entry->SetNumberField(TEXT("wallRunSeconds"), player.WallRunSeconds);
+			entry->SetNumberField(TEXT("accuracy"), player.GetAccuracy());
+
+			players.Add(MakeShared<FJsonValueObject>(entry));
+		}
+
+		root->SetArrayField(TEXT("players"), players);
+
+		FString json;
+		TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&json);
+
+		if (FJsonSerializer::Serialize(root, writer) && FFileHelper::SaveStringToFile(json, *path))
+		{
+			UE_LOG(LogMatchStats, Log, TEXT("Wrote match stats for %d players to %s"), stats.Num(), *path);
+		}
+		else
+		{
+			UE_LOG(LogMatchStats, Warning, TEXT("Failed to write match stats to %s"), *path);
+		}
+	});
+}
+
+static FAutoConsoleCommandWithWorld DumpMatchStatsCommand(
+	TEXT("lt.DumpMatchStats"),
+	TEXT("Logs the match stats counted so far. Server only."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* world)
+	{
+		UMatchStatsSubsystem* matchStats = (world != nullptr) ? world->GetSubsystem<UMatchStatsSubsystem>() : nullptr;
+
+		if (matchStats == nullptr)
+			return;
+
+		TArray<FPlayerMatchStats> stats;
+		matchStats->Snapshot(stats);
+
+		for (const FPlayerMatchStats& player : stats)
+		{
+			UE_LOG(LogMatchStats, Log, TEXT("%s: shots %d, tags %d, shield hits %d (%d broken), tagged %d, pickups %d, wall run %.1fs, accuracy %.0f%%"),
+				*player.PlayerName, player.ShotsFired, player.Tags, player.ShieldHits, player.ShieldBreaks, player.TimesTagged,
+				player.Pickups, player.WallRunSeconds, player.GetAccuracy() * 100.f);
+		}
+	}));
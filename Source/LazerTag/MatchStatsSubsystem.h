@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include <atomic>
+#include "MatchStatsSubsystem.generated.h"
+
+class APlayerState;
+class ALazerTagCharacter;
+
+// one player's totals for the match, copied out of the live counters
+USTRUCT(blueprinttype)
+struct FPlayerMatchStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(blueprintReadOnly, category = "Match Stats")
+	FString PlayerName;
+
+	UPROPERTY(blueprintReadOnly, category = "Match Stats")
+	int ShotsFired = 0;
+
+	// shots that tagged out another player
+	UPROPERTY(blueprintReadOnly, category = "Match Stats")
+	int Tags = 0;
+
+	// shots absorbed by another player's shield
+	UPROPERTY(blueprintReadOnly, category = "Match Stats")
+	int ShieldHits = 0;
+
+	// shield hits that used up the target's last charge
+	UPROPERTY(blueprintReadOnly, category = "Match Stats")
+	int ShieldBreaks = 0;
+
+	UPROPERTY(blueprintReadOnly, category = "Match Stats")
+	int TimesTagged = 0;
+
+	UPROPERTY(blueprintReadOnly, category = "Match Stats")
+	int Pickups = 0;
+
+	UPROPERTY(blueprintReadOnly, category = "Match Stats")
+	float WallRunSeconds = 0.f;
+
+	// fraction of shots that hit anyone, shield or not
+	float GetAccuracy() const { return ShotsFired > 0 ? (float)(Tags + ShieldHits) / ShotsFired : 0.f; }
+};
+
+/**
+ * Keeps per-player counters of shots, tags, shield hits, pickups and wall run time for the current match. Server only.
+ * Each player gets a cache line sized slot of relaxed atomics, so the game thread never takes a lock to count something
+ * and a snapshot can be taken from any thread while the match is running.
+ * The summary is written to Saved/MatchStats as JSON on a worker thread when the match ends.
+ */
+UCLASS()
+class LAZERTAG_API UMatchStatsSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// most players that get their own slot, later players aren't counted
+	static constexpr int MaxPlayers = 64;
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	/* Frees the slots once nothing can be reading them */
+	virtual void BeginDestroy() override;
+
+	/*
+	* Gets the subsystem for an actor's world, but only where the actor has authority.
+	* @returns null on clients
+	*/
+	static UMatchStatsSubsystem* Get(const AActor* actor);
+
+	void RecordShots(const ALazerTagCharacter* shooter, int count);
+
+	/*
+	* Counts a hit for both players.
+	* @param bShieldHit - the target's shield absorbed the hit
+	* @param bShieldBroken - the shield hit used up the last charge
+	*/
+	void RecordHit(const ALazerTagCharacter* shooter, const ALazerTagCharacter* target, bool bShieldHit, bool bShieldBroken);
+
+	void RecordPickup(const ALazerTagCharacter* collector);
+
+	void RecordWallRun(const ALazerTagCharacter* runner, float seconds);
+
+	/*
+	* Copies every player's counters. Never blocks the game thread so it can be called from any thread.
+	* @param outStats - one entry per player that has been counted
+	*/
+	void Snapshot(TArray<FPlayerMatchStats>& outStats) const;
+
+	/* Writes the summary for the match so far on a worker thread. Call when the match ends. */
+	UFUNCTION(blueprintCallable, blueprintAuthorityOnly, category = "Match Stats")
+	void WriteMatchSummary();
+
+	UFUNCTION(blueprintCallable, category = "Match Stats")
+	TArray<FPlayerMatchStats> GetMatchStats() const;
+
+private:
+
+	// padded to a cache line so players counted on different threads never share one
+	struct alignas(PLATFORM_CACHE_LINE_SIZE) FPlayerStatSlot
+	{
+		std::atomic<int32> ShotsFired{ 0 };
+		std::atomic<int32> Tags{ 0 };
+		std::atomic<int32> ShieldHits{ 0 };
+		std::atomic<int32> ShieldBreaks{ 0 };
+		std::atomic<int32> TimesTagged{ 0 };
+		std::atomic<int32> Pickups{ 0 };
+		std::atomic<int32> WallRunMilliseconds{ 0 };
+	};
+
+	/*
+	* Finds or assigns the slot for a character's player. Game thread only.
+	* @returns null if the character has no player or every slot is taken
+	*/
+	FPlayerStatSlot* FindSlot(const ALazerTagCharacter* character);
+
+	// allocated once so slots never move while they are being read. operator new only guarantees 16 byte
+	// alignment before C++17 so the memory comes from FMemory with the cache line alignment the slots ask for
+	FPlayerStatSlot* m_slots = nullptr;
+
+	// names of the players in each slot, written on the game thread before the slot count is published
+	FString m_slotNames[MaxPlayers];
+
+	// slots handed out so far, published with release so readers see the name first
+	std::atomic<int32> i_numSlots{ 0 };
+
+	TMap<TWeakObjectPtr<APlayerState>, int32> m_slotLookup;
+
+	// something was counted since the summary was last written
+	bool b_dirty = false;
+};
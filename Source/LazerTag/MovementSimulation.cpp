@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementSimulation.h"
+#include "WallGeometry.h"
+#include "Misc/AutomationTest.h"
+
+int FMovementSimulation::ConsumeFixedSteps(float& accumulator, float deltaTime)
+{
+	accumulator += deltaTime;
+
+	int steps = FMath::FloorToInt(accumulator / FixedStep);
+
+	if (steps > MaxSubsteps)
+	{
+		// too far behind to catch up, throw the rest away
+		accumulator = 0.f;
+		return MaxSubsteps;
+	}
+
+	accumulator -= steps * FixedStep;
+
+	return steps;
+}
+
+FVector FMovementSimulation::FloorInfluence(const FVector& floorNormal)
+{
+	return FWallGeometry::FloorInfluence(floorNormal);
+}
+
+bool FMovementSimulation::StepSlide(FVector& velocity, const FVector& floorNormal, const FSlideStepParams& params)
+{
+	velocity += FloorInfluence(floorNormal) * params.SlopeAcceleration * FixedStep;
+
+	float speed = velocity.Size();
+
+	if (speed > params.MaxSpeed)
+	{
+		velocity *= params.MaxSpeed / speed;
+	}
+	else if (speed < params.MinSpeed)
+	{
+		velocity = FVector(0, 0, 0);
+
+		return false;
+	}
+
+	return true;
+}
+
+FVector FMovementSimulation::IntoWall(const FVector& wallRunDir, bool bWallOnLeft, float reach)
+{
+	// check what side of the player the wall is on to get a vector that goes into the wall
+	if (bWallOnLeft)
+		return FVector::CrossProduct(wallRunDir, FVector::UpVector) * reach;
+	else
+		return FVector::CrossProduct(wallRunDir, -FVector::UpVector) * reach;
+}
+
+FVector FMovementSimulation::WallRunVelocity(const FVector& wallRunDir, float speed)
+{
+	return FVector(wallRunDir.X, wallRunDir.Y, 0) * speed;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementSimulationTest, "LazerTag.MovementSimulation", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMovementSimulationTest::RunTest(const FString& Parameters)
+{
+	using Sim = FMovementSimulation;
+
+	// fixed steps
+
+	float accumulator = 0.f;
+	TestEqual(TEXT("Less than a step runs nothing"), Sim::ConsumeFixedSteps(accumulator, Sim::FixedStep * 0.5f), 0);
+	TestEqual(TEXT("Leftover time carries over"), Sim::ConsumeFixedSteps(accumulator, Sim::FixedStep * 0.75f), 1);
+	TestEqual(TEXT("Carried time is what's left of the step"), accumulator, Sim::FixedStep * 0.25f, 1e-5f);
+
+	accumulator = 0.f;
+	TestEqual(TEXT("A hitch is capped"), Sim::ConsumeFixedSteps(accumulator, 1.f), (int)Sim::MaxSubsteps);
+	TestEqual(TEXT("A capped hitch is dropped"), accumulator, 0.f);
+
+	// a second of simulation is the same number of steps whatever the frame rate
+	for (float frameRate : { 30.f, 60.f, 144.f })
+	{
+		accumulator = 0.f;
+		int totalSteps = 0;
+
+		for (int frame = 0; frame < (int)frameRate; frame++)
+		{
+			totalSteps += Sim::ConsumeFixedSteps(accumulator, 1.f / frameRate);
+		}
+
+		TestTrue(*FString::Printf(TEXT("One second at %.0f fps runs a second of steps"), frameRate), FMath::Abs(totalSteps - 60) <= 1);
+	}
+
+	// slide
+
+	FSlideStepParams params;
+	params.SlopeAcceleration = 1500.f;
+	params.MaxSpeed = 1000.f;
+	params.MinSpeed = 100.f;
+
+	FVector velocity(500.f, 0.f, 0.f);
+	TestTrue(TEXT("Fast slide on flat ground keeps going"), Sim::StepSlide(velocity, FVector::UpVector, params));
+	TestEqual(TEXT("Flat ground doesn't change the slide"), velocity, FVector(500.f, 0.f, 0.f));
+
+	velocity = FVector(50.f, 0.f, 0.f);
+	TestFalse(TEXT("Slow slide stops"), Sim::StepSlide(velocity, FVector::UpVector, params));
+	TestTrue(TEXT("Stopped slide has no velocity"), velocity.IsZero());
+
+	// sloping down towards +X
+	const FVector slope = FVector(0.5f, 0.f, 1.f).GetSafeNormal();
+	velocity = FVector(500.f, 0.f, 0.f);
+	Sim::StepSlide(velocity, slope, params);
+	TestTrue(TEXT("Downhill slide speeds up"), velocity.X > 500.f);
+
+	velocity = FVector(999.f, 0.f, 0.f);
+	for (int i = 0; i < 60; i++)
+	{
+		Sim::StepSlide(velocity, slope, params);
+	}
+	TestTrue(TEXT("Slide is capped at the max speed"), velocity.Size() <= params.MaxSpeed + KINDA_SMALL_NUMBER);
+
+	// wall run
+
+	const FVector runDir(1.f, 0.f, 0.f);
+	TestEqual(TEXT("Wall on the left is to the left"), Sim::IntoWall(runDir, true, 100.f), FVector(0.f, -100.f, 0.f));
+	TestEqual(TEXT("Wall on the right is to the right"), Sim::IntoWall(runDir, false, 100.f), FVector(0.f, 100.f, 0.f));
+
+	const FVector wallVelocity = Sim::WallRunVelocity(FVector(0.6f, 0.f, 0.8f), 1000.f);
+	TestEqual(TEXT("Wall running never moves up or down"), wallVelocity.Z, 0.f);
+	TestEqual(TEXT("Wall running moves along the wall"), wallVelocity.X, 600.f, 1e-3f);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// settings for one step of the slide simulation
+struct FSlideStepParams
+{
+	// how strongly a slope pushes the player down it (cm/s^2 on a vertical slope)
+	float SlopeAcceleration;
+
+	// slide can't go faster than this
+	float MaxSpeed;
+
+	// slide stops once it gets slower than this
+	float MinSpeed;
+};
+
+/**
+ * The maths behind sliding and wall running, run at a fixed rate so the result doesn't depend on frame rate.
+ * Nothing in here touches the world or any actors so it can be stepped on its own for replays or tests.
+ */
+struct LAZERTAG_API FMovementSimulation
+{
+	// rate the slide and wall run simulation runs at
+	static constexpr float FixedStep = 1.f / 60.f;
+
+	// most steps that will be run in one frame, anything beyond this is dropped so a hitch can't snowball
+	static constexpr int MaxSubsteps = 8;
+
+	/*
+	* Adds frame time to an accumulator and works out how many fixed steps should be run.
+	* @param accumulator - leftover time from previous frames, updated in place
+	* @param deltaTime - time since the last call
+	* @returns int - number of fixed steps to run this frame
+	*/
+	static int ConsumeFixedSteps(float& accumulator, float deltaTime);
+
+	/*
+	* Gets the direction and magnitude of the slide direction. For instance this would return a larger vector if the floor was steeper.
+	* @param floorNormal - normal of the floor the player is standing on
+	* @returns FVector - The amount of influence the floor has on the player in vector form.
+	*/
+	static FVector FloorInfluence(const FVector& floorNormal);
+
+	/*
+	* Advances a slide by one fixed step.
+	* @param velocity - current velocity, updated in place
+	* @param floorNormal - normal of the floor the player is sliding on
+	* @param params - slide settings
+	* @returns bool - true: still sliding
+	*				  false: the slide got too slow, velocity has been zeroed
+	*/
+	static bool StepSlide(FVector& velocity, const FVector& floorNormal, const FSlideStepParams& params);
+
+	/*
+	* Gets a vector that points from the player into the wall they are running on.
+	* @param wallRunDir - direction the player is running along the wall
+	* @param bWallOnLeft - which side of the player the wall is on
+	* @param reach - length of the returned vector
+	*/
+	static FVector IntoWall(const FVector& wallRunDir, bool bWallOnLeft, float reach);
+
+	/*
+	* Velocity while wall running. Only moves along the wall and never up or down.
+	* @param wallRunDir - direction the player is running along the wall
+	* @param speed - how fast the player is running
+	*/
+	static FVector WallRunVelocity(const FVector& wallRunDir, float speed);
+};
@@ -2,18 +2,16 @@
 
 
 #include "PState.h"
+#include "PlayerProfileSubsystem.h"
 #include "Net/UnrealNetwork.h"
-#include "Kismet/GameplayStatics.h"
-#include "GameFramework/SaveGame.h"
-#include "SaveName.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/PlayerController.h"
 
 APState::APState()
 {
 	bReplicates = true;
-	/*if (USaveName* file = Cast<USaveName>(UGameplayStatics::LoadGameFromSlot(TEXT("Save0"), 0)))
-	{
-		playerName = file->savedName;
-	}*/
+
+	// the saved name is loaded in the background by UPlayerProfileSubsystem and sent up by the owner, see ApplyProfileName
 }
 
 void APState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
@@ -49,3 +47,74 @@ void APState::SetNameFromBlueprint(const FString& name)
 	SetPlayerName(name);
 }
 
+
+void APState::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// the host's own player state already has its controller here, remote clients wait for ClientInitialize
+	ApplyProfileName();
+}
+
+void APState::ClientInitialize(AController* C)
+{
+	Super::ClientInitialize(C);
+
+	ApplyProfileName();
+}
+
+void APState::ApplyProfileName()
+{
+	const APlayerController* controller = Cast<APlayerController>(GetOwner());
+
+	if (b_profileNameRequested || controller == nullptr || !controller->IsLocalController())
+		return;
+
+	UPlayerProfileSubsystem* profiles = GetGameInstance()->GetSubsystem<UPlayerProfileSubsystem>();
+
+	if (profiles == nullptr)
+		return;
+
+	b_profileNameRequested = true;
+
+	if (profiles->IsProfileLoaded())
+	{
+		OnProfileLoaded(profiles->GetProfile());
+	}
+	else
+	{
+		profiles->OnProfileLoaded.AddDynamic(this, &APState::OnProfileLoaded);
+	}
+}
+
+void APState::OnProfileLoaded(const FPlayerProfile& profile)
+{
+	if (UPlayerProfileSubsystem* profiles = GetGameInstance()->GetSubsystem<UPlayerProfileSubsystem>())
+	{
+		profiles->OnProfileLoaded.RemoveDynamic(this, &APState::OnProfileLoaded);
+	}
+
+	// no saved name keeps the online nickname
+	if (!profile.PlayerName.IsEmpty())
+	{
+		Server_SetProfileName(profile.PlayerName.Left(FPlayerProfile::MaxNameLength));
+	}
+}
+
+bool APState::Server_SetProfileName_Validate(const FString& name)
+{
+	// the owner's profile never holds a longer name, so only a modified client sends one
+	return name.Len() <= FPlayerProfile::MaxNameLength;
+}
+
+void APState::Server_SetProfileName_Implementation(const FString& name)
+{
+	FString trimmed = name.TrimStartAndEnd();
+
+	// keep the online nickname rather than showing nothing
+	if (trimmed.IsEmpty())
+		return;
+
+	playerName = trimmed;
+	SetPlayerName(trimmed);
+}
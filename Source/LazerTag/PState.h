@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerState.h"
+#include "PlayerProfile.h"
 #include "PState.generated.h"
 
 /**
@@ -36,6 +37,10 @@ public:
 	UFUNCTION(blueprintCallable)
 	void SetNameFromBlueprint(const FString& name);
 
+	virtual void BeginPlay() override;
+
+	virtual void ClientInitialize(AController* C) override;
+
 
 	//void CopyProperties(APlayerState* PlayerState)
 
@@ -48,5 +53,20 @@ protected:
 	UPROPERTY(replicated, visibleAnywhere, blueprintReadOnly)
 	int playerScore;
 
+	/* Sends the local player's profile name to the server once the profile has loaded. Only does anything on the owning machine. */
+	void ApplyProfileName();
+
+	UFUNCTION()
+	void OnProfileLoaded(const FPlayerProfile& profile);
+
+	/* Sets the name everyone sees to the one saved in the owner's profile */
+	UFUNCTION(reliable, server, withvalidation)
+	void Server_SetProfileName(const FString& name);
+	void Server_SetProfileName_Implementation(const FString& name);
+	bool Server_SetProfileName_Validate(const FString& name);
+
+	// the profile name has been asked for, stops the host doing it from both BeginPlay and ClientInitialize
+	bool b_profileNameRequested = false;
+
 	
 };
@@ -1,5 +1,6 @@
 #include "Pickup.h"
 #include "Net/UnrealNetwork.h"
+#include "GameplayEventLog.h"
 
 APickup::APickup()
 {
@@ -52,6 +53,8 @@ void APickup::Server_PickedUpBy(APawn* Pawn)
 		// store pawn that picked up the object on server side
 		pickupInsitgator = Pawn;
 
+		UGameplayEventLogSubsystem::Record(Pawn, EGameplayEventType::PICKUP);
+
 		// broadcast to clients of the pickup event
 		OnPickedUpBy(Pawn);
 	}
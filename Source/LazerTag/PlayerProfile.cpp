@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerProfile.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPlayerProfile, Log, All);
+
+// 'LTPF'
+static constexpr uint32 PlayerProfileMagic = 0x4650544C;
+
+void UPlayerProfileSave::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	uint32 magic = PlayerProfileMagic;
+	uint16 version = CurrentVersion;
+
+	Ar << magic;
+	Ar << version;
+
+	if (Ar.IsLoading() && (magic != PlayerProfileMagic || version > CurrentVersion))
+	{
+		UE_LOG(LogPlayerProfile, Warning, TEXT("Profile has an unknown layout (version %d), using defaults"), version);
+		Profile = FPlayerProfile();
+		Ar.SetError();
+		return;
+	}
+
+	// version 1
+	Ar << Profile.PlayerName;
+	Ar << Profile.LookSensitivity;
+	Ar << Profile.PreferredWeaponId;
+
+	// later versions read their extra fields here behind a version check so older files keep the defaults
+}
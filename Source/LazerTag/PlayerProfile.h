@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SaveGame.h"
+#include "PlayerProfile.generated.h"
+
+// everything saved about a player between sessions
+USTRUCT(blueprinttype)
+struct FPlayerProfile
+{
+	GENERATED_BODY()
+
+	// longest name a player can pick, anything longer is cut off
+	static constexpr int MaxNameLength = 32;
+
+	UPROPERTY(editAnywhere, blueprintReadWrite, category = "Profile")
+	FString PlayerName;
+
+	UPROPERTY(editAnywhere, blueprintReadWrite, category = "Profile")
+	float LookSensitivity = 1.f;
+
+	// last weapon picked, index into the weapon registry
+	UPROPERTY(editAnywhere, blueprintReadWrite, category = "Profile")
+	uint8 PreferredWeaponId = 0;
+
+	bool operator==(const FPlayerProfile& other) const
+	{
+		return PlayerName == other.PlayerName && LookSensitivity == other.LookSensitivity && PreferredWeaponId == other.PreferredWeaponId;
+	}
+
+	bool operator!=(const FPlayerProfile& other) const { return !(*this == other); }
+};
+
+/**
+ * Save game holding a player profile. The profile isn't a tagged property, it is written as a small versioned binary block
+ * so the file stays a few dozen bytes and loading doesn't have to match property names.
+ */
+UCLASS()
+class LAZERTAG_API UPlayerProfileSave : public USaveGame
+{
+	GENERATED_BODY()
+
+public:
+
+	// bump when fields are added to the end of the binary layout
+	static constexpr uint16 CurrentVersion = 1;
+
+	virtual void Serialize(FArchive& Ar) override;
+
+	FPlayerProfile Profile;
+};
@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerProfileSubsystem.h"
+#include "LazerTag.h"
+#include "SaveName.h"
+#include "Async/Async.h"
+#include "Engine/GameInstance.h"
+#include "Kismet/GameplayStatics.h"
+#include "TimerManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPlayerProfileSubsystem, Log, All);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Profile Saves"), STAT_ProfileSaves, STATGROUP_LazerTag);
+
+const FString UPlayerProfileSubsystem::SlotName = TEXT("Profile");
+
+// the slot the name used to be saved in by USaveName
+static const TCHAR* LegacySlotName = TEXT("Save0");
+
+// seconds to wait after a change before saving, so a burst of changes is written once
+static constexpr float ProfileSaveDelay = 2.f;
+
+bool UPlayerProfileSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// there is no local player to have a profile on a dedicated server
+	return !IsRunningDedicatedServer();
+}
+
+void UPlayerProfileSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	m_saveObject = NewObject<UPlayerProfileSave>(this);
+
+	UGameplayStatics::AsyncLoadGameFromSlot(SlotName, 0, FAsyncLoadGameFromSlotDelegate::CreateUObject(this, &UPlayerProfileSubsystem::OnProfileSlotLoaded));
+}
+
+void UPlayerProfileSubsystem::Deinitialize()
+{
+	GetGameInstance()->GetTimerManager().ClearTimer(m_saveTimer);
+
+	// a background write of the same slot has to finish first or the two writes race for the file
+	if (m_saveWrite.IsValid())
+	{
+		m_saveWrite.Wait();
+	}
+
+	b_saveInFlight = false;
+
+	// the game is closing so there's no time left to save in the background
+	if (b_loaded && b_dirty)
+	{
+		m_saveObject->Profile = m_profile;
+		UGameplayStatics::SaveGameToSlot(m_saveObject, SlotName, 0);
+		b_dirty = false;
+	}
+
+	Super::Deinitialize();
+}
+
+void UPlayerProfileSubsystem::OnProfileSlotLoaded(const FString& slotName, const int32 userIndex, USaveGame* saveGame)
+{
+	if (UPlayerProfileSave* save = Cast<UPlayerProfileSave>(saveGame))
+	{
+		// anything changed while loading wins over what was on disk
+		if (!b_dirty)
+		{
+			m_profile = save->Profile;
+		}
+
+		FinishLoading();
+		return;
+	}
+
+	// no profile yet, see if there's a name from before profiles existed
+	UGameplayStatics::AsyncLoadGameFromSlot(LegacySlotName, 0, FAsyncLoadGameFromSlotDelegate::CreateUObject(this, &UPlayerProfileSubsystem::OnLegacySlotLoaded));
+}
+
+void UPlayerProfileSubsystem::OnLegacySlotLoaded(const FString& slotName, const int32 userIndex, USaveGame* saveGame)
+{
+	if (USaveName* legacy = Cast<USaveName>(saveGame))
+	{
+		if (!b_dirty && !legacy->savedName.IsEmpty())
+		{
+			UE_LOG(LogPlayerProfileSubsystem, Log, TEXT("Moving the saved name from slot %s to the profile"), LegacySlotName);
+
+			m_profile.PlayerName = legacy->savedName.Left(FPlayerProfile::MaxNameLength);
+			b_dirty = true;
+		}
+	}
+
+	FinishLoading();
+}
+
+void UPlayerProfileSubsystem::FinishLoading()
+{
+	b_loaded = true;
+
+	// write anything that changed while the profile was loading
+	if (b_dirty)
+	{
+		MarkDirty();
+	}
+
+	OnProfileLoaded.Broadcast(m_profile);
+}
+
+void UPlayerProfileSubsystem::SetProfile(const FPlayerProfile& profile)
+{
+	if (profile == m_profile)
+		return;
+
+	m_profile = profile;
+
+	MarkDirty();
+}
+
+void UPlayerProfileSubsystem::SetPlayerName(const FString& name)
+{
+	FString trimmed = name.TrimStartAndEnd().Left(FPlayerProfile::MaxNameLength);
+
+	if (trimmed.IsEmpty() || trimmed == m_profile.PlayerName)
+		return;
+
+	m_profile.PlayerName = MoveTemp(trimmed);
+
+	MarkDirty();
+}
+
+void UPlayerProfileSubsystem::MarkDirty()
+{
+	b_dirty = true;
+
+	FTimerManager& timerManager = GetGameInstance()->GetTimerManager();
+
+	if (!timerManager.IsTimerActive(m_saveTimer))
+	{
+		timerManager.SetTimer(m_saveTimer, this, &UPlayerProfileSubsystem::SaveNow, ProfileSaveDelay, false);
+	}
+}
+
+void UPlayerProfileSubsystem::SaveNow()
+{
+	GetGameInstance()->GetTimerManager().ClearTimer(m_saveTimer);
+
+	// not loaded yet means FinishLoading will save, in flight means OnProfileSaved will
+	if (!b_dirty || !b_loaded || b_saveInFlight)
+		return;
+
+	m_saveObject->Profile = m_profile;
+
+	b_dirty = false;
+	b_saveInFlight = true;
+
+	INC_DWORD_STAT(STAT_ProfileSaves);
+
+	// the profile is serialized straight away, only the file write happens in the background.
+	// this is what AsyncSaveGameToSlot does, but keeping the future lets Deinitialize wait for the write
+	TArray<uint8> data;
+
+	if (!UGameplayStatics::SaveGameToMemory(m_saveObject, data))
+	{
+		OnProfileSaved(false);
+		return;
+	}
+
+	TWeakObjectPtr<UPlayerProfileSubsystem> weakThis(this);
+
+	m_saveWrite = Async(EAsyncExecution::ThreadPool, [weakThis, data = MoveTemp(data)]()
+	{
+		bool bSuccess = UGameplayStatics::SaveDataToSlot(data, SlotName, 0);
+
+		AsyncTask(ENamedThreads::GameThread, [weakThis, bSuccess]()
+		{
+			// a save that finished during shutdown has already been waited on
+			if (UPlayerProfileSubsystem* profiles = weakThis.Get())
+			{
+				if (profiles->b_saveInFlight)
+				{
+					profiles->OnProfileSaved(bSuccess);
+				}
+			}
+		});
+
+		return bSuccess;
+	});
+}
+
+void UPlayerProfileSubsystem::OnProfileSaved(bool bSuccess)
+{
+	b_saveInFlight = false;
+	m_saveWrite.Reset();
+
+	if (!bSuccess)
+	{
+		UE_LOG(LogPlayerProfileSubsystem, Warning, TEXT("Failed to save the profile to slot %s, will try again on the next change"), *SlotName);
+		b_dirty = true;
+		return;
+	}
+
+	// something changed while the save was being written
+	if (b_dirty)
+	{
+		MarkDirty();
+	}
+}
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "PlayerProfile.h"
+#include "Async/Future.h"
+#include "PlayerProfileSubsystem.generated.h"
+
+class USaveGame;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPlayerProfileLoaded, const FPlayerProfile&, Profile);
+
+/**
+ * Loads the local player's profile in the background when the game starts and keeps it for the whole session,
+ * so map travel never touches the disk. Changes mark the profile dirty and are written together a moment later
+ * instead of once per change.
+ * Profiles saved by the old USaveName slot are picked up and moved over the first time.
+ */
+UCLASS()
+class LAZERTAG_API UPlayerProfileSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	UFUNCTION(blueprintPure, category = "Profile")
+	bool IsProfileLoaded() const { return b_loaded; }
+
+	/* Gets the cached profile. Holds the defaults until the profile has loaded */
+	UFUNCTION(blueprintPure, category = "Profile")
+	const FPlayerProfile& GetProfile() const { return m_profile; }
+
+	/*
+	* Replaces the cached profile and schedules a save if anything changed.
+	* @param profile - the new profile
+	*/
+	UFUNCTION(blueprintCallable, category = "Profile")
+	void SetProfile(const FPlayerProfile& profile);
+
+	/*
+	* Changes the saved name, called by the main menu when the player renames themselves.
+	* @param name - the new name, trimmed and cut down to FPlayerProfile::MaxNameLength
+	*/
+	UFUNCTION(blueprintCallable, category = "Profile")
+	void SetPlayerName(const FString& name);
+
+	/* Writes the profile now if it has unsaved changes */
+	UFUNCTION(blueprintCallable, category = "Profile")
+	void SaveNow();
+
+	// called once the profile has loaded, or straight away with the defaults if there wasn't one
+	UPROPERTY(blueprintAssignable, category = "Profile")
+	FOnPlayerProfileLoaded OnProfileLoaded;
+
+	// slot the profile is saved in
+	static const FString SlotName;
+
+private:
+
+	void OnProfileSlotLoaded(const FString& slotName, const int32 userIndex, USaveGame* saveGame);
+
+	void OnLegacySlotLoaded(const FString& slotName, const int32 userIndex, USaveGame* saveGame);
+
+	void OnProfileSaved(bool bSuccess);
+
+	/* Marks the profile dirty and starts the save delay if one isn't already running */
+	void MarkDirty();
+
+	/* Finishes loading and tells anyone waiting */
+	void FinishLoading();
+
+	FPlayerProfile m_profile;
+
+	// reused for every save so the save game object isn't created each time
+	UPROPERTY()
+	UPlayerProfileSave* m_saveObject;
+
+	FTimerHandle m_saveTimer;
+
+	// the file write of the save in flight, waited on before the last save on shutdown writes the same slot
+	TFuture<bool> m_saveWrite;
+
+	bool b_loaded = false;
+
+	// changed since the last save started
+	bool b_dirty = false;
+
+	// only one save is written at a time, a change during a save is written after it
+	bool b_saveInFlight = false;
+};
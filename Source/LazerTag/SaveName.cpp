@@ -2,11 +2,4 @@
 
 
 #include "SaveName.h"
-#include "Net/UnrealNetwork.h"
 
-void USaveName::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
-{
-	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-
-	DOREPLIFETIME(USaveName, savedName);
-}
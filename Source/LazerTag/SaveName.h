@@ -7,7 +7,8 @@
 #include "SaveName.generated.h"
 
 /**
- * 
+ * Old save game that only held the player's name. Kept so existing saves can be read, UPlayerProfileSubsystem moves them
+ * into the player profile the first time the game runs. New names go through UPlayerProfileSubsystem::SetPlayerName.
  */
 UCLASS(blueprintable, blueprintType)
 class LAZERTAG_API USaveName : public USaveGame
@@ -15,10 +16,8 @@ class LAZERTAG_API USaveName : public USaveGame
 	GENERATED_BODY()
 
 public:
-	// required network setup
-	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& outLifetimeProps) const override;
 
-	UPROPERTY(replicated, editAnywhere, blueprintReadWrite)
+	UPROPERTY(editAnywhere, blueprintReadWrite)
 	FString savedName;
 	
 };
@@ -0,0 +1,237 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WallGeometry.h"
+#include "Math/VectorRegister.h"
+#include "Math/RandomStream.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogWallGeometry, Log, All);
+
+// anything smaller than this is treated as a zero length vector, same as FVector::Normalize
+static const float WallGeometryTolerance = SMALL_NUMBER;
+
+// loads four floats starting at an index, lanes past the end of the array are zero
+static FORCEINLINE VectorRegister LoadLanes(const TArray<float>& values, int start)
+{
+	if (start + 4 <= values.Num())
+	{
+		return VectorLoad(&values[start]);
+	}
+
+	float lanes[4] = { 0.f, 0.f, 0.f, 0.f };
+
+	for (int i = start; i < values.Num(); i++)
+	{
+		lanes[i - start] = values[i];
+	}
+
+	return VectorLoad(lanes);
+}
+
+void FWallHitBatch::Add(const FVector& normal, const FVector& right, float walkableFloorZ)
+{
+	NormalX.Add(normal.X);
+	NormalY.Add(normal.Y);
+	NormalZ.Add(normal.Z);
+	RightX.Add(right.X);
+	RightY.Add(right.Y);
+	WalkableFloorZ.Add(walkableFloorZ);
+}
+
+void FWallHitBatch::Reset()
+{
+	NormalX.Reset();
+	NormalY.Reset();
+	NormalZ.Reset();
+	RightX.Reset();
+	RightY.Reset();
+	WalkableFloorZ.Reset();
+}
+
+bool FWallGeometry::IsRunnable(const FVector& surfaceNormal, float walkableFloorZ)
+{
+	// the cosine of the angle to the horizontal is |horizontal part| / |normal|
+	// comparing squares against the squared threshold avoids the sqrt, normalize and Acos
+	float horizontalSq = surfaceNormal.X * surfaceNormal.X + surfaceNormal.Y * surfaceNormal.Y;
+	float lengthSq = horizontalSq + surfaceNormal.Z * surfaceNormal.Z;
+
+	return horizontalSq > walkableFloorZ * walkableFloorZ * lengthSq;
+}
+
+FVector FWallGeometry::RunDirection(const FVector& wallNormal, const FVector& right, bool& bOutWallOnLeft)
+{
+	float lengthSq = wallNormal.SizeSquared();
+
+	if (lengthSq < WallGeometryTolerance)
+	{
+		bOutWallOnLeft = true;
+		return FVector(0, 0, 0);
+	}
+
+	float invLength = FMath::InvSqrt(lengthSq);
+
+	bOutWallOnLeft = (wallNormal.X * right.X + wallNormal.Y * right.Y) >= 0.f;
+
+	// up x normal for a wall on the right, -up x normal for a wall on the left
+	float sign = bOutWallOnLeft ? -1.f : 1.f;
+
+	return FVector(-wallNormal.Y * invLength * sign, wallNormal.X * invLength * sign, 0.f);
+}
+
+FVector FWallGeometry::FloorInfluence(const FVector& floorNormal)
+{
+	// (n x (n x up)) has length |horizontal| * |n|, scaled by how much the floor faces up
+	float horizontalSq = floorNormal.X * floorNormal.X + floorNormal.Y * floorNormal.Y;
+	float lengthSq = horizontalSq + floorNormal.Z * floorNormal.Z;
+	float denomSq = horizontalSq * lengthSq;
+
+	if (denomSq < WallGeometryTolerance)
+	{
+		return FVector(0, 0, 0);
+	}
+
+	float scale = floorNormal.Z * FMath::InvSqrt(denomSq);
+
+	return FVector(floorNormal.Z * floorNormal.X, floorNormal.Z * floorNormal.Y, -horizontalSq) * scale;
+}
+
+void FWallGeometry::EvaluateWallHits(const FWallHitBatch& batch, TArray<FWallHitResult>& outResults)
+{
+	const int count = batch.Num();
+
+	outResults.SetNumUninitialized(count);
+
+	const VectorRegister tolerance = VectorSetFloat1(WallGeometryTolerance);
+	const VectorRegister zero = VectorZero();
+	const VectorRegister one = VectorOne();
+	const VectorRegister minusOne = VectorNegate(one);
+
+	for (int start = 0; start < count; start += 4)
+	{
+		VectorRegister nx = LoadLanes(batch.NormalX, start);
+		VectorRegister ny = LoadLanes(batch.NormalY, start);
+		VectorRegister nz = LoadLanes(batch.NormalZ, start);
+		VectorRegister rx = LoadLanes(batch.RightX, start);
+		VectorRegister ry = LoadLanes(batch.RightY, start);
+		VectorRegister walkableZ = LoadLanes(batch.WalkableFloorZ, start);
+		VectorRegister thresholdSq = VectorMultiply(walkableZ, walkableZ);
+
+		// runnable when |horizontal|^2 > cos^2 * |n|^2
+		VectorRegister horizontalSq = VectorMultiplyAdd(nx, nx, VectorMultiply(ny, ny));
+		VectorRegister lengthSq = VectorMultiplyAdd(nz, nz, horizontalSq);
+		int runnableMask = VectorMaskBits(VectorCompareGT(horizontalSq, VectorMultiply(thresholdSq, lengthSq)));
+
+		// side of the wall from the 2D dot product with the player's right vector
+		VectorRegister side = VectorMultiplyAdd(nx, rx, VectorMultiply(ny, ry));
+		VectorRegister onLeft = VectorCompareGE(side, zero);
+		int leftMask = VectorMaskBits(onLeft);
+
+		// direction along the wall, zero for lanes with no usable normal
+		VectorRegister valid = VectorCompareGT(lengthSq, tolerance);
+		VectorRegister invLength = VectorSelect(valid, VectorReciprocalSqrtAccurate(VectorMax(lengthSq, tolerance)), zero);
+		VectorRegister scale = VectorMultiply(invLength, VectorSelect(onLeft, minusOne, one));
+
+		float dirX[4];
+		float dirY[4];
+		VectorStore(VectorMultiply(VectorNegate(ny), scale), dirX);
+		VectorStore(VectorMultiply(nx, scale), dirY);
+
+		const int lanes = FMath::Min(4, count - start);
+
+		for (int lane = 0; lane < lanes; lane++)
+		{
+			FWallHitResult& result = outResults[start + lane];
+			result.RunDir = FVector(dirX[lane], dirY[lane], 0.f);
+			result.bRunnable = (runnableMask & (1 << lane)) != 0;
+			result.bWallOnLeft = (leftMask & (1 << lane)) != 0;
+		}
+	}
+}
+
+// checks the batch path against the single versions on random hits and times both
+static FAutoConsoleCommand BenchWallGeometryCommand(
+	TEXT("lt.BenchWallGeometry"),
+	TEXT("Checks the batched wall hit tests give the same results as the single ones and compares how long each takes."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const int numHits = 1024;
+		const int numRepeats = 100;
+
+		// fixed seed so every run tests the same hits
+		FRandomStream random(1234);
+
+		FWallHitBatch batch;
+		TArray<FVector> normals;
+		TArray<FVector> rights;
+
+		for (int i = 0; i < numHits; i++)
+		{
+			// every tenth normal is degenerate to cover the zero length case
+			FVector normal = (i % 10 == 0) ? FVector(0, 0, 0) : random.VRand() * random.FRandRange(0.5f, 2.f);
+			FVector right = FVector(random.FRandRange(-1.f, 1.f), random.FRandRange(-1.f, 1.f), 0.f).GetSafeNormal();
+			float walkableFloorZ = random.FRandRange(0.5f, 0.8f);
+
+			batch.Add(normal, right, walkableFloorZ);
+			normals.Add(normal);
+			rights.Add(right);
+		}
+
+		// compare the results
+		TArray<FWallHitResult> batchResults;
+		FWallGeometry::EvaluateWallHits(batch, batchResults);
+
+		int numMismatches = 0;
+
+		for (int i = 0; i < numHits; i++)
+		{
+			bool bWallOnLeft;
+			FVector runDir = FWallGeometry::RunDirection(normals[i], rights[i], bWallOnLeft);
+			bool bRunnable = FWallGeometry::IsRunnable(normals[i], batch.WalkableFloorZ[i]);
+
+			const FWallHitResult& result = batchResults[i];
+
+			if (result.bRunnable != bRunnable || result.bWallOnLeft != bWallOnLeft || !result.RunDir.Equals(runDir, KINDA_SMALL_NUMBER))
+			{
+				if (numMismatches++ < 8)
+				{
+					UE_LOG(LogWallGeometry, Warning, TEXT("Wall hit %d differs: normal %s, single %d %d %s, batch %d %d %s"), i, *normals[i].ToString(),
+						bRunnable, bWallOnLeft, *runDir.ToString(), result.bRunnable, result.bWallOnLeft, *result.RunDir.ToString());
+				}
+			}
+		}
+
+		// time both, the sums are logged so the loops can't be optimized away
+		float singleSum = 0.f;
+		double singleStart = FPlatformTime::Seconds();
+
+		for (int repeat = 0; repeat < numRepeats; repeat++)
+		{
+			for (int i = 0; i < numHits; i++)
+			{
+				bool bWallOnLeft;
+				FVector runDir = FWallGeometry::RunDirection(normals[i], rights[i], bWallOnLeft);
+				singleSum += FWallGeometry::IsRunnable(normals[i], batch.WalkableFloorZ[i]) ? runDir.X : runDir.Y;
+			}
+		}
+
+		double singleSeconds = FPlatformTime::Seconds() - singleStart;
+
+		float batchSum = 0.f;
+		double batchStart = FPlatformTime::Seconds();
+
+		for (int repeat = 0; repeat < numRepeats; repeat++)
+		{
+			FWallGeometry::EvaluateWallHits(batch, batchResults);
+
+			for (const FWallHitResult& result : batchResults)
+			{
+				batchSum += result.bRunnable ? result.RunDir.X : result.RunDir.Y;
+			}
+		}
+
+		double batchSeconds = FPlatformTime::Seconds() - batchStart;
+
+		UE_LOG(LogWallGeometry, Log, TEXT("%d wall hits x %d: %d mismatches, single %.3f ms (%f), batch %.3f ms (%f)"),
+			numHits, numRepeats, numMismatches, singleSeconds * 1000.0, singleSum, batchSeconds * 1000.0, batchSum);
+	}));
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// outcome of testing one surface hit for wall running
+struct FWallHitResult
+{
+	// direction the player would run along the wall
+	FVector RunDir;
+
+	// the surface is steep enough to be run on
+	bool bRunnable;
+
+	// the wall is on the player's left
+	bool bWallOnLeft;
+};
+
+/**
+ * Surface hits waiting to be tested, stored as separate component arrays so four can be loaded into one vector register.
+ */
+struct FWallHitBatch
+{
+	TArray<float> NormalX;
+	TArray<float> NormalY;
+	TArray<float> NormalZ;
+
+	// player's right vector when the hit happened, only X and Y matter
+	TArray<float> RightX;
+	TArray<float> RightY;
+
+	// cosine of the walkable floor angle of the character that hit the surface
+	TArray<float> WalkableFloorZ;
+
+	void Add(const FVector& normal, const FVector& right, float walkableFloorZ);
+
+	void Reset();
+
+	int Num() const { return NormalX.Num(); }
+};
+
+/**
+ * Wall running and sliding geometry without any trig.
+ * Angles are compared through their cosines so a precomputed threshold (the movement component's walkable floor Z) replaces Acos.
+ * The batch version evaluates four surfaces per vector register and gives the same answers as the single versions,
+ * lt.BenchWallGeometry checks this and times both.
+ */
+struct LAZERTAG_API FWallGeometry
+{
+	/*
+	* Determines if a surface can be wall run.
+	* @param surfaceNormal - normal of the surface that the player has collided with, does not need to be normalized
+	* @param walkableFloorZ - cosine of the walkable floor angle
+	* @returns bool - true: the angle between the surface and the horizontal is below the walkable angle
+	*				  false: the surface is not steep enough to be considered a runnable wall
+	*/
+	static bool IsRunnable(const FVector& surfaceNormal, float walkableFloorZ);
+
+	/*
+	* Works out which side the wall is on and which way the player should run along it.
+	* @param wallNormal - normal of the wall, does not need to be normalized
+	* @param right - the player's right vector
+	* @param bOutWallOnLeft - set to which side of the player the wall is on
+	* @returns FVector - the direction to travel along the wall
+	*/
+	static FVector RunDirection(const FVector& wallNormal, const FVector& right, bool& bOutWallOnLeft);
+
+	/*
+	* Gets the direction and magnitude a floor pushes a sliding player. Steeper floors give larger vectors.
+	* @param floorNormal - normal of the floor
+	*/
+	static FVector FloorInfluence(const FVector& floorNormal);
+
+	/*
+	* Tests every hit in a batch at once.
+	* @param batch - hits to test
+	* @param outResults - one result per hit in the same order
+	*/
+	static void EvaluateWallHits(const FWallHitBatch& batch, TArray<FWallHitResult>& outResults);
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WallRunSubsystem.h"
+#include "LazerTag.h"
+#include "LazerTagCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Wall Hit Batch"), STAT_WallHitBatch, STATGROUP_LazerTag);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wall Hits Evaluated"), STAT_WallHitsEvaluated, STATGROUP_LazerTag);
+
+bool UWallRunSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* world = Cast<UWorld>(Outer);
+
+	return world != nullptr && world->IsGameWorld();
+}
+
+void UWallRunSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	b_initialized = true;
+}
+
+void UWallRunSubsystem::Deinitialize()
+{
+	b_initialized = false;
+
+	m_pendingCharacters.Empty();
+	m_pendingHits.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UWallRunSubsystem::IsTickable() const
+{
+	// the class default object is also a tickable object so it has to be filtered out
+	return b_initialized && !IsTemplate();
+}
+
+TStatId UWallRunSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UWallRunSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UWallRunSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UWallRunSubsystem::QueueWallHit(ALazerTagCharacter* character, const FVector& impactNormal)
+{
+	if (character == nullptr)
+		return;
+
+	FVector right = character->GetActorRightVector();
+	float walkableFloorZ = character->GetCharacterMovement()->GetWalkableFloorZ();
+
+	// only the latest hit matters, replace an earlier one from this frame
+	int index = m_pendingCharacters.Find(character);
+
+	if (index != INDEX_NONE)
+	{
+		m_pendingHits.NormalX[index] = impactNormal.X;
+		m_pendingHits.NormalY[index] = impactNormal.Y;
+		m_pendingHits.NormalZ[index] = impactNormal.Z;
+		m_pendingHits.RightX[index] = right.X;
+		m_pendingHits.RightY[index] = right.Y;
+		m_pendingHits.WalkableFloorZ[index] = walkableFloorZ;
+		return;
+	}
+
+	m_pendingCharacters.Add(character);
+	m_pendingHits.Add(impactNormal, right, walkableFloorZ);
+}
+
+void UWallRunSubsystem::Tick(float DeltaTime)
+{
+	if (m_pendingCharacters.Num() == 0)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_WallHitBatch);
+	INC_DWORD_STAT_BY(STAT_WallHitsEvaluated, m_pendingCharacters.Num());
+
+	FWallGeometry::EvaluateWallHits(m_pendingHits, m_results);
+
+	for (int i = 0; i < m_pendingCharacters.Num(); i++)
+	{
+		ALazerTagCharacter* character = m_pendingCharacters[i];
+
+		if (character != nullptr && !character->IsPendingKill())
+		{
+			character->ApplyWallHit(m_results[i]);
+		}
+	}
+
+	m_pendingCharacters.Reset();
+	m_pendingHits.Reset();
+}
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "WallGeometry.h"
+#include "WallRunSubsystem.generated.h"
+
+class ALazerTagCharacter;
+
+/**
+ * Collects the surface hits every character reports during a frame and tests them for wall running all at once.
+ * Only the latest hit per character is kept, so a character scraping along a wall is tested once a frame
+ * no matter how many hit events it gets.
+ */
+UCLASS()
+class LAZERTAG_API UWallRunSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	// End of FTickableGameObject interface
+
+	/*
+	* Queues a surface hit to be tested at the end of the frame.
+	* @param character - the character that hit the surface
+	* @param impactNormal - normal of the surface
+	*/
+	void QueueWallHit(ALazerTagCharacter* character, const FVector& impactNormal);
+
+private:
+
+	// characters waiting on a result, in the same order as m_pendingHits
+	UPROPERTY()
+	TArray<ALazerTagCharacter*> m_pendingCharacters;
+
+	FWallHitBatch m_pendingHits;
+
+	TArray<FWallHitResult> m_results;
+
+	bool b_initialized = false;
+};
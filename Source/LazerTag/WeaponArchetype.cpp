@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponArchetype.h"
+#include "LazerTagProjectile.h"
+#include "LazerTag_GI.h"
+#include "Engine/World.h"
+
+UWeaponArchetype::UWeaponArchetype()
+{
+	ProjectileClass = ALazerTagProjectile::StaticClass();
+}
+
+FPrimaryAssetId UWeaponArchetype::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(TEXT("WeaponArchetype"), GetFName());
+}
+
+void UWeaponArchetype::GetCosmeticAssets(TArray<FSoftObjectPath>& outAssets) const
+{
+	outAssets.Add(FireSound.ToSoftObjectPath());
+	outAssets.Add(FireAnimation.ToSoftObjectPath());
+}
+
+const UWeaponArchetype* UWeaponRegistry::Find(const UObject* worldContext, uint8 weaponId)
+{
+	if (const UWeaponArchetype* weapon = FindRegistered(worldContext, weaponId))
+	{
+		return weapon;
+	}
+
+	// the class defaults match the original hard-coded weapon
+	return GetDefault<UWeaponArchetype>();
+}
+
+const UWeaponArchetype* UWeaponRegistry::FindRegistered(const UObject* worldContext, uint8 weaponId)
+{
+	const UWorld* world = (worldContext != nullptr) ? worldContext->GetWorld() : nullptr;
+	const ULazerTag_GI* gameInstance = (world != nullptr) ? world->GetGameInstance<ULazerTag_GI>() : nullptr;
+
+	if (gameInstance != nullptr && gameInstance->WeaponRegistry != nullptr)
+	{
+		const TArray<UWeaponArchetype*>& weapons = gameInstance->WeaponRegistry->Weapons;
+
+		if (weapons.IsValidIndex(weaponId) && weapons[weaponId] != nullptr)
+		{
+			return weapons[weaponId];
+		}
+	}
+
+	return nullptr;
+}
+
+void UWeaponRegistry::GetCosmeticAssets(TArray<FSoftObjectPath>& outAssets) const
+{
+	for (const UWeaponArchetype* weapon : Weapons)
+	{
+		if (weapon != nullptr)
+		{
+			weapon->GetCosmeticAssets(outAssets);
+		}
+	}
+}
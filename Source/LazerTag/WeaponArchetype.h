@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "WeaponArchetype.generated.h"
+
+class ALazerTagProjectile;
+class UAnimMontage;
+class USoundBase;
+
+// how a weapon delivers its shots
+UENUM(blueprinttype)
+enum class EWeaponFireMode : uint8
+{
+	PROJECTILE = 0		UMETA(DisplayName = "PROJECTILE"),
+	HITSCAN				UMETA(DisplayName = "HITSCAN"),
+};
+
+/**
+ * Everything that describes one kind of weapon. Archetypes are loaded once with the weapon registry and never changed at runtime,
+ * so every character and projectile using a weapon reads the same instance through its weapon ID.
+ */
+UCLASS(blueprinttype)
+class LAZERTAG_API UWeaponArchetype : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	UWeaponArchetype();
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/* Adds the sounds and montages this weapon plays */
+	void GetCosmeticAssets(TArray<FSoftObjectPath>& outAssets) const;
+
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Firing")
+	EWeaponFireMode FireMode = EWeaponFireMode::PROJECTILE;
+
+	// shots fired per trigger pull, more than one makes a spread weapon
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Firing", meta = (ClampMin = "1", ClampMax = "16"))
+	int ShotsPerFire = 1;
+
+	// half angle of the cone each shot is randomly fired within
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Firing", meta = (ClampMin = "0.0", ClampMax = "45.0"))
+	float SpreadDegrees = 0.f;
+
+	// gun muzzle's offset from the character's location, in camera space
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Firing")
+	FVector GunOffset = FVector(100.0f, 0.0f, 10.0f);
+
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Projectile")
+	TSubclassOf<ALazerTagProjectile> ProjectileClass;
+
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Projectile")
+	float ProjectileSpeed = 3000.f;
+
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Projectile")
+	float ProjectileMaxSpeed = 3000.f;
+
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Projectile")
+	float ProjectileLifeSpan = 3.f;
+
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Projectile")
+	bool bProjectileBounces = true;
+
+	// how far a hitscan shot reaches
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Hitscan")
+	float HitscanRange = 10000.f;
+
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Score")
+	int ScorePerHit = 5;
+
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Cosmetics")
+	TSoftObjectPtr<USoundBase> FireSound;
+
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Cosmetics")
+	TSoftObjectPtr<UAnimMontage> FireAnimation;
+};
+
+/**
+ * The list of weapons in the game. A weapon's ID is its index in the list, which is what gets stored and replicated.
+ * The registry is referenced by the game instance so it and every archetype are loaded once at startup.
+ */
+UCLASS(blueprinttype)
+class LAZERTAG_API UWeaponRegistry : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/*
+	* Looks up a weapon by ID.
+	* @param worldContext - any object in the world, used to find the game instance
+	* @param weaponId - index into the registry
+	* @returns the archetype, or the default archetype if the ID or the registry is missing
+	*/
+	static const UWeaponArchetype* Find(const UObject* worldContext, uint8 weaponId);
+
+	/*
+	* Looks up a weapon by ID without falling back to the default archetype.
+	* @param worldContext - any object in the world, used to find the game instance
+	* @param weaponId - index into the registry
+	* @returns the archetype, or null if the ID or the registry is missing
+	*/
+	static const UWeaponArchetype* FindRegistered(const UObject* worldContext, uint8 weaponId);
+
+	/* Adds the sounds and montages of every weapon */
+	void GetCosmeticAssets(TArray<FSoftObjectPath>& outAssets) const;
+
+	// ordered list of weapons, the index is the weapon ID so only ever add to the end
+	UPROPERTY(editDefaultsOnly, blueprintReadOnly, category = "Weapons")
+	TArray<UWeaponArchetype*> Weapons;
+};